@@ -1,5 +1,7 @@
 @echo off
 mkdir build
 pushd build
-cl ..\examples.c
+cl ..\pmk_phash_gen.c
+pmk_phash_gen.exe http_keyword ..\http_keywords.txt > http_keywords.h
+cl /I. ..\examples.c
 popd
@@ -0,0 +1,91 @@
+// Generated by pmk_phash_gen from http_keywords.txt; do not edit.
+
+enum {
+    HTTP_KEYWORD_GET,
+    HTTP_KEYWORD_HEAD,
+    HTTP_KEYWORD_POST,
+    HTTP_KEYWORD_PUT,
+    HTTP_KEYWORD_DELETE,
+    HTTP_KEYWORD_CONNECT,
+    HTTP_KEYWORD_OPTIONS,
+    HTTP_KEYWORD_TRACE,
+    HTTP_KEYWORD_PATCH,
+    HTTP_KEYWORD_ACCEPT,
+    HTTP_KEYWORD_ACCEPT_ENCODING,
+    HTTP_KEYWORD_ACCEPT_LANGUAGE,
+    HTTP_KEYWORD_AUTHORIZATION,
+    HTTP_KEYWORD_CACHE_CONTROL,
+    HTTP_KEYWORD_CONNECTION,
+    HTTP_KEYWORD_CONTENT_ENCODING,
+    HTTP_KEYWORD_CONTENT_LENGTH,
+    HTTP_KEYWORD_CONTENT_TYPE,
+    HTTP_KEYWORD_COOKIE,
+    HTTP_KEYWORD_DATE,
+    HTTP_KEYWORD_ETAG,
+    HTTP_KEYWORD_HOST,
+    HTTP_KEYWORD_IF_MODIFIED_SINCE,
+    HTTP_KEYWORD_IF_NONE_MATCH,
+    HTTP_KEYWORD_LAST_MODIFIED,
+    HTTP_KEYWORD_LOCATION,
+    HTTP_KEYWORD_ORIGIN,
+    HTTP_KEYWORD_RANGE,
+    HTTP_KEYWORD_REFERER,
+    HTTP_KEYWORD_SERVER,
+    HTTP_KEYWORD_SET_COOKIE,
+    HTTP_KEYWORD_TRANSFER_ENCODING,
+    HTTP_KEYWORD_UPGRADE,
+    HTTP_KEYWORD_USER_AGENT,
+    HTTP_KEYWORD_COUNT
+};
+
+static const u32 http_keyword_displacements[17] = {
+    0, 1, 10, 5, 4, 0, 8, 11,
+    0, 4, 1, 23, 28, 5, 17, 0,
+    15
+};
+
+static const struct { String keyword; s32 id; } http_keyword_table[34] = {
+    { str_lit_const("OPTIONS"), HTTP_KEYWORD_OPTIONS },
+    { str_lit_const("Range"), HTTP_KEYWORD_RANGE },
+    { str_lit_const("Connection"), HTTP_KEYWORD_CONNECTION },
+    { str_lit_const("Accept-Encoding"), HTTP_KEYWORD_ACCEPT_ENCODING },
+    { str_lit_const("If-None-Match"), HTTP_KEYWORD_IF_NONE_MATCH },
+    { str_lit_const("Origin"), HTTP_KEYWORD_ORIGIN },
+    { str_lit_const("Host"), HTTP_KEYWORD_HOST },
+    { str_lit_const("Location"), HTTP_KEYWORD_LOCATION },
+    { str_lit_const("Server"), HTTP_KEYWORD_SERVER },
+    { str_lit_const("Transfer-Encoding"), HTTP_KEYWORD_TRANSFER_ENCODING },
+    { str_lit_const("Accept"), HTTP_KEYWORD_ACCEPT },
+    { str_lit_const("GET"), HTTP_KEYWORD_GET },
+    { str_lit_const("Authorization"), HTTP_KEYWORD_AUTHORIZATION },
+    { str_lit_const("PATCH"), HTTP_KEYWORD_PATCH },
+    { str_lit_const("CONNECT"), HTTP_KEYWORD_CONNECT },
+    { str_lit_const("Upgrade"), HTTP_KEYWORD_UPGRADE },
+    { str_lit_const("TRACE"), HTTP_KEYWORD_TRACE },
+    { str_lit_const("Content-Length"), HTTP_KEYWORD_CONTENT_LENGTH },
+    { str_lit_const("Cookie"), HTTP_KEYWORD_COOKIE },
+    { str_lit_const("POST"), HTTP_KEYWORD_POST },
+    { str_lit_const("PUT"), HTTP_KEYWORD_PUT },
+    { str_lit_const("Last-Modified"), HTTP_KEYWORD_LAST_MODIFIED },
+    { str_lit_const("Date"), HTTP_KEYWORD_DATE },
+    { str_lit_const("Accept-Language"), HTTP_KEYWORD_ACCEPT_LANGUAGE },
+    { str_lit_const("ETag"), HTTP_KEYWORD_ETAG },
+    { str_lit_const("Set-Cookie"), HTTP_KEYWORD_SET_COOKIE },
+    { str_lit_const("User-Agent"), HTTP_KEYWORD_USER_AGENT },
+    { str_lit_const("HEAD"), HTTP_KEYWORD_HEAD },
+    { str_lit_const("Content-Type"), HTTP_KEYWORD_CONTENT_TYPE },
+    { str_lit_const("DELETE"), HTTP_KEYWORD_DELETE },
+    { str_lit_const("Cache-Control"), HTTP_KEYWORD_CACHE_CONTROL },
+    { str_lit_const("Referer"), HTTP_KEYWORD_REFERER },
+    { str_lit_const("Content-Encoding"), HTTP_KEYWORD_CONTENT_ENCODING },
+    { str_lit_const("If-Modified-Since"), HTTP_KEYWORD_IF_MODIFIED_SINCE },
+};
+
+// id of s among the keywords, or -1
+static s32
+http_keyword_lookup(String s)
+{
+    u64 h = string_hash(s);
+    u32 i = phash_index(h, http_keyword_displacements[(u32) h % 17u], 34u);
+    return string_equal(s, http_keyword_table[i].keyword) ? http_keyword_table[i].id : -1;
+}
@@ -9,6 +9,9 @@
 #define PMK_REALLOC(c,p,os,ns) arena_realloc_into(c,p,os,ns)
 #include "pmk_string.h"
 
+// generated from http_keywords.txt by pmk_phash_gen
+#include "http_keywords.h"
+
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -205,10 +208,47 @@ example12()
     builder_destroy(&builder);
 }
 
+static void
+example13()
+{
+    String tokens[] = {
+        str_lit("Content-Type"),
+        str_lit("POST"),
+        str_lit("X-Forwarded-For"),
+        str_lit("Host"),
+    };
+    printf("Example13:");
+    for (s32 i = 0; i < NELEMS(tokens); i++) {
+        s32 id = http_keyword_lookup(tokens[i]);
+        printf(" %.*s=%d", len_data(tokens[i]), id);
+    }
+    printf(" (of %d keywords)\n", HTTP_KEYWORD_COUNT);
+}
+
+#if PMK_STRING_TEST
+static void
+http_keyword_test()
+{
+    for (s32 i = 0; i < HTTP_KEYWORD_COUNT; i++) {
+        String keyword = http_keyword_table[i].keyword;
+        assert(http_keyword_lookup(keyword) == http_keyword_table[i].id);
+    }
+    assert(HTTP_KEYWORD_COUNT == NELEMS(http_keyword_table));
+    assert(http_keyword_lookup(str_lit("GET")) == HTTP_KEYWORD_GET);
+    assert(http_keyword_lookup(str_lit("Content-Length")) == HTTP_KEYWORD_CONTENT_LENGTH);
+    assert(http_keyword_lookup(str_lit("User-Agent")) == HTTP_KEYWORD_USER_AGENT);
+    assert(http_keyword_lookup(str_lit("get")) == -1);
+    assert(http_keyword_lookup(str_lit("GETS")) == -1);
+    assert(http_keyword_lookup(str_lit("")) == -1);
+    assert(http_keyword_lookup(str_lit("X-Forwarded-For")) == -1);
+}
+#endif
+
 int main()
 {
 #if PMK_STRING_TEST
     pmk_string_test();
+    http_keyword_test();
     fprintf(stderr, "All tests passed.\n");
 #else
     example1();
@@ -223,6 +263,7 @@ int main()
     //example10();
     example11();
     example12();
+    example13();
 #endif
 
     arena_destroy(&default_arena);
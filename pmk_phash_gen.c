@@ -0,0 +1,231 @@
+// Generates a minimal perfect hash lookup for a fixed list of keywords.
+//
+//     pmk_phash_gen NAME KEYWORDS_FILE > NAME.h
+//
+// KEYWORDS_FILE has one keyword per line; blank lines and lines starting
+// with '#' are skipped. The header defines NAME_COUNT and an id NAME_<KEYWORD>
+// for each keyword (in list order, upper-cased, other characters replaced
+// by '_'; keywords whose ids would clash with each other or with NAME_COUNT
+// are rejected) and
+//
+//     static s32 NAME_lookup(String s);
+//
+// which returns the id of s or -1, using one string_hash(), one probe of a
+// table of exactly NAME_COUNT entries and one string_equal(). The keys are
+// split into buckets by hash; each bucket gets a displacement, found here by
+// trial, that sends its keys to free slots (hash and displace, as in CHD).
+// The header needs pmk_string.h.
+
+#define _POSIX_C_SOURCE 1
+
+#define PMK_STRING_IMPL
+#include "pmk_string.h"
+
+#include <ctype.h>
+#include <stdlib.h>
+
+typedef struct {
+    String keyword;
+    u64 hash;
+    u32 bucket;
+} Key;
+
+static u32 nbuckets;
+
+// buckets with more keys are placed first, while the table is emptier
+static s32 * bucket_sizes;
+
+static int
+bucket_order(const void * a, const void * b)
+{
+    u32 x = *(const u32 *) a, y = *(const u32 *) b;
+    if (bucket_sizes[x] != bucket_sizes[y])
+        return bucket_sizes[y] - bucket_sizes[x];
+    return (x > y) - (x < y);
+}
+
+static void
+die(const char * msg, String detail)
+{
+    fprintf(stderr, "pmk_phash_gen: %s%.*s\n", msg, len_data(detail));
+    exit(1);
+}
+
+// the character standing for c in a keyword's identifier
+static int
+identifier_char(char c)
+{
+    return isalnum((unsigned char) c) ? toupper((unsigned char) c) : '_';
+}
+
+// whether two keywords would get the same identifier
+static int
+identifier_equal(String a, String b)
+{
+    if (a.len != b.len)
+        return 0;
+    for (s32 i = 0; i < a.len; i++) {
+        if (identifier_char(a.data[i]) != identifier_char(b.data[i]))
+            return 0;
+    }
+    return 1;
+}
+
+static void
+print_identifier(const char * prefix, String keyword)
+{
+    for (const char * p = prefix; *p; p++)
+        putchar(toupper((unsigned char) *p));
+    putchar('_');
+    for (s32 i = 0; i < keyword.len; i++)
+        putchar(identifier_char(keyword.data[i]));
+}
+
+static void
+print_literal(String keyword)
+{
+    putchar('"');
+    for (s32 i = 0; i < keyword.len; i++) {
+        unsigned char c = (unsigned char) keyword.data[i];
+        if (c == '"' || c == '\\')
+            printf("\\%c", c);
+        else if (isprint(c))
+            putchar(c);
+        else
+            printf("\\%03o", c);
+    }
+    putchar('"');
+}
+
+int
+main(int argc, char ** argv)
+{
+    if (argc != 3) {
+        fprintf(stderr, "usage: pmk_phash_gen NAME KEYWORDS_FILE\n");
+        return 1;
+    }
+    const char * name = argv[1];
+    StringBuilder text = {0};
+    if (builder_read_file(&text, argv[2]) != 0)
+        die("cannot read ", str_cstr(argv[2]));
+
+    s32 cap = string_count(builder_to_string(text), '\n') + 1;
+    Key * keys = malloc(cap * sizeof(Key));
+    s32 n = 0;
+    String rest = builder_to_string(text);
+    for (s32 start = 0; start <= rest.len; ) {
+        s32 end = start;
+        while (end < rest.len && rest.data[end] != '\n')
+            end++;
+        String line = string_trim(string_substr(rest, start, end));
+        start = end + 1;
+        if (line.len == 0 || line.data[0] == '#')
+            continue;
+        keys[n].keyword = line;
+        keys[n].hash = string_hash(line);
+        if (identifier_equal(line, str_lit("COUNT")))
+            die("identifier clashes with the COUNT sentinel: ", line);
+        for (s32 i = 0; i < n; i++) {
+            if (string_equal(keys[i].keyword, line))
+                die("duplicate keyword ", line);
+            if (identifier_equal(keys[i].keyword, line))
+                die("identifier clash on ", line);
+            if (keys[i].hash == keys[n].hash)
+                die("hash collision on ", line);
+        }
+        n++;
+    }
+    if (n == 0)
+        die("no keywords in ", str_cstr(argv[2]));
+
+    // about two keys per bucket keeps the displacement search short
+    nbuckets = (u32) (n + 1) / 2;
+    bucket_sizes = calloc(nbuckets, sizeof(s32));
+    for (s32 i = 0; i < n; i++) {
+        keys[i].bucket = (u32) keys[i].hash % nbuckets;
+        bucket_sizes[keys[i].bucket]++;
+    }
+    u32 * order = malloc(nbuckets * sizeof(u32));
+    for (u32 b = 0; b < nbuckets; b++)
+        order[b] = b;
+    qsort(order, nbuckets, sizeof(u32), bucket_order);
+
+    u32 * displacements = calloc(nbuckets, sizeof(u32));
+    s32 * slot_key = malloc(n * sizeof(s32));
+    for (s32 i = 0; i < n; i++)
+        slot_key[i] = -1;
+    s32 * members = malloc(n * sizeof(s32));
+    u32 * slots = malloc(n * sizeof(u32));
+    for (u32 o = 0; o < nbuckets && bucket_sizes[order[o]] > 0; o++) {
+        u32 b = order[o];
+        s32 m = 0;
+        for (s32 i = 0; i < n; i++) {
+            if (keys[i].bucket == b)
+                members[m++] = i;
+        }
+        u32 d = 0;
+        for (;; d++) {
+            if (d == 1u << 24)
+                die("no displacement found for bucket of ", keys[members[0]].keyword);
+            s32 j = 0;
+            for (; j < m; j++) {
+                slots[j] = phash_index(keys[members[j]].hash, d, (u32) n);
+                if (slot_key[slots[j]] >= 0)
+                    break;
+                s32 k = 0;
+                while (k < j && slots[k] != slots[j])
+                    k++;
+                if (k < j)
+                    break;
+            }
+            if (j == m)
+                break;
+        }
+        displacements[b] = d;
+        for (s32 j = 0; j < m; j++)
+            slot_key[slots[j]] = members[j];
+    }
+
+    printf("// Generated by pmk_phash_gen from %s; do not edit.\n\n", argv[2]);
+    printf("enum {\n");
+    for (s32 i = 0; i < n; i++) {
+        printf("    ");
+        print_identifier(name, keys[i].keyword);
+        printf(",\n");
+    }
+    printf("    ");
+    print_identifier(name, str_lit("COUNT"));
+    printf("\n};\n\n");
+
+    printf("static const u32 %s_displacements[%u] = {", name, nbuckets);
+    for (u32 b = 0; b < nbuckets; b++)
+        printf("%s%u", b == 0 ? "\n    " : b % 8 ? ", " : ",\n    ", displacements[b]);
+    printf("\n};\n\n");
+
+    printf("static const struct { String keyword; s32 id; } %s_table[%d] = {\n", name, n);
+    for (s32 i = 0; i < n; i++) {
+        printf("    { str_lit_const(");
+        print_literal(keys[slot_key[i]].keyword);
+        printf("), ");
+        print_identifier(name, keys[slot_key[i]].keyword);
+        printf(" },\n");
+    }
+    printf("};\n\n");
+
+    printf("// id of s among the keywords, or -1\n");
+    printf("static s32\n%s_lookup(String s)\n{\n", name);
+    printf("    u64 h = string_hash(s);\n");
+    printf("    u32 i = phash_index(h, %s_displacements[(u32) h %% %uu], %du);\n", name, nbuckets, n);
+    printf("    return string_equal(s, %s_table[i].keyword) ? %s_table[i].id : -1;\n", name, name);
+    printf("}\n");
+
+    free(slots);
+    free(members);
+    free(slot_key);
+    free(displacements);
+    free(order);
+    free(bucket_sizes);
+    free(keys);
+    builder_destroy(&text);
+    return 0;
+}
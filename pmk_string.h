@@ -312,8 +312,679 @@ void    builder_append_context      (void * context, StringBuilder * builder, St
 int     builder_print_context       (void * context, StringBuilder * builder, const char * fmt, ...);
 int     builder_replace_context     (void * context, StringBuilder * builder, String x, String y);
 void    builder_splice_context      (void * context, StringBuilder * builder, s32 start, s32 end, String string);
+// appends the next line of fp without its '\n'; at EOF nothing is appended
 int     builder_getline_context     (void * context, StringBuilder * builder, FILE * fp);
 int     builder_read_file_context   (void * context, StringBuilder * builder, const char * filename);
+void    builder_consume             (StringBuilder * builder, s32 n);
+
+#define builder_append_int(B,N)             builder_append_int_context          (NULL, B, N)
+#define builder_append_resp_simple(B,STR)   builder_append_resp_simple_context  (NULL, B, STR)
+#define builder_append_resp_error(B,STR)    builder_append_resp_error_context   (NULL, B, STR)
+#define builder_append_resp_int(B,N)        builder_append_resp_int_context     (NULL, B, N)
+#define builder_append_resp_bulk(B,STR)     builder_append_resp_bulk_context    (NULL, B, STR)
+#define builder_append_resp_null(B)         builder_append_resp_null_context    (NULL, B)
+#define builder_append_resp_array(B,N)      builder_append_resp_array_context   (NULL, B, N)
+#define builder_append_netstring(B,STR)     builder_append_netstring_context    (NULL, B, STR)
+#define builder_append_frame(B,STR)         builder_append_frame_context        (NULL, B, STR)
+
+void    builder_append_int_context          (void * context, StringBuilder * builder, s64 n);
+void    builder_append_resp_simple_context  (void * context, StringBuilder * builder, String string);
+void    builder_append_resp_error_context   (void * context, StringBuilder * builder, String string);
+void    builder_append_resp_int_context     (void * context, StringBuilder * builder, s64 n);
+void    builder_append_resp_bulk_context    (void * context, StringBuilder * builder, String string);
+void    builder_append_resp_null_context    (void * context, StringBuilder * builder);
+void    builder_append_resp_array_context   (void * context, StringBuilder * builder, s32 count);
+void    builder_append_netstring_context    (void * context, StringBuilder * builder, String string);
+void    builder_append_frame_context        (void * context, StringBuilder * builder, String string);
+
+// Decoded RESP value. For '$' and '*', integer is the length or element count
+// (-1 for null). For '*', string spans the encoded elements, which can be
+// decoded in turn by passing it back to string_decode_resp().
+typedef struct {
+    char    type;
+    s64     integer;
+    String  string;
+} RespValue;
+
+// The decoders return 1 and advance *pos past a complete message, 0 if more
+// input is needed (*pos is left alone), or -EINVAL on malformed input. The
+// decoded Strings point into buf, so consume a whole batch of messages with a
+// single builder_consume(&rx, pos) once they have been handled.
+int     string_decode_resp          (String buf, s32 * pos, RespValue * value);
+int     string_decode_netstring     (String buf, s32 * pos, String * value);
+int     string_decode_frame         (String buf, s32 * pos, String * value);
+
+// LEB128 varints and varint-length-prefixed strings
+#define builder_append_varint_u64(B,N)      builder_append_varint_u64_context   (NULL, B, N)
+#define builder_append_lp_string(B,STR)     builder_append_lp_string_context    (NULL, B, STR)
+#define builder_append_lp_strings(B,A,N)    builder_append_lp_strings_context   (NULL, B, A, N)
+
+void    builder_append_varint_u64_context   (void * context, StringBuilder * builder, u64 n);
+void    builder_append_lp_string_context    (void * context, StringBuilder * builder, String string);
+void    builder_append_lp_strings_context   (void * context, StringBuilder * builder, const String * strings, s32 count);
+
+// A read cursor over a String. The reader functions return 0 on success or
+// -EINVAL if the input is malformed or truncated, in which case pos is left
+// where it was.
+typedef struct {
+    String string;
+    s32 pos;
+} StringReader;
+
+#define reader_from_string(S)   (StringReader) { .string = (S), .pos = 0 }
+
+int     reader_read_varint          (StringReader * reader, u64 * value);
+int     reader_read_lp_string       (StringReader * reader, String * value);
+
+// CRC-32C (Castagnoli). Pass 0 as the seed to start a checksum, or a previous
+// result to continue it: string_crc32c(b, string_crc32c(a, 0)) is the CRC of
+// a followed by b. crc32c_combine() gives the same result from the CRCs of a
+// and b computed independently.
+u32     string_crc32c               (String string, u32 seed);
+u32     crc32c_combine              (u32 crc1, u32 crc2, s64 len2);
+
+typedef struct {
+    u32 crc;
+    s64 len;
+} Crc32c;
+
+void    crc32c_init                 (Crc32c * hasher);
+void    crc32c_update               (Crc32c * hasher, String string);
+u32     crc32c_final                (const Crc32c * hasher);
+
+// Levenshtein distance. The batch version compares one query against many
+// candidates, stops early on any candidate whose distance must exceed
+// max_dist (recording max_dist+1 for it), and returns how many are within it.
+#define string_edit_distance(A,B)               string_edit_distance_context        (NULL, A, B)
+#define string_edit_distance_batch(Q,C,N,K,D)   string_edit_distance_batch_context  (NULL, Q, C, N, K, D)
+
+s32     string_edit_distance_context        (void * context, String a, String b);
+s32     string_edit_distance_batch_context  (void * context, String query, const String * candidates, s32 count, s32 max_dist, s32 * distances);
+
+// Glob patterns with '*' (any run of bytes) and '?' (any single byte). The
+// compiled pattern refers to the pattern's data, which must outlive it.
+typedef struct {
+    String pattern;
+    String prefix;      // literal bytes before the first wildcard
+    String suffix;      // literal bytes after the last wildcard
+    String literal;     // longest literal run, used to reject strings early
+    s32 min_len;        // number of bytes any match must have
+    int has_star;
+} GlobPattern;
+
+GlobPattern glob_compile            (String pattern);
+int         glob_match              (const GlobPattern * glob, String string);
+
+// Regular expressions: literals, '.', [classes], \d \w \s (and negations),
+// grouping, '|', '*', '+', '?', '^' and '$'. Matching is done by lazily built
+// DFAs, so it is linear in the length of the string and never backtracks.
+// regex_find() reports the leftmost-longest match. All memory, including the
+// bounded DFA state cache, is allocated by regex_compile_context() through
+// PMK_REALLOC with the given context (e.g. an Arena); regex_find() does not
+// allocate but does update the cache, so a Regex must not be shared between
+// threads. If the pattern is invalid, error is set to -EINVAL.
+
+// the state cache hashes into a table of twice this size with a mask
+#ifndef REGEX_CACHE_STATES
+#define REGEX_CACHE_STATES 256
+#endif
+#if REGEX_CACHE_STATES <= 0 || (REGEX_CACHE_STATES & (REGEX_CACHE_STATES - 1)) != 0
+#error "REGEX_CACHE_STATES must be a power of two"
+#endif
+
+typedef struct {
+    s32 to;
+    s32 label;          // index into Regex.sets, or one of the REGEX_EDGE_* values
+} RegexEdge;
+
+typedef struct {
+    s32 start;
+    s32 accept;
+    s32 * edge_index;   // edges of state i are edges[edge_index[i] .. edge_index[i+1]]
+    RegexEdge * edges;
+    u8 * important;     // states which are kept in DFA state sets
+} RegexNfa;
+
+typedef struct {
+    int reverse;
+    int unanchored;
+    s32 nstates;
+    s32 start_state[2]; // indexed by whether the scan is at the beginning
+    s32 * trans;        // REGEX_CACHE_STATES * nclasses, -1 where not yet built
+    u8 * flags;
+    s32 * set_index;    // NFA states of DFA state i: set_pool[set_index[i] .. set_index[i+1]]
+    s32 * set_pool;
+    s32 pool_cap;
+    s32 * table;        // open-addressing hash of DFA states by NFA state set
+} RegexDfa;
+
+typedef struct {
+    void * context;
+    int error;
+    s32 nnfa;
+    s32 nsets;
+    u64 (* sets)[4];
+    s32 nclasses;
+    u8 byte_class[256];
+    u8 class_rep[256];
+    RegexNfa nfa[2];    // forward, reverse
+    RegexDfa forward;   // unanchored, used to decide whether there is a match
+    RegexDfa reverse;   // unanchored from the end, finds the leftmost start
+    RegexDfa anchored;  // from the start, finds the longest end
+    s32 * stack;
+    s32 * scratch[2];
+    u32 * marks;
+    u32 generation;
+    char literal[32];   // bytes which every match must contain
+    s32 literal_len;
+} Regex;
+
+#define regex_compile(P)        regex_compile_context(NULL, P)
+
+Regex   regex_compile_context       (void * context, String pattern);
+int     regex_find                  (Regex * regex, String string, String * match);
+void    regex_destroy               (Regex * regex);
+
+// Suffix array over a String, built with SA-IS in linear time. Besides the
+// 4n-byte array it holds a bit per symbol and the bucket counters of one
+// recursion level at a time, keeping the counters in unused parts of the
+// array when they fit; the peak is at most about 5n bytes plus 64 MB, and
+// 4.125n on typical text. sa[i] is the start of the i-th smallest
+// suffix; lcp[i], if built, is the length of the longest common prefix of
+// suffixes sa[i-1] and sa[i] (lcp[0] = 0). The text is referenced, not
+// copied.
+typedef struct {
+    String text;
+    s32 * sa;
+    s32 * lcp;
+} SuffixArray;
+
+#define sa_build(S)         sa_build_context    (NULL, S)
+#define sa_build_lcp(SA)    sa_build_lcp_context(NULL, SA)
+#define sa_destroy(SA)      sa_destroy_context  (NULL, SA)
+
+SuffixArray sa_build_context        (void * context, String text);
+void        sa_build_lcp_context    (void * context, SuffixArray * sa);
+void        sa_destroy_context      (void * context, SuffixArray * sa);
+// returns the number of occurrences of needle; their positions are
+// sa->sa[*first .. *first + count), in suffix order
+s32         sa_find_all             (const SuffixArray * sa, String needle, s32 * first);
+
+// Inverted index from each 3-byte sequence to the documents containing it.
+// Posting lists are stored as varint-encoded deltas of ascending document
+// ids. The index refers to the docs array, which must outlive it.
+typedef struct {
+    const String * docs;
+    s32 ndocs;
+    s32 cap;            // hash table slots (a power of two)
+    u32 * keys;         // trigram in each slot, or TRIGRAM_EMPTY
+    s32 * counts;       // number of documents in each slot's posting list
+    s32 * offsets;      // postings of slot i: postings[offsets[i] .. offsets[i+1])
+    u8 * postings;
+} TrigramIndex;
+
+#define TRIGRAM_EMPTY 0xffffffffu
+
+#define trigram_index_build(D,N)    trigram_index_build_context     (NULL, D, N)
+#define trigram_index_destroy(T)    trigram_index_destroy_context   (NULL, T)
+
+TrigramIndex    trigram_index_build_context     (void * context, const String * docs, s32 count);
+void            trigram_index_destroy_context   (void * context, TrigramIndex * index);
+// writes the ids of the documents containing needle to out, which must have
+// room for index->ndocs ids, and returns how many there are
+s32             trigram_index_find              (const TrigramIndex * index, String needle, s32 * out);
+
+// 64-bit non-cryptographic hash of the bytes of a string
+u64     string_hash                 (String string);
+// string_hash() of each of n keys, written to out
+void    string_hash_batch           (const String * keys, s32 n, u64 * out);
+// slot of a key in a minimal perfect hash table of n slots, given its
+// string_hash() and its bucket's displacement; tables and lookup functions
+// using it are generated by pmk_phash_gen.c
+u32     phash_index                 (u64 hash, u32 displacement, u32 n);
+
+// Content-defined chunking with a Gear rolling hash (FastCDC). Boundaries
+// depend only on nearby content, so an insertion changes the chunks around
+// it and leaves the rest intact. Chunks are at least min (except the last)
+// and at most max bytes, averaging about avg; normalized chunking keeps most
+// of them close to avg. out must have room for string.len / min + 1 chunks.
+// hashes, if not NULL, receives string_hash() of each chunk. Returns the
+// number of chunks, or -EINVAL unless 0 < min <= avg <= max and avg >= 4.
+#define string_cdc_chunks(S,MIN,AVG,MAX,OUT) string_cdc_chunks_hashed(S, MIN, AVG, MAX, OUT, NULL)
+
+s32     string_cdc_chunks_hashed    (String string, s32 min, s32 avg, s32 max, String * out, u64 * hashes);
+
+// Searches for many needles of one common length at once with a Rabin-Karp
+// rolling hash. Needle hashes are kept in an open-addressing table fronted by
+// a small Bloom filter, so most haystack positions cost one cache-resident
+// lookup; hash matches are verified with string_equal(). The searcher refers
+// to the needles array, which must outlive it. error is -EINVAL if the
+// needles are empty or differ in length.
+typedef struct {
+    int error;
+    const String * needles;
+    s32 count;
+    s32 len;            // length of every needle
+    u64 pow;            // RK_BASE^len, to remove the byte leaving the window
+    s32 bits;           // log2 of the number of table slots
+    u64 * hashes;
+    s32 * ids;          // needle in each slot, or -1
+    s32 bloom_bits;     // log2 of the number of Bloom filter words
+    u64 * bloom;
+} RollingSearcher;
+
+#define rolling_searcher_build(N,C)     rolling_searcher_build_context      (NULL, N, C)
+#define rolling_searcher_destroy(R)     rolling_searcher_destroy_context    (NULL, R)
+
+RollingSearcher rolling_searcher_build_context      (void * context, const String * needles, s32 count);
+void            rolling_searcher_destroy_context    (void * context, RollingSearcher * searcher);
+// position of the first occurrence of any needle at or after pos, or
+// haystack.len if there is none; *needle (if not NULL) is set to its index
+s32             rolling_searcher_find               (const RollingSearcher * searcher, String haystack, s32 pos, s32 * needle);
+
+// LZ4 block format (no frame header). builder_compress_into() appends the
+// compressed form of src; builder_decompress_into() appends the expected_len
+// bytes that src decompresses to, reserving them once, and returns 0, or
+// -EINVAL (leaving the builder's length unchanged) if src is malformed or
+// does not decompress to exactly expected_len bytes.
+#define builder_compress_into(B,STR)        builder_compress_into_context   (NULL, B, STR)
+#define builder_decompress_into(B,STR,N)    builder_decompress_into_context (NULL, B, STR, N)
+
+void    builder_compress_into_context       (void * context, StringBuilder * builder, String src);
+int     builder_decompress_into_context     (void * context, StringBuilder * builder, String src, s32 expected_len);
+
+// FSST static symbol table compression for collections of short strings.
+// fsst_train() picks up to 255 symbols of 1 to 8 bytes from a sample of the
+// strings; each string is then compressed on its own into one-byte codes,
+// with code 255 escaping a byte that no symbol covers. Compression is
+// deterministic, so two strings are equal exactly when their compressed
+// forms are, and string_equal() can compare them without decompressing.
+#define FSST_ESCAPE     255
+#define FSST_HASH_SLOTS 1024
+
+typedef struct {
+    s32 nsymbols;
+    u64 symbols[255];       // bytes of each code, little-endian, zero padded
+    u8 lens[255];
+    u16 byte_codes[256];    // len << 8 | code of the symbol for one byte
+    u16 * short_codes;      // the same indexed by the next two bytes
+    u64 hash_symbols[FSST_HASH_SLOTS];  // symbols of 3+ bytes by their first 3
+    u8 hash_lens[FSST_HASH_SLOTS];      // 0 for an empty slot
+    u8 hash_codes[FSST_HASH_SLOTS];
+} FsstTable;
+
+#define fsst_train(S,N)                     fsst_train_context                  (NULL, S, N)
+#define fsst_destroy(T)                     fsst_destroy_context                (NULL, T)
+#define builder_append_fsst(B,T,STR)        builder_append_fsst_context         (NULL, B, T, STR)
+#define builder_append_fsst_decoded(B,T,STR) builder_append_fsst_decoded_context (NULL, B, T, STR)
+#define fsst_compress_strings(T,S,N,H,O)    fsst_compress_strings_context       (NULL, T, S, N, H, O)
+
+FsstTable * fsst_train_context                  (void * context, const String * sample, s32 count);
+void        fsst_destroy_context                (void * context, FsstTable * table);
+void        builder_append_fsst_context         (void * context, StringBuilder * builder, const FsstTable * table, String string);
+int         builder_append_fsst_decoded_context (void * context, StringBuilder * builder, const FsstTable * table, String compressed);
+// compresses each string onto the end of heap; string i ends up at
+// heap->data[offsets[i] .. offsets[i+1]], so offsets needs count + 1 entries
+void        fsst_compress_strings_context       (void * context, const FsstTable * table, const String * strings, s32 count,
+                                                 StringBuilder * heap, s32 * offsets);
+
+// Line diff (Myers O(ND) with the linear-space refinement). A line includes
+// its '\n'. Each hunk replaces lines a_start .. a_start+a_count-1 of a with
+// lines b_start .. b_start+b_count-1 of b (0-based; a count may be 0), and
+// hunks are reported to callback in order. A nonzero return from callback
+// stops the diff and is returned; otherwise the result is 0.
+typedef struct {
+    s32 a_start, a_count;
+    s32 b_start, b_count;
+} DiffHunk;
+
+typedef int (* DiffCallback)(void * user, DiffHunk hunk);
+
+#define string_diff_lines(A,B,F,U)              string_diff_lines_context           (NULL, A, B, F, U)
+#define builder_append_unified_diff(B,X,Y,N)    builder_append_unified_diff_context (NULL, B, X, Y, N)
+
+int     string_diff_lines_context           (void * context, String a, String b, DiffCallback callback, void * user);
+// appends the hunks of a unified diff from a to b, with context_lines of
+// unchanged lines around each change (no ---/+++ file header)
+void    builder_append_unified_diff_context (void * context, StringBuilder * builder, String a, String b, s32 context_lines);
+
+// Sorts the lines of a file into another (bytewise, as string_compare()),
+// using about mem_budget bytes however large the input is: sorted runs are
+// spilled to temporary files and merged with a loser tree, EXTERNAL_SORT_FAN_IN
+// at a time as they accumulate, so open temporary files grow only with the
+// logarithm of the input size. With
+// EXTERNAL_SORT_UNIQUE, duplicate lines are written once. threads > 1 sorts
+// each run in that many slices in parallel when the library is compiled
+// with PMK_STRING_PTHREADS, and is ignored otherwise. Every output line ends
+// with '\n'. Returns 0 or a negative errno value.
+#define EXTERNAL_SORT_UNIQUE    1
+#define EXTERNAL_SORT_FAN_IN    64
+
+#define external_sort_lines(I,O,M,T,F)  external_sort_lines_context (NULL, I, O, M, T, F)
+
+int     external_sort_lines_context (void * context, const char * in_path, const char * out_path,
+                                     s64 mem_budget, s32 threads, int flags);
+
+// Set operations on String arrays sorted by string_compare() and free of
+// duplicates (see string_unique()). Results are written to out, also sorted,
+// and their number is returned; out needs room for MIN(na, nb) strings for
+// an intersection, na + nb for a union and na for a difference (a - b).
+// Galloping search skips long stretches of the larger input, so intersecting
+// m strings with n costs O(m log(n/m)) comparisons.
+s32     string_set_intersect        (const String * a, s32 na, const String * b, s32 nb, String * out);
+s32     string_set_union            (const String * a, s32 na, const String * b, s32 nb, String * out);
+s32     string_set_difference       (const String * a, s32 na, const String * b, s32 nb, String * out);
+// removes adjacent duplicates in place and returns the new count
+s32     string_unique               (String * strings, s32 count);
+
+// Fixed-size stream summaries. Each has a _hash variant of its update that
+// takes string_hash() of the value, so one hash can feed several of them.
+// Summaries with the same shape built on different threads can be merged.
+
+// Count-Min sketch: estimates are never below the true count and exceed it
+// by at most about 2 * total / width with probability 1 - 2^-depth. width is
+// rounded up to a power of two; counters saturate at UINT32_MAX.
+typedef struct {
+    s32 width;
+    s32 depth;
+    u32 * counts;       // depth rows of width counters
+    u64 total;
+} CountMinSketch;
+
+#define cms_create(W,D)         cms_create_context  (NULL, W, D)
+#define cms_destroy(C)          cms_destroy_context (NULL, C)
+#define cms_add(C,STR,N)        cms_add_hash        (C, string_hash(STR), N)
+#define cms_estimate(C,STR)     cms_estimate_hash   (C, string_hash(STR))
+
+CountMinSketch  cms_create_context  (void * context, s32 width, s32 depth);
+void            cms_destroy_context (void * context, CountMinSketch * cms);
+void            cms_add_hash        (CountMinSketch * cms, u64 hash, u32 count);
+u32             cms_estimate_hash   (const CountMinSketch * cms, u64 hash);
+// adds src into dst; -EINVAL if their shapes differ
+int             cms_merge           (CountMinSketch * dst, const CountMinSketch * src);
+
+// SpaceSaving top-k: monitors at most k values. A value's true count lies
+// between count - error and count, and any value seen more than total / k
+// times is monitored. Keys are copied (memory is k times the longest key)
+// using the context given at creation, which must also be the one it is
+// destroyed with. Counters sit in a min-heap, so an update costs O(1) to
+// find the key and O(log k) at worst to reorder.
+typedef struct {
+    String key;
+    u64 count;
+    u64 error;
+} HeavyHitter;
+
+typedef struct {
+    void * context;
+    s32 k;
+    s32 len;
+    StringBuilder * keys;
+    u64 * hashes;
+    u64 * counts;
+    u64 * errors;
+    s32 * heap;         // monitored slots, least count first
+    s32 * heap_pos;     // position of each slot in heap
+    s32 * table;        // open-addressing index of slots by hash, -1 if empty
+    s32 table_bits;
+} SpaceSaving;
+
+#define space_saving_create(K)          space_saving_create_context (NULL, K)
+#define space_saving_destroy(S)         space_saving_destroy_context(NULL, S)
+#define space_saving_add(S,STR,N)       space_saving_add_hash       (S, STR, string_hash(STR), N)
+
+SpaceSaving space_saving_create_context (void * context, s32 k);
+void        space_saving_destroy_context(void * context, SpaceSaving * ss);
+void        space_saving_add_hash       (SpaceSaving * ss, String key, u64 hash, u64 count);
+// writes up to n of the monitored values to out, highest count first, and
+// returns how many; the keys are valid until the next update
+s32         space_saving_top            (const SpaceSaving * ss, HeavyHitter * out, s32 n);
+// combines src into dst; -EINVAL if k differs
+int         space_saving_merge          (SpaceSaving * dst, const SpaceSaving * src);
+
+// HyperLogLog distinct count with 2^precision one-byte registers (precision
+// is clamped to 4..18); the standard error is about 1.04 / sqrt(2^precision).
+typedef struct {
+    s32 precision;
+    u8 * registers;
+} HyperLogLog;
+
+#define hll_create(P)       hll_create_context  (NULL, P)
+#define hll_destroy(H)      hll_destroy_context (NULL, H)
+#define hll_add(H,STR)      hll_add_hash        (H, string_hash(STR))
+
+HyperLogLog hll_create_context  (void * context, s32 precision);
+void        hll_destroy_context (void * context, HyperLogLog * hll);
+void        hll_add_hash        (HyperLogLog * hll, u64 hash);
+double      hll_count           (const HyperLogLog * hll);
+// dst becomes the union of dst and src; -EINVAL if the precisions differ
+int         hll_merge           (HyperLogLog * dst, const HyperLogLog * src);
+
+// Approximate membership of a fixed set of strings: no false negatives, and
+// false positives at a rate set by the space used. STRING_FILTER_BLOOM is a
+// blocked Bloom filter: all bits of a key are in one 64-byte block, so a
+// check costs one cache miss; the rate is about 1% at 10 bits per key.
+// STRING_FILTER_XOR is a binary fuse filter (an xor filter variant) with
+// 8-bit fingerprints: about 9 bits per key for a 0.4% rate, with three
+// lookups in a narrow window; bits_per_key is ignored. error is -EINVAL if
+// the filter could not be built.
+//
+// A filter serializes to a blob with a 64-byte header; string_filter_view()
+// uses a blob in place (e.g. from mmap()) without copying, and the blob must
+// then outlive the filter. Place the blob at a 64-byte aligned address to
+// keep each Bloom block within one cache line.
+#define STRING_FILTER_BLOOM 0
+#define STRING_FILTER_XOR   1
+
+typedef struct {
+    int error;
+    int kind;
+    u32 k;              // Bloom: bits set per key
+    u32 size;           // Bloom: number of blocks; xor: segment length
+    u32 segment_count;  // xor only
+    u64 seed;           // xor only
+    const u8 * data;    // Bloom blocks or xor fingerprints
+    u32 data_len;
+    void * owned;       // allocation holding data, NULL for a view
+} StringFilter;
+
+#define string_filter_build(K,S,N,B)        string_filter_build_context         (NULL, K, S, N, B)
+#define string_filter_destroy(F)            string_filter_destroy_context       (NULL, F)
+#define string_filter_contains(F,STR)       string_filter_contains_hash         (F, string_hash(STR))
+#define builder_append_string_filter(B,F)   builder_append_string_filter_context(NULL, B, F)
+
+StringFilter    string_filter_build_context         (void * context, int kind, const String * strings, s32 count, s32 bits_per_key);
+void            string_filter_destroy_context       (void * context, StringFilter * filter);
+int             string_filter_contains_hash         (const StringFilter * filter, u64 hash);
+void            builder_append_string_filter_context(void * context, StringBuilder * builder, const StringFilter * filter);
+int             string_filter_view                  (String blob, StringFilter * filter);
+
+// Adaptive radix tree (ART) mapping strings to s32 values, for exact and
+// longest-prefix lookups whose cost depends on the key length rather than on
+// the number of keys. Runs of bytes with a single child are compressed into
+// one node, and inner nodes grow from 4 to 16, 48 and 256 children as
+// needed; 16-way nodes are searched with SSE2 where available. Keys may
+// contain any bytes and are copied into the tree's leaves. All nodes are
+// allocated from the context passed to insert, and destroy must be given the
+// same one; with an arena, destroying the arena frees the tree.
+typedef struct {
+    void * root;
+    s32 count;
+} RadixTree;
+
+#define radix_insert(T,K,V)     radix_insert_context    (NULL, T, K, V)
+#define radix_destroy(T)        radix_destroy_context   (NULL, T)
+
+// sets the value of key, replacing any previous one; returns 1 if the key is
+// new, else 0
+int     radix_insert_context    (void * context, RadixTree * tree, String key, s32 value);
+void    radix_destroy_context   (void * context, RadixTree * tree);
+// value of key, or -1 if it is not in the tree
+s32     radix_find              (const RadixTree * tree, String key);
+// value of the longest key in the tree which is a prefix of string, or -1 if
+// there is none; *len (if not NULL) is set to that key's length
+s32     radix_longest_prefix    (const RadixTree * tree, String string, s32 * len);
+
+// Exact counts of string keys, for word counts and group-by. Each key is
+// hashed once per update and found by linear probing in a flat table whose
+// 32-byte slots hold the hash, the count and the first 8 bytes of the key,
+// so short keys are compared without leaving the slot; all key bytes are
+// also appended to one buffer. Memory comes from the context given at
+// creation, which must also be the one it is destroyed with. Counters built
+// on separate threads can be merged without rehashing.
+typedef struct {
+    u64 hash;
+    u64 count;
+    s32 len;            // key length, -1 if the slot is empty
+    s32 offset;         // key bytes in keys
+    char head[8];       // first bytes of the key
+} CounterSlot;
+
+typedef struct {
+    void * context;
+    s32 len;            // distinct keys
+    s32 bits;           // log2 of the number of slots
+    CounterSlot * slots;
+    StringBuilder keys;
+    u64 total;
+} StringCounter;
+
+#define counter_create(N)           counter_create_context  (NULL, N)
+#define counter_destroy(C)          counter_destroy_context (NULL, C)
+#define counter_add(C,STR,N)        counter_add_hash        (C, STR, string_hash(STR), N)
+#define counter_get(C,STR)          counter_get_hash        (C, STR, string_hash(STR))
+
+// n is the expected number of distinct keys; the table grows past it
+StringCounter   counter_create_context  (void * context, s32 n);
+void            counter_destroy_context (void * context, StringCounter * counter);
+void            counter_add_hash        (StringCounter * counter, String key, u64 hash, u64 count);
+u64             counter_get_hash        (const StringCounter * counter, String key, u64 hash);
+// adds the counts of src to dst
+void            counter_merge           (StringCounter * dst, const StringCounter * src);
+// writes the k most frequent keys to out (error is always 0), highest count
+// first and ties in string_compare() order, and returns how many there are.
+// Selection is partial, O(len + k log k). Keys are valid until the next
+// update.
+s32             counter_top_k           (const StringCounter * counter, HeavyHitter * out, s32 k);
+
+// Column of strings stored as separate arrays (struct of arrays) over one
+// byte heap, for database-style scans. lens and prefix4 (the first 4 bytes,
+// zero-padded, in little-endian order) are compared 8 rows at a time with
+// AVX2 or 4 at a time with SSE2, and only rows passing that test touch the
+// heap. Filters write a selection bitmap with a bit per row (bit i % 64 of
+// word i / 64, unused bits zeroed), which needs (count + 63) / 64 words, and
+// return the number of selected rows.
+typedef struct {
+    s32 count;
+    s32 cap;
+    s32 * lens;
+    u32 * offsets;      // start of each string in heap
+    u32 * prefix4;
+    StringBuilder heap;
+} StringColumn;
+
+#define column_append(C,STR)        column_append_context   (NULL, C, STR)
+#define column_destroy(C)           column_destroy_context  (NULL, C)
+
+void    column_append_context       (void * context, StringColumn * column, String string);
+void    column_destroy_context      (void * context, StringColumn * column);
+String  column_get                  (const StringColumn * column, s32 i);
+// rows whose length is in [min_len, max_len]
+s32     column_filter_len           (const StringColumn * column, s32 min_len, s32 max_len, u64 * bitmap);
+// rows starting with prefix
+s32     column_filter_prefix        (const StringColumn * column, String prefix, u64 * bitmap);
+// rows equal to value
+s32     column_equal_const          (const StringColumn * column, String value, u64 * bitmap);
+// writes the indices of the set bits among the first count to out, in
+// ascending order, and returns how many there are
+s32     bitmap_to_indices           (const u64 * bitmap, s32 count, s32 * out);
+
+// Dictionary-encoded column for low-cardinality strings. Each distinct value
+// is stored once and gets a code; rows hold 2-byte codes, widened to 4 bytes
+// once there are more than 65536 values. Equality filters, group counts and
+// row sorting work on the codes. After dict_sort() the codes follow
+// string_compare() order, which also allows range filters on codes; a later
+// append of a new value clears sorted. Strings returned by dict_decode() point
+// into the dictionary and are valid until the next append.
+typedef struct {
+    s32 count;          // rows
+    s32 cap;
+    s32 code_size;      // bytes per code: 2 or 4
+    void * codes;
+    s32 ndict;          // distinct values
+    s32 dict_cap;
+    u32 * offsets;      // value of code c: heap bytes [offsets[c], offsets[c] + lens[c])
+    s32 * lens;
+    u64 * hashes;
+    StringBuilder heap;
+    s32 * table;        // open-addressing index of codes by hash, -1 if empty
+    s32 table_bits;
+    int sorted;         // codes are in string_compare() order
+} DictColumn;
+
+#define dict_append(D,STR)          dict_append_context     (NULL, D, STR)
+#define dict_destroy(D)             dict_destroy_context    (NULL, D)
+#define dict_sort(D)                dict_sort_context       (NULL, D)
+#define dict_sort_rows(D,R)         dict_sort_rows_context  (NULL, D, R)
+
+// appends a row and returns its code
+u32     dict_append_context         (void * context, DictColumn * column, String value);
+void    dict_destroy_context        (void * context, DictColumn * column);
+u32     dict_code                   (const DictColumn * column, s32 row);
+String  dict_decode                 (const DictColumn * column, u32 code);
+// code of value, or -1 if it is not in the dictionary
+s64     dict_lookup                 (const DictColumn * column, String value);
+// renumbers the codes in string order and sets sorted
+void    dict_sort_context           (void * context, DictColumn * column);
+// rows equal to value, as a selection bitmap (see StringColumn)
+s32     dict_filter_equal           (const DictColumn * column, String value, u64 * bitmap);
+// rows with lo <= value <= hi; -EINVAL unless the dictionary is sorted
+s32     dict_filter_range           (const DictColumn * column, String lo, String hi, u64 * bitmap);
+// counts[c] = number of rows with code c, for c < ndict
+void    dict_group_counts           (const DictColumn * column, u64 * counts);
+// writes all row indices to rows ordered by code (by value once sorted),
+// stably, with a counting sort
+void    dict_sort_rows_context      (void * context, const DictColumn * column, s32 * rows);
+
+// Appends a binary sort key for string: comparing keys with string_compare()
+// (or memcmp() and then length) orders the strings as the flags ask, so
+// parsing happens once per string rather than once per comparison.
+// SORT_KEY_FOLD_CASE maps ASCII letters to lower case. SORT_KEY_NATURAL
+// orders runs of digits by numeric value ("file2" < "file10"): a run becomes
+// '0', its length without leading zeros (one byte, or 0xff and four bytes
+// big-endian from 255 digits on) and those digits, so numbers still sort
+// where an ASCII digit would. Strings that differ only in case or leading
+// zeros get equal keys; use a stable sort to keep their input order.
+#define SORT_KEY_FOLD_CASE  1
+#define SORT_KEY_NATURAL    2
+
+#define builder_append_sort_key(B,STR,F)    builder_append_sort_key_context(NULL, B, STR, F)
+
+void    builder_append_sort_key_context     (void * context, StringBuilder * builder, String string, int flags);
+
+// Membership test against a small fixed set of strings (enum names, stop
+// words), returning the index of the match. Values are grouped by length,
+// 32 to a group, and stored transposed: row j of a group holds byte j of each
+// value. A lookup compares each key byte with a whole row at once (AVX2, or
+// two SSE2 compares), keeping a bitmask of the values still matching, so
+// its cost depends on the key length and not on how many values share it.
+typedef struct {
+    s32 count;
+    s32 max_len;
+    s32 * first_group;  // groups of values of length n: [first_group[n], first_group[n + 1])
+    u32 * valid;        // lanes of each group holding a value
+    s32 * ids;          // value index of each lane, 32 per group
+    s32 * offsets;      // start of each group's rows in bytes
+    u8 * bytes;
+} StringSet;
+
+#define string_set_build(V,N)       string_set_build_context    (NULL, V, N)
+#define string_set_destroy(S)       string_set_destroy_context  (NULL, S)
+
+StringSet   string_set_build_context    (void * context, const String * values, s32 count);
+void        string_set_destroy_context  (void * context, StringSet * set);
+// index of the first value equal to key, or -1
+s32         string_find_in_set          (const StringSet * set, String key);
 
 #endif /* PMK_STRING_H */
 
@@ -347,6 +1018,90 @@ int     builder_read_file_context   (void * context, StringBuilder * builder, co
 
 #define IS_FIXED(B) ((B).cap & 1)
 
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+// x must be non-zero
+static s32
+ctz64(u64 x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_ctzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long i;
+    _BitScanForward64(&i, x);
+    return (s32) i;
+#else
+    s32 i = 0;
+    while (!(x & 1)) {
+        x >>= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+// x must be non-zero
+static s32
+clz64(u64 x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(x);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    unsigned long i;
+    _BitScanReverse64(&i, x);
+    return 63 - (s32) i;
+#else
+    s32 i = 0;
+    while (!(x & ((u64) 1 << 63))) {
+        x <<= 1;
+        i++;
+    }
+    return i;
+#endif
+}
+
+static s32
+popcount64(u64 x)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_popcountll(x);
+#else
+    x = x - ((x >> 1) & 0x5555555555555555ull);
+    x = (x & 0x3333333333333333ull) + ((x >> 2) & 0x3333333333333333ull);
+    x = (x + (x >> 4)) & 0x0f0f0f0f0f0f0f0full;
+    return (s32) ((x * 0x0101010101010101ull) >> 56);
+#endif
+}
+
+static u64
+load_u64_le(const void * p)
+{
+    const u8 * b = p;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (u64) b[0]       | (u64) b[1] << 8  | (u64) b[2] << 16 | (u64) b[3] << 24 |
+           (u64) b[4] << 32 | (u64) b[5] << 40 | (u64) b[6] << 48 | (u64) b[7] << 56;
+#else
+    u64 x;
+    memcpy(&x, b, 8);
+    return x;
+#endif
+}
+
+static u32
+load_u32_le(const void * p)
+{
+    const u8 * b = p;
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+    return (u32) b[0] | (u32) b[1] << 8 | (u32) b[2] << 16 | (u32) b[3] << 24;
+#else
+    u32 x;
+    memcpy(&x, b, 4);
+    return x;
+#endif
+}
+
 int
 string_equal(String s1, String s2)
 {
@@ -707,20 +1462,21 @@ builder_print_context(void * context, StringBuilder * builder, const char * fmt,
 int
 builder_getline_context(void * context, StringBuilder * builder, FILE * fp)
 {
-    if (builder->cap == 0)
-        builder_reserve_context(context, builder, 128);
-
     while (1) {
+        // grow geometrically so that long lines take O(log n) reads
+        if (builder->cap - builder->len < 64)
+            builder_reserve_context(context, builder, MAX(builder->cap * 2, 128));
         char * dst = builder->data + builder->len;
         s32 avail = builder->cap - builder->len;
         if (fgets(dst, avail, fp) == NULL) {
             if (ferror(fp))
                 return -errno;
-            // only possibility: EOF with 0 chars read
-            builder->len = 0;
+            // EOF with 0 chars read, or right after a chunk that filled the
+            // buffer; either way what the caller had is kept
+            builder->data[builder->len] = '\0';
             return 0;
         }
-        builder->len = strlen(builder->data);
+        builder->len += (s32) strlen(dst);
         assert(builder->len > 0);
         if (builder->data[builder->len-1] == '\n') {
             builder->len--;
@@ -729,7 +1485,6 @@ builder_getline_context(void * context, StringBuilder * builder, FILE * fp)
         if (feof(fp)) // file ended without a newline
             return 0;
         // there's more data but the buffer is full
-        builder_reserve_context(context, builder, 128);
     }
 }
 
@@ -811,151 +1566,5856 @@ builder_splice_context(void * context, StringBuilder * builder, s32 start, s32 e
     builder->data[builder->len] = '\0';
 }
 
-#ifdef PMK_STRING_TEST
-
-static char
-random_printable()
+// removes the first n bytes with a single memmove
+void
+builder_consume(StringBuilder * builder, s32 n)
 {
-    int r = (rand() % ('~' - ' ' + 3)) + ' ';
-    assert(r >= ' ');
-    assert(r <= '~' + 2);
-    if (r ==  '~' + 1) r = '\n';
-    if (r ==  '~' + 2) r = '\t';
-    return r;
+    assert(n >= 0);
+    assert(n <= builder->len);
+    if (n == 0)
+        return;
+    memmove(builder->data, builder->data + n, builder->len - n);
+    builder->len -= n;
+    builder->data[builder->len] = '\0';
 }
 
+// makes room for additional bytes plus a nul terminator
 static void
-gen_random_cstring(char * s, s32 len)
+builder_grow(void * context, StringBuilder * builder, s32 additional)
 {
-    for (s32 i = 0; i < len; i++) {
-        s[i] = random_printable();
+    s32 new_len = builder->len + additional;
+    if (builder->cap < new_len + 1) {
+        s32 new_cap = MAX(builder->cap * 2, new_len + 1);
+        builder_reserve_context(context, builder, new_cap);
     }
-    s[len] = '\0';
 }
 
+// writes the decimal representation of n to the end of buf[20] and returns
+// the index of the first digit; no allocation and no call to snprintf()
 static s32
-change_random_char(char * s, s32 len)
+format_int(char * buf, s64 n)
 {
-    s32 index = rand() % len;
-    char prev = s[index];
-    char r;
+    u64 u = (n < 0) ? (u64) 0 - (u64) n : (u64) n;
+    s32 i = 20;
     do {
-        r = random_printable();
-    } while (r == prev);
-    s[index] = r;
-    return index;
+        buf[--i] = '0' + (char) (u % 10);
+        u /= 10;
+    } while (u);
+    if (n < 0)
+        buf[--i] = '-';
+    return i;
 }
 
-static void
-pmk_string_test()
+void
+builder_append_int_context(void * context, StringBuilder * builder, s64 n)
 {
-    // string_equal()
-    assert( string_equal(   str_lit("hello"),   str_lit("hello"))       );
-    assert( string_equal(   str_lit(""),        str_lit(""))            );
-    assert(!string_equal(   str_lit("hello!"),  str_lit("hello?"))      );
-    assert(!string_equal(   str_lit(""),        str_lit("hello"))       );
-    assert(!string_equal(   str_lit("hello"),   str_lit(""))            );
-    assert(!string_equal(   str_lit("hello"),   str_lit("hello there")) );
-    assert(!string_equal(   str_lit("hello!"),  str_lit("hello"))       );
-
-    // string_equaln()
-    assert( string_equaln(  str_lit("hello!"),  str_lit("hello?"),  5)  );
-    assert( string_equaln(  str_lit(""),        str_lit(""),        0)  );
-    assert(!string_equaln(  str_lit("hello!"),  str_lit("hello?"),  6)  );
-    assert(!string_equaln(  str_lit("hello"),   str_lit("hello"),   6)  );
+    char buf[20];
+    s32 i = format_int(buf, n);
+    builder_append_context(context, builder, (String) { .data = buf + i, .len = 20 - i });
+}
 
-    // string_compare()
-    assert(string_compare(  str_lit("aaa"),     str_lit("bbb")) < 0     );
-    assert(string_compare(  str_lit("bbb"),     str_lit("aaa")) > 0     );
-    assert(string_compare(  str_lit("aaa"),     str_lit("aaa")) == 0    );
-    assert(string_compare(  str_lit("aa"),      str_lit("aaa")) < 0     );
-    assert(string_compare(  str_lit("aa"),      str_lit(""))    > 0     );
+// appends <prefix><n>\r\n<string>[\r\n] with a single reservation
+static void
+builder_append_header(void * context, StringBuilder * builder, char prefix, s64 n, String string, int trailer)
+{
+    char buf[20];
+    s32 i = format_int(buf, n);
+    s32 extra = 1 + (20 - i) + 2 + string.len + (trailer ? 2 : 0);
+    builder_grow(context, builder, extra);
+    char * dst = builder->data + builder->len;
+    *dst++ = prefix;
+    memcpy(dst, buf + i, 20 - i);
+    dst += 20 - i;
+    *dst++ = '\r';
+    *dst++ = '\n';
+    if (string.len > 0)
+        memcpy(dst, string.data, string.len);
+    dst += string.len;
+    if (trailer) {
+        *dst++ = '\r';
+        *dst++ = '\n';
+    }
+    builder->len += extra;
+    builder->data[builder->len] = '\0';
+}
 
-    // string_compare_qsort()
-    assert(string_compare_qsort(    &str_lit("aaa"), &str_lit("bbb")) < 0   );
-    assert(string_compare_qsort(    &str_lit("bbb"), &str_lit("aaa")) > 0   );
-    assert(string_compare_qsort(    &str_lit("aaa"), &str_lit("aaa")) == 0  );
-    assert(string_compare_qsort(    &str_lit("aa"),  &str_lit("aaa")) < 0   );
-    assert(string_compare_qsort(    &str_lit("aa"),  &str_lit("")   ) > 0   );
+static void
+builder_append_resp_line(void * context, StringBuilder * builder, char prefix, String string)
+{
+    builder_grow(context, builder, string.len + 3);
+    char * dst = builder->data + builder->len;
+    *dst++ = prefix;
+    if (string.len > 0)
+        memcpy(dst, string.data, string.len);
+    dst += string.len;
+    *dst++ = '\r';
+    *dst++ = '\n';
+    builder->len += string.len + 3;
+    builder->data[builder->len] = '\0';
+}
 
-    // string_substr()
-    assert(string_equal(string_substr(  str_lit("hello"), 0, 5),    str_lit("hello"))   );
-    assert(string_equal(string_substr(  str_lit("hello"), 0, 0),    str_lit(""))        );
-    assert(string_equal(string_substr(  str_lit("hello"), -1, 5),   str_lit("o"))       );
-    assert(string_equal(string_substr(  str_lit("hello"), -2, -1),  str_lit("l"))       );
+void
+builder_append_resp_simple_context(void * context, StringBuilder * builder, String string)
+{
+    builder_append_resp_line(context, builder, '+', string);
+}
 
-    // string_dup()
-    String dup_str = string_dup(str_lit("hello"));
-    assert(string_equal(dup_str, str_lit("hello")));
-    PMK_FREE(NULL, dup_str.data);
+void
+builder_append_resp_error_context(void * context, StringBuilder * builder, String string)
+{
+    builder_append_resp_line(context, builder, '-', string);
+}
 
-    // string_trim()
-    assert(string_equal(string_trim(str_lit("  good morning \n \t ")), str_lit("good morning")));
-    assert(string_equal(string_trim(str_lit("  ")), str_lit("")));
+void
+builder_append_resp_int_context(void * context, StringBuilder * builder, s64 n)
+{
+    builder_append_header(context, builder, ':', n, (String) {0}, 0);
+}
 
-    // string_char()
-    assert(string_char(str_lit("hello"), 'l') == 2);
-    assert(string_char(str_lit("hello"), 'x') == 5);
-    assert(string_char(str_lit(""), 'x') == 0);
+void
+builder_append_resp_bulk_context(void * context, StringBuilder * builder, String string)
+{
+    builder_append_header(context, builder, '$', string.len, string, 1);
+}
 
-    // string_rchar()
-    assert(string_rchar(str_lit("hello"), 'l') == 3);
-    assert(string_rchar(str_lit("hello"), 'x') == 5);
-    assert(string_rchar(str_lit(""), 'x') == 0);
+void
+builder_append_resp_null_context(void * context, StringBuilder * builder)
+{
+    builder_append_header(context, builder, '$', -1, (String) {0}, 0);
+}
 
-    // string_span()
-    assert(string_span(     str_lit("good morning"),    str_lit("gdX o"))    == 5   );
-    assert(string_span(     str_lit("good morning"),    str_lit("gn mrodi")) == 12  );
-    assert(string_span(     str_lit("good morning"),    str_lit("XYZ"))      == 0   );
-    assert(string_span(     str_lit("good morning"),    str_lit(""))         == 0   );
-    assert(string_span(     str_lit(""),                str_lit("abc"))      == 0   );
+void
+builder_append_resp_array_context(void * context, StringBuilder * builder, s32 count)
+{
+    builder_append_header(context, builder, '*', count, (String) {0}, 0);
+}
 
-    // string_cspan()
-    assert(string_cspan(    str_lit("good morning"),    str_lit("mr"))      == 5    );
-    assert(string_cspan(    str_lit("good morning"),    str_lit("abc"))     == 12   );
-    assert(string_cspan(    str_lit("good morning"),    str_lit("Xg"))      == 0    );
-    assert(string_cspan(    str_lit("good morning"),    str_lit(""))        == 12   );
-    assert(string_cspan(    str_lit(""),                str_lit("abc"))     == 0    );
+void
+builder_append_netstring_context(void * context, StringBuilder * builder, String string)
+{
+    char buf[20];
+    s32 i = format_int(buf, string.len);
+    s32 extra = (20 - i) + 1 + string.len + 1;
+    builder_grow(context, builder, extra);
+    char * dst = builder->data + builder->len;
+    memcpy(dst, buf + i, 20 - i);
+    dst += 20 - i;
+    *dst++ = ':';
+    if (string.len > 0)
+        memcpy(dst, string.data, string.len);
+    dst += string.len;
+    *dst++ = ',';
+    builder->len += extra;
+    builder->data[builder->len] = '\0';
+}
 
-    // string_find()
-    assert(string_find(     str_lit("good morning"),    str_lit("morn"))    == 5    );
-    assert(string_find(     str_lit("good morning"),    str_lit("fish"))    == 12   );
-    assert(string_find(     str_lit("good morning"),    str_lit(""))        == 0    );
-    assert(string_find(     str_lit(""),                str_lit("fish"))    == 0    );
-    assert(string_find(     str_lit(""),                str_lit(""))        == 0    );
+// 4-byte big-endian length followed by the payload
+void
+builder_append_frame_context(void * context, StringBuilder * builder, String string)
+{
+    builder_grow(context, builder, 4 + string.len);
+    u8 * dst = (u8 *) builder->data + builder->len;
+    u32 len = (u32) string.len;
+    dst[0] = (u8) (len >> 24);
+    dst[1] = (u8) (len >> 16);
+    dst[2] = (u8) (len >>  8);
+    dst[3] = (u8) (len      );
+    if (string.len > 0)
+        memcpy(dst + 4, string.data, string.len);
+    builder->len += 4 + string.len;
+    builder->data[builder->len] = '\0';
+}
 
-    // string_break()
-    assert(string_equal(string_break(   str_lit("good morning"),    str_lit("mr")) , str_lit("morning")));
-    assert(string_equal(string_break(   str_lit("good morning"),    str_lit("abc")), str_lit("")));
-    assert(string_equal(string_break(   str_lit("good morning"),    str_lit("Xg")) , str_lit("good morning")));
-    assert(string_equal(string_break(   str_lit("good morning"),    str_lit(""))   , str_lit("")));
-    assert(string_equal(string_break(   str_lit(""),                str_lit("abc")), str_lit("")));
+void
+builder_append_sort_key_context(void * context, StringBuilder * builder, String string, int flags)
+{
+    builder_grow(context, builder, string.len);
+    for (s32 i = 0; i < string.len; ) {
+        u8 c = (u8) string.data[i];
+        if (!(flags & SORT_KEY_NATURAL) || c < '0' || c > '9') {
+            if ((flags & SORT_KEY_FOLD_CASE) && c >= 'A' && c <= 'Z')
+                c += 'a' - 'A';
+            builder->data[builder->len++] = (char) c;
+            i++;
+            continue;
+        }
+        s32 end = i;
+        while (end < string.len && string.data[end] >= '0' && string.data[end] <= '9')
+            end++;
+        while (i < end && string.data[i] == '0')
+            i++;
+        s32 ndigits = end - i;
+        // room for the marker, the length and the digits, and a byte for each
+        // byte after the run
+        builder_grow(context, builder, 5 + ndigits + string.len - end);
+        u8 * dst = (u8 *) builder->data + builder->len;
+        *dst++ = '0';
+        if (ndigits < 255) {
+            *dst++ = (u8) ndigits;
+        } else {
+            *dst++ = 0xff;
+            *dst++ = (u8) (ndigits >> 24);
+            *dst++ = (u8) (ndigits >> 16);
+            *dst++ = (u8) (ndigits >>  8);
+            *dst++ = (u8) (ndigits      );
+        }
+        memcpy(dst, string.data + i, ndigits);
+        builder->len = (s32) (dst + ndigits - (u8 *) builder->data);
+        i = end;
+    }
+    builder->data[builder->len] = '\0';
+}
 
-    // string_tokenize()
-    {
-        String input = str_lit("  good \t morning \t ");
-        String delim = str_lit(" \t");
-        s32 save = 0;
-        assert(string_equal(string_tokenize(input, delim, &save), str_lit("good")));
-        assert(string_equal(string_tokenize(input, delim, &save), str_lit("morning")));
+// parses a decimal integer terminated by \r\n starting at buf.data[*pos];
+// same return convention as the decoders
+static int
+resp_parse_line_int(String buf, s32 * pos, s64 * result)
+{
+    s32 i = *pos;
+    int neg = 0;
+    u64 n = 0;
+    s32 ndigits = 0;
+    if (i < buf.len && buf.data[i] == '-') {
+        neg = 1;
+        i++;
+    }
+    // 19 digits cannot overflow a u64, so the range check can wait
+    for (; i < buf.len && isdigit((unsigned char) buf.data[i]); i++) {
+        if (++ndigits > 19)
+            return -EINVAL;
+        n = n * 10 + (u64) (buf.data[i] - '0');
     }
+    if (n > (u64) INT64_MAX + neg)
+        return -EINVAL;
+    if (i + 2 > buf.len)
+        return 0;
+    if (ndigits == 0 || buf.data[i] != '\r' || buf.data[i+1] != '\n')
+        return -EINVAL;
+    *result = (neg && n > 0) ? -(s64) (n - 1) - 1 : (s64) n;
+    *pos = i + 2;
+    return 1;
+}
 
-    // string_tr()
-    {
-        char cstring[] = "feet, seen, ten";
-        String string = str_lit(cstring);
-        string_tr(string, 'e', 'o');
-        assert(string_equal(string, str_lit("foot, soon, ton")));
+// parses one RESP header (and the payload for simple types and bulk strings)
+static int
+resp_parse_one(String buf, s32 * pos, RespValue * value)
+{
+    s32 i = *pos;
+    if (i >= buf.len)
+        return 0;
+    char type = buf.data[i++];
+    int rc;
+    switch (type) {
+        case '+':
+        case '-': {
+            String rest = string_substr(buf, i, buf.len);
+            s32 nl = string_char(rest, '\n');
+            if (nl == rest.len)
+                return 0;
+            if (nl == 0 || rest.data[nl-1] != '\r')
+                return -EINVAL;
+            value->type = type;
+            value->integer = 0;
+            value->string = string_substr(rest, 0, nl-1);
+            *pos = i + nl + 1;
+            return 1;
+        }
+        case ':':
+        case '*':
+            if ((rc = resp_parse_line_int(buf, &i, &value->integer)) <= 0)
+                return rc;
+            if (type == '*' && (value->integer < -1 || value->integer > INT32_MAX))
+                return -EINVAL;
+            value->type = type;
+            value->string = (String) { .data = buf.data + i, .len = 0 };
+            *pos = i;
+            return 1;
+        case '$':
+            if ((rc = resp_parse_line_int(buf, &i, &value->integer)) <= 0)
+                return rc;
+            if (value->integer < -1 || value->integer > INT32_MAX - 2)
+                return -EINVAL;
+            value->type = type;
+            value->string = (String) { .data = buf.data + i, .len = 0 };
+            if (value->integer == -1) {
+                *pos = i;
+                return 1;
+            }
+            if ((s64) buf.len - i < value->integer + 2)
+                return 0;
+            value->string.len = (s32) value->integer;
+            i += value->string.len;
+            if (buf.data[i] != '\r' || buf.data[i+1] != '\n')
+                return -EINVAL;
+            *pos = i + 2;
+            return 1;
+        default:
+            return -EINVAL;
     }
+}
 
-    // string_toupper(), string_tolower()
-    {
-        char cstring[] = "Good morning";
-        String string = str_lit(cstring);
-        string_toupper(string);
-        assert(string_equal(string, str_lit("GOOD MORNING")));
-        string_tolower(string);
-        assert(string_equal(string, str_lit("good morning")));
+int
+string_decode_resp(String buf, s32 * pos, RespValue * value)
+{
+    s32 i = *pos;
+    int rc = resp_parse_one(buf, &i, value);
+    if (rc <= 0 || value->type != '*' || value->integer <= 0) {
+        if (rc > 0)
+            *pos = i;
+        return rc;
+    }
+
+    // skip the elements without recursing so that deeply nested arrays
+    // cannot exhaust the stack
+    s64 remaining = value->integer;
+    while (remaining > 0) {
+        RespValue element;
+        if (remaining > buf.len - i)
+            return 0; // every element takes at least one byte
+        if ((rc = resp_parse_one(buf, &i, &element)) <= 0)
+            return rc;
+        remaining--;
+        if (element.type == '*' && element.integer > 0)
+            remaining += element.integer;
+    }
+    value->string.len = (s32) (buf.data + i - value->string.data);
+    *pos = i;
+    return 1;
+}
+
+int
+string_decode_netstring(String buf, s32 * pos, String * value)
+{
+    s32 i = *pos;
+    s64 len = 0;
+    s32 ndigits = 0;
+    for (; i < buf.len && isdigit((unsigned char) buf.data[i]); i++) {
+        if (++ndigits > 10)
+            return -EINVAL;
+        len = len * 10 + (buf.data[i] - '0');
+    }
+    if (i == buf.len)
+        return 0;
+    if (ndigits == 0 || buf.data[i] != ':' || len > INT32_MAX - 1)
+        return -EINVAL;
+    if (ndigits > 1 && buf.data[*pos] == '0')
+        return -EINVAL; // leading zeros are not allowed
+    i++;
+    if ((s64) buf.len - i < len + 1)
+        return 0;
+    if (buf.data[i + len] != ',')
+        return -EINVAL;
+    *value = (String) { .data = buf.data + i, .len = (s32) len };
+    *pos = i + (s32) len + 1;
+    return 1;
+}
+
+int
+string_decode_frame(String buf, s32 * pos, String * value)
+{
+    s32 i = *pos;
+    if (buf.len - i < 4)
+        return 0;
+    const u8 * p = (const u8 *) buf.data + i;
+    u32 len = ((u32) p[0] << 24) | ((u32) p[1] << 16) | ((u32) p[2] << 8) | (u32) p[3];
+    if (len > INT32_MAX - 4)
+        return -EINVAL;
+    if ((s64) buf.len - i - 4 < len)
+        return 0;
+    *value = (String) { .data = buf.data + i + 4, .len = (s32) len };
+    *pos = i + 4 + (s32) len;
+    return 1;
+}
+
+static s32
+varint_len(u64 n)
+{
+    return 1 + (63 - clz64(n | 1)) / 7;
+}
+
+// dst must have room for varint_len(n) bytes
+static s32
+encode_varint(u8 * dst, u64 n)
+{
+    s32 i = 0;
+    while (n >= 0x80) {
+        dst[i++] = (u8) (n | 0x80);
+        n >>= 7;
+    }
+    dst[i++] = (u8) n;
+    return i;
+}
+
+void
+builder_append_varint_u64_context(void * context, StringBuilder * builder, u64 n)
+{
+    builder_grow(context, builder, varint_len(n));
+    builder->len += encode_varint((u8 *) builder->data + builder->len, n);
+    builder->data[builder->len] = '\0';
+}
+
+void
+builder_append_lp_string_context(void * context, StringBuilder * builder, String string)
+{
+    builder_append_lp_strings_context(context, builder, &string, 1);
+}
+
+// reserves once for the whole array
+void
+builder_append_lp_strings_context(void * context, StringBuilder * builder, const String * strings, s32 count)
+{
+    s64 total = 0;
+    for (s32 i = 0; i < count; i++)
+        total += varint_len(strings[i].len) + strings[i].len;
+    assert(builder->len + total < INT32_MAX);
+    builder_grow(context, builder, (s32) total);
+
+    u8 * dst = (u8 *) builder->data + builder->len;
+    for (s32 i = 0; i < count; i++) {
+        dst += encode_varint(dst, strings[i].len);
+        memcpy(dst, strings[i].data, strings[i].len);
+        dst += strings[i].len;
+    }
+    builder->len += (s32) total;
+    builder->data[builder->len] = '\0';
+}
+
+int
+reader_read_varint(StringReader * reader, u64 * value)
+{
+    const u8 * p = (const u8 *) reader->string.data + reader->pos;
+    s32 avail = reader->string.len - reader->pos;
+
+    // fast path: with 8 readable bytes, a varint of up to 8 bytes is decoded
+    // without branching on each byte by gathering the 7-bit groups in place
+    if (avail >= 8) {
+        u64 w = load_u64_le(p);
+        u64 stops = ~w & 0x8080808080808080ULL;
+        if (stops) {
+            u64 x = w & (stops ^ (stops - 1)) & 0x7f7f7f7f7f7f7f7fULL;
+            x = ((x & 0x7f007f007f007f00ULL) >> 1) | (x & 0x007f007f007f007fULL);
+            x = ((x & 0x3fff00003fff0000ULL) >> 2) | (x & 0x00003fff00003fffULL);
+            x = ((x & 0x0fffffff00000000ULL) >> 4) | (x & 0x000000000fffffffULL);
+            *value = x;
+            reader->pos += (ctz64(stops) >> 3) + 1;
+            return 0;
+        }
+    }
+
+    u64 result = 0;
+    for (s32 i = 0; i < avail && i < 10; i++) {
+        u64 byte = p[i];
+        if (i == 9 && byte > 1)
+            return -EINVAL; // more than 64 bits
+        result |= (byte & 0x7f) << (7 * i);
+        if (!(byte & 0x80)) {
+            *value = result;
+            reader->pos += i + 1;
+            return 0;
+        }
+    }
+    return -EINVAL;
+}
+
+int
+reader_read_lp_string(StringReader * reader, String * value)
+{
+    s32 orig_pos = reader->pos;
+    u64 len;
+    if (reader_read_varint(reader, &len) < 0)
+        return -EINVAL;
+    if (len > (u64) (reader->string.len - reader->pos)) {
+        reader->pos = orig_pos;
+        return -EINVAL;
+    }
+    *value = (String) { .data = reader->string.data + reader->pos, .len = (s32) len };
+    reader->pos += (s32) len;
+    return 0;
+}
+
+#define CRC32C_POLY 0x82f63b78u // reflected
+
+// the hardware path splits long inputs into three streams of these sizes
+#define CRC32C_LONG  8192
+#define CRC32C_SHORT 256
+
+// constant rather than built on first use, so that concurrent callers need
+// no synchronization; crc32c_table[k][n] is the CRC register after byte n
+// followed by k zero bytes, for slicing-by-8
+static const u32 crc32c_table[8][256] = {
+    {
+        0x00000000u, 0xf26b8303u, 0xe13b70f7u, 0x1350f3f4u, 0xc79a971fu, 0x35f1141cu,
+        0x26a1e7e8u, 0xd4ca64ebu, 0x8ad958cfu, 0x78b2dbccu, 0x6be22838u, 0x9989ab3bu,
+        0x4d43cfd0u, 0xbf284cd3u, 0xac78bf27u, 0x5e133c24u, 0x105ec76fu, 0xe235446cu,
+        0xf165b798u, 0x030e349bu, 0xd7c45070u, 0x25afd373u, 0x36ff2087u, 0xc494a384u,
+        0x9a879fa0u, 0x68ec1ca3u, 0x7bbcef57u, 0x89d76c54u, 0x5d1d08bfu, 0xaf768bbcu,
+        0xbc267848u, 0x4e4dfb4bu, 0x20bd8edeu, 0xd2d60dddu, 0xc186fe29u, 0x33ed7d2au,
+        0xe72719c1u, 0x154c9ac2u, 0x061c6936u, 0xf477ea35u, 0xaa64d611u, 0x580f5512u,
+        0x4b5fa6e6u, 0xb93425e5u, 0x6dfe410eu, 0x9f95c20du, 0x8cc531f9u, 0x7eaeb2fau,
+        0x30e349b1u, 0xc288cab2u, 0xd1d83946u, 0x23b3ba45u, 0xf779deaeu, 0x05125dadu,
+        0x1642ae59u, 0xe4292d5au, 0xba3a117eu, 0x4851927du, 0x5b016189u, 0xa96ae28au,
+        0x7da08661u, 0x8fcb0562u, 0x9c9bf696u, 0x6ef07595u, 0x417b1dbcu, 0xb3109ebfu,
+        0xa0406d4bu, 0x522bee48u, 0x86e18aa3u, 0x748a09a0u, 0x67dafa54u, 0x95b17957u,
+        0xcba24573u, 0x39c9c670u, 0x2a993584u, 0xd8f2b687u, 0x0c38d26cu, 0xfe53516fu,
+        0xed03a29bu, 0x1f682198u, 0x5125dad3u, 0xa34e59d0u, 0xb01eaa24u, 0x42752927u,
+        0x96bf4dccu, 0x64d4cecfu, 0x77843d3bu, 0x85efbe38u, 0xdbfc821cu, 0x2997011fu,
+        0x3ac7f2ebu, 0xc8ac71e8u, 0x1c661503u, 0xee0d9600u, 0xfd5d65f4u, 0x0f36e6f7u,
+        0x61c69362u, 0x93ad1061u, 0x80fde395u, 0x72966096u, 0xa65c047du, 0x5437877eu,
+        0x4767748au, 0xb50cf789u, 0xeb1fcbadu, 0x197448aeu, 0x0a24bb5au, 0xf84f3859u,
+        0x2c855cb2u, 0xdeeedfb1u, 0xcdbe2c45u, 0x3fd5af46u, 0x7198540du, 0x83f3d70eu,
+        0x90a324fau, 0x62c8a7f9u, 0xb602c312u, 0x44694011u, 0x5739b3e5u, 0xa55230e6u,
+        0xfb410cc2u, 0x092a8fc1u, 0x1a7a7c35u, 0xe811ff36u, 0x3cdb9bddu, 0xceb018deu,
+        0xdde0eb2au, 0x2f8b6829u, 0x82f63b78u, 0x709db87bu, 0x63cd4b8fu, 0x91a6c88cu,
+        0x456cac67u, 0xb7072f64u, 0xa457dc90u, 0x563c5f93u, 0x082f63b7u, 0xfa44e0b4u,
+        0xe9141340u, 0x1b7f9043u, 0xcfb5f4a8u, 0x3dde77abu, 0x2e8e845fu, 0xdce5075cu,
+        0x92a8fc17u, 0x60c37f14u, 0x73938ce0u, 0x81f80fe3u, 0x55326b08u, 0xa759e80bu,
+        0xb4091bffu, 0x466298fcu, 0x1871a4d8u, 0xea1a27dbu, 0xf94ad42fu, 0x0b21572cu,
+        0xdfeb33c7u, 0x2d80b0c4u, 0x3ed04330u, 0xccbbc033u, 0xa24bb5a6u, 0x502036a5u,
+        0x4370c551u, 0xb11b4652u, 0x65d122b9u, 0x97baa1bau, 0x84ea524eu, 0x7681d14du,
+        0x2892ed69u, 0xdaf96e6au, 0xc9a99d9eu, 0x3bc21e9du, 0xef087a76u, 0x1d63f975u,
+        0x0e330a81u, 0xfc588982u, 0xb21572c9u, 0x407ef1cau, 0x532e023eu, 0xa145813du,
+        0x758fe5d6u, 0x87e466d5u, 0x94b49521u, 0x66df1622u, 0x38cc2a06u, 0xcaa7a905u,
+        0xd9f75af1u, 0x2b9cd9f2u, 0xff56bd19u, 0x0d3d3e1au, 0x1e6dcdeeu, 0xec064eedu,
+        0xc38d26c4u, 0x31e6a5c7u, 0x22b65633u, 0xd0ddd530u, 0x0417b1dbu, 0xf67c32d8u,
+        0xe52cc12cu, 0x1747422fu, 0x49547e0bu, 0xbb3ffd08u, 0xa86f0efcu, 0x5a048dffu,
+        0x8ecee914u, 0x7ca56a17u, 0x6ff599e3u, 0x9d9e1ae0u, 0xd3d3e1abu, 0x21b862a8u,
+        0x32e8915cu, 0xc083125fu, 0x144976b4u, 0xe622f5b7u, 0xf5720643u, 0x07198540u,
+        0x590ab964u, 0xab613a67u, 0xb831c993u, 0x4a5a4a90u, 0x9e902e7bu, 0x6cfbad78u,
+        0x7fab5e8cu, 0x8dc0dd8fu, 0xe330a81au, 0x115b2b19u, 0x020bd8edu, 0xf0605beeu,
+        0x24aa3f05u, 0xd6c1bc06u, 0xc5914ff2u, 0x37faccf1u, 0x69e9f0d5u, 0x9b8273d6u,
+        0x88d28022u, 0x7ab90321u, 0xae7367cau, 0x5c18e4c9u, 0x4f48173du, 0xbd23943eu,
+        0xf36e6f75u, 0x0105ec76u, 0x12551f82u, 0xe03e9c81u, 0x34f4f86au, 0xc69f7b69u,
+        0xd5cf889du, 0x27a40b9eu, 0x79b737bau, 0x8bdcb4b9u, 0x988c474du, 0x6ae7c44eu,
+        0xbe2da0a5u, 0x4c4623a6u, 0x5f16d052u, 0xad7d5351u
+    },
+    {
+        0x00000000u, 0x13a29877u, 0x274530eeu, 0x34e7a899u, 0x4e8a61dcu, 0x5d28f9abu,
+        0x69cf5132u, 0x7a6dc945u, 0x9d14c3b8u, 0x8eb65bcfu, 0xba51f356u, 0xa9f36b21u,
+        0xd39ea264u, 0xc03c3a13u, 0xf4db928au, 0xe7790afdu, 0x3fc5f181u, 0x2c6769f6u,
+        0x1880c16fu, 0x0b225918u, 0x714f905du, 0x62ed082au, 0x560aa0b3u, 0x45a838c4u,
+        0xa2d13239u, 0xb173aa4eu, 0x859402d7u, 0x96369aa0u, 0xec5b53e5u, 0xfff9cb92u,
+        0xcb1e630bu, 0xd8bcfb7cu, 0x7f8be302u, 0x6c297b75u, 0x58ced3ecu, 0x4b6c4b9bu,
+        0x310182deu, 0x22a31aa9u, 0x1644b230u, 0x05e62a47u, 0xe29f20bau, 0xf13db8cdu,
+        0xc5da1054u, 0xd6788823u, 0xac154166u, 0xbfb7d911u, 0x8b507188u, 0x98f2e9ffu,
+        0x404e1283u, 0x53ec8af4u, 0x670b226du, 0x74a9ba1au, 0x0ec4735fu, 0x1d66eb28u,
+        0x298143b1u, 0x3a23dbc6u, 0xdd5ad13bu, 0xcef8494cu, 0xfa1fe1d5u, 0xe9bd79a2u,
+        0x93d0b0e7u, 0x80722890u, 0xb4958009u, 0xa737187eu, 0xff17c604u, 0xecb55e73u,
+        0xd852f6eau, 0xcbf06e9du, 0xb19da7d8u, 0xa23f3fafu, 0x96d89736u, 0x857a0f41u,
+        0x620305bcu, 0x71a19dcbu, 0x45463552u, 0x56e4ad25u, 0x2c896460u, 0x3f2bfc17u,
+        0x0bcc548eu, 0x186eccf9u, 0xc0d23785u, 0xd370aff2u, 0xe797076bu, 0xf4359f1cu,
+        0x8e585659u, 0x9dface2eu, 0xa91d66b7u, 0xbabffec0u, 0x5dc6f43du, 0x4e646c4au,
+        0x7a83c4d3u, 0x69215ca4u, 0x134c95e1u, 0x00ee0d96u, 0x3409a50fu, 0x27ab3d78u,
+        0x809c2506u, 0x933ebd71u, 0xa7d915e8u, 0xb47b8d9fu, 0xce1644dau, 0xddb4dcadu,
+        0xe9537434u, 0xfaf1ec43u, 0x1d88e6beu, 0x0e2a7ec9u, 0x3acdd650u, 0x296f4e27u,
+        0x53028762u, 0x40a01f15u, 0x7447b78cu, 0x67e52ffbu, 0xbf59d487u, 0xacfb4cf0u,
+        0x981ce469u, 0x8bbe7c1eu, 0xf1d3b55bu, 0xe2712d2cu, 0xd69685b5u, 0xc5341dc2u,
+        0x224d173fu, 0x31ef8f48u, 0x050827d1u, 0x16aabfa6u, 0x6cc776e3u, 0x7f65ee94u,
+        0x4b82460du, 0x5820de7au, 0xfbc3faf9u, 0xe861628eu, 0xdc86ca17u, 0xcf245260u,
+        0xb5499b25u, 0xa6eb0352u, 0x920cabcbu, 0x81ae33bcu, 0x66d73941u, 0x7575a136u,
+        0x419209afu, 0x523091d8u, 0x285d589du, 0x3bffc0eau, 0x0f186873u, 0x1cbaf004u,
+        0xc4060b78u, 0xd7a4930fu, 0xe3433b96u, 0xf0e1a3e1u, 0x8a8c6aa4u, 0x992ef2d3u,
+        0xadc95a4au, 0xbe6bc23du, 0x5912c8c0u, 0x4ab050b7u, 0x7e57f82eu, 0x6df56059u,
+        0x1798a91cu, 0x043a316bu, 0x30dd99f2u, 0x237f0185u, 0x844819fbu, 0x97ea818cu,
+        0xa30d2915u, 0xb0afb162u, 0xcac27827u, 0xd960e050u, 0xed8748c9u, 0xfe25d0beu,
+        0x195cda43u, 0x0afe4234u, 0x3e19eaadu, 0x2dbb72dau, 0x57d6bb9fu, 0x447423e8u,
+        0x70938b71u, 0x63311306u, 0xbb8de87au, 0xa82f700du, 0x9cc8d894u, 0x8f6a40e3u,
+        0xf50789a6u, 0xe6a511d1u, 0xd242b948u, 0xc1e0213fu, 0x26992bc2u, 0x353bb3b5u,
+        0x01dc1b2cu, 0x127e835bu, 0x68134a1eu, 0x7bb1d269u, 0x4f567af0u, 0x5cf4e287u,
+        0x04d43cfdu, 0x1776a48au, 0x23910c13u, 0x30339464u, 0x4a5e5d21u, 0x59fcc556u,
+        0x6d1b6dcfu, 0x7eb9f5b8u, 0x99c0ff45u, 0x8a626732u, 0xbe85cfabu, 0xad2757dcu,
+        0xd74a9e99u, 0xc4e806eeu, 0xf00fae77u, 0xe3ad3600u, 0x3b11cd7cu, 0x28b3550bu,
+        0x1c54fd92u, 0x0ff665e5u, 0x759baca0u, 0x663934d7u, 0x52de9c4eu, 0x417c0439u,
+        0xa6050ec4u, 0xb5a796b3u, 0x81403e2au, 0x92e2a65du, 0xe88f6f18u, 0xfb2df76fu,
+        0xcfca5ff6u, 0xdc68c781u, 0x7b5fdfffu, 0x68fd4788u, 0x5c1aef11u, 0x4fb87766u,
+        0x35d5be23u, 0x26772654u, 0x12908ecdu, 0x013216bau, 0xe64b1c47u, 0xf5e98430u,
+        0xc10e2ca9u, 0xd2acb4deu, 0xa8c17d9bu, 0xbb63e5ecu, 0x8f844d75u, 0x9c26d502u,
+        0x449a2e7eu, 0x5738b609u, 0x63df1e90u, 0x707d86e7u, 0x0a104fa2u, 0x19b2d7d5u,
+        0x2d557f4cu, 0x3ef7e73bu, 0xd98eedc6u, 0xca2c75b1u, 0xfecbdd28u, 0xed69455fu,
+        0x97048c1au, 0x84a6146du, 0xb041bcf4u, 0xa3e32483u
+    },
+    {
+        0x00000000u, 0xa541927eu, 0x4f6f520du, 0xea2ec073u, 0x9edea41au, 0x3b9f3664u,
+        0xd1b1f617u, 0x74f06469u, 0x38513ec5u, 0x9d10acbbu, 0x773e6cc8u, 0xd27ffeb6u,
+        0xa68f9adfu, 0x03ce08a1u, 0xe9e0c8d2u, 0x4ca15aacu, 0x70a27d8au, 0xd5e3eff4u,
+        0x3fcd2f87u, 0x9a8cbdf9u, 0xee7cd990u, 0x4b3d4beeu, 0xa1138b9du, 0x045219e3u,
+        0x48f3434fu, 0xedb2d131u, 0x079c1142u, 0xa2dd833cu, 0xd62de755u, 0x736c752bu,
+        0x9942b558u, 0x3c032726u, 0xe144fb14u, 0x4405696au, 0xae2ba919u, 0x0b6a3b67u,
+        0x7f9a5f0eu, 0xdadbcd70u, 0x30f50d03u, 0x95b49f7du, 0xd915c5d1u, 0x7c5457afu,
+        0x967a97dcu, 0x333b05a2u, 0x47cb61cbu, 0xe28af3b5u, 0x08a433c6u, 0xade5a1b8u,
+        0x91e6869eu, 0x34a714e0u, 0xde89d493u, 0x7bc846edu, 0x0f382284u, 0xaa79b0fau,
+        0x40577089u, 0xe516e2f7u, 0xa9b7b85bu, 0x0cf62a25u, 0xe6d8ea56u, 0x43997828u,
+        0x37691c41u, 0x92288e3fu, 0x78064e4cu, 0xdd47dc32u, 0xc76580d9u, 0x622412a7u,
+        0x880ad2d4u, 0x2d4b40aau, 0x59bb24c3u, 0xfcfab6bdu, 0x16d476ceu, 0xb395e4b0u,
+        0xff34be1cu, 0x5a752c62u, 0xb05bec11u, 0x151a7e6fu, 0x61ea1a06u, 0xc4ab8878u,
+        0x2e85480bu, 0x8bc4da75u, 0xb7c7fd53u, 0x12866f2du, 0xf8a8af5eu, 0x5de93d20u,
+        0x29195949u, 0x8c58cb37u, 0x66760b44u, 0xc337993au, 0x8f96c396u, 0x2ad751e8u,
+        0xc0f9919bu, 0x65b803e5u, 0x1148678cu, 0xb409f5f2u, 0x5e273581u, 0xfb66a7ffu,
+        0x26217bcdu, 0x8360e9b3u, 0x694e29c0u, 0xcc0fbbbeu, 0xb8ffdfd7u, 0x1dbe4da9u,
+        0xf7908ddau, 0x52d11fa4u, 0x1e704508u, 0xbb31d776u, 0x511f1705u, 0xf45e857bu,
+        0x80aee112u, 0x25ef736cu, 0xcfc1b31fu, 0x6a802161u, 0x56830647u, 0xf3c29439u,
+        0x19ec544au, 0xbcadc634u, 0xc85da25du, 0x6d1c3023u, 0x8732f050u, 0x2273622eu,
+        0x6ed23882u, 0xcb93aafcu, 0x21bd6a8fu, 0x84fcf8f1u, 0xf00c9c98u, 0x554d0ee6u,
+        0xbf63ce95u, 0x1a225cebu, 0x8b277743u, 0x2e66e53du, 0xc448254eu, 0x6109b730u,
+        0x15f9d359u, 0xb0b84127u, 0x5a968154u, 0xffd7132au, 0xb3764986u, 0x1637dbf8u,
+        0xfc191b8bu, 0x595889f5u, 0x2da8ed9cu, 0x88e97fe2u, 0x62c7bf91u, 0xc7862defu,
+        0xfb850ac9u, 0x5ec498b7u, 0xb4ea58c4u, 0x11abcabau, 0x655baed3u, 0xc01a3cadu,
+        0x2a34fcdeu, 0x8f756ea0u, 0xc3d4340cu, 0x6695a672u, 0x8cbb6601u, 0x29faf47fu,
+        0x5d0a9016u, 0xf84b0268u, 0x1265c21bu, 0xb7245065u, 0x6a638c57u, 0xcf221e29u,
+        0x250cde5au, 0x804d4c24u, 0xf4bd284du, 0x51fcba33u, 0xbbd27a40u, 0x1e93e83eu,
+        0x5232b292u, 0xf77320ecu, 0x1d5de09fu, 0xb81c72e1u, 0xccec1688u, 0x69ad84f6u,
+        0x83834485u, 0x26c2d6fbu, 0x1ac1f1ddu, 0xbf8063a3u, 0x55aea3d0u, 0xf0ef31aeu,
+        0x841f55c7u, 0x215ec7b9u, 0xcb7007cau, 0x6e3195b4u, 0x2290cf18u, 0x87d15d66u,
+        0x6dff9d15u, 0xc8be0f6bu, 0xbc4e6b02u, 0x190ff97cu, 0xf321390fu, 0x5660ab71u,
+        0x4c42f79au, 0xe90365e4u, 0x032da597u, 0xa66c37e9u, 0xd29c5380u, 0x77ddc1feu,
+        0x9df3018du, 0x38b293f3u, 0x7413c95fu, 0xd1525b21u, 0x3b7c9b52u, 0x9e3d092cu,
+        0xeacd6d45u, 0x4f8cff3bu, 0xa5a23f48u, 0x00e3ad36u, 0x3ce08a10u, 0x99a1186eu,
+        0x738fd81du, 0xd6ce4a63u, 0xa23e2e0au, 0x077fbc74u, 0xed517c07u, 0x4810ee79u,
+        0x04b1b4d5u, 0xa1f026abu, 0x4bdee6d8u, 0xee9f74a6u, 0x9a6f10cfu, 0x3f2e82b1u,
+        0xd50042c2u, 0x7041d0bcu, 0xad060c8eu, 0x08479ef0u, 0xe2695e83u, 0x4728ccfdu,
+        0x33d8a894u, 0x96993aeau, 0x7cb7fa99u, 0xd9f668e7u, 0x9557324bu, 0x3016a035u,
+        0xda386046u, 0x7f79f238u, 0x0b899651u, 0xaec8042fu, 0x44e6c45cu, 0xe1a75622u,
+        0xdda47104u, 0x78e5e37au, 0x92cb2309u, 0x378ab177u, 0x437ad51eu, 0xe63b4760u,
+        0x0c158713u, 0xa954156du, 0xe5f54fc1u, 0x40b4ddbfu, 0xaa9a1dccu, 0x0fdb8fb2u,
+        0x7b2bebdbu, 0xde6a79a5u, 0x3444b9d6u, 0x91052ba8u
+    },
+    {
+        0x00000000u, 0xdd45aab8u, 0xbf672381u, 0x62228939u, 0x7b2231f3u, 0xa6679b4bu,
+        0xc4451272u, 0x1900b8cau, 0xf64463e6u, 0x2b01c95eu, 0x49234067u, 0x9466eadfu,
+        0x8d665215u, 0x5023f8adu, 0x32017194u, 0xef44db2cu, 0xe964b13du, 0x34211b85u,
+        0x560392bcu, 0x8b463804u, 0x924680ceu, 0x4f032a76u, 0x2d21a34fu, 0xf06409f7u,
+        0x1f20d2dbu, 0xc2657863u, 0xa047f15au, 0x7d025be2u, 0x6402e328u, 0xb9474990u,
+        0xdb65c0a9u, 0x06206a11u, 0xd725148bu, 0x0a60be33u, 0x6842370au, 0xb5079db2u,
+        0xac072578u, 0x71428fc0u, 0x136006f9u, 0xce25ac41u, 0x2161776du, 0xfc24ddd5u,
+        0x9e0654ecu, 0x4343fe54u, 0x5a43469eu, 0x8706ec26u, 0xe524651fu, 0x3861cfa7u,
+        0x3e41a5b6u, 0xe3040f0eu, 0x81268637u, 0x5c632c8fu, 0x45639445u, 0x98263efdu,
+        0xfa04b7c4u, 0x27411d7cu, 0xc805c650u, 0x15406ce8u, 0x7762e5d1u, 0xaa274f69u,
+        0xb327f7a3u, 0x6e625d1bu, 0x0c40d422u, 0xd1057e9au, 0xaba65fe7u, 0x76e3f55fu,
+        0x14c17c66u, 0xc984d6deu, 0xd0846e14u, 0x0dc1c4acu, 0x6fe34d95u, 0xb2a6e72du,
+        0x5de23c01u, 0x80a796b9u, 0xe2851f80u, 0x3fc0b538u, 0x26c00df2u, 0xfb85a74au,
+        0x99a72e73u, 0x44e284cbu, 0x42c2eedau, 0x9f874462u, 0xfda5cd5bu, 0x20e067e3u,
+        0x39e0df29u, 0xe4a57591u, 0x8687fca8u, 0x5bc25610u, 0xb4868d3cu, 0x69c32784u,
+        0x0be1aebdu, 0xd6a40405u, 0xcfa4bccfu, 0x12e11677u, 0x70c39f4eu, 0xad8635f6u,
+        0x7c834b6cu, 0xa1c6e1d4u, 0xc3e468edu, 0x1ea1c255u, 0x07a17a9fu, 0xdae4d027u,
+        0xb8c6591eu, 0x6583f3a6u, 0x8ac7288au, 0x57828232u, 0x35a00b0bu, 0xe8e5a1b3u,
+        0xf1e51979u, 0x2ca0b3c1u, 0x4e823af8u, 0x93c79040u, 0x95e7fa51u, 0x48a250e9u,
+        0x2a80d9d0u, 0xf7c57368u, 0xeec5cba2u, 0x3380611au, 0x51a2e823u, 0x8ce7429bu,
+        0x63a399b7u, 0xbee6330fu, 0xdcc4ba36u, 0x0181108eu, 0x1881a844u, 0xc5c402fcu,
+        0xa7e68bc5u, 0x7aa3217du, 0x52a0c93fu, 0x8fe56387u, 0xedc7eabeu, 0x30824006u,
+        0x2982f8ccu, 0xf4c75274u, 0x96e5db4du, 0x4ba071f5u, 0xa4e4aad9u, 0x79a10061u,
+        0x1b838958u, 0xc6c623e0u, 0xdfc69b2au, 0x02833192u, 0x60a1b8abu, 0xbde41213u,
+        0xbbc47802u, 0x6681d2bau, 0x04a35b83u, 0xd9e6f13bu, 0xc0e649f1u, 0x1da3e349u,
+        0x7f816a70u, 0xa2c4c0c8u, 0x4d801be4u, 0x90c5b15cu, 0xf2e73865u, 0x2fa292ddu,
+        0x36a22a17u, 0xebe780afu, 0x89c50996u, 0x5480a32eu, 0x8585ddb4u, 0x58c0770cu,
+        0x3ae2fe35u, 0xe7a7548du, 0xfea7ec47u, 0x23e246ffu, 0x41c0cfc6u, 0x9c85657eu,
+        0x73c1be52u, 0xae8414eau, 0xcca69dd3u, 0x11e3376bu, 0x08e38fa1u, 0xd5a62519u,
+        0xb784ac20u, 0x6ac10698u, 0x6ce16c89u, 0xb1a4c631u, 0xd3864f08u, 0x0ec3e5b0u,
+        0x17c35d7au, 0xca86f7c2u, 0xa8a47efbu, 0x75e1d443u, 0x9aa50f6fu, 0x47e0a5d7u,
+        0x25c22ceeu, 0xf8878656u, 0xe1873e9cu, 0x3cc29424u, 0x5ee01d1du, 0x83a5b7a5u,
+        0xf90696d8u, 0x24433c60u, 0x4661b559u, 0x9b241fe1u, 0x8224a72bu, 0x5f610d93u,
+        0x3d4384aau, 0xe0062e12u, 0x0f42f53eu, 0xd2075f86u, 0xb025d6bfu, 0x6d607c07u,
+        0x7460c4cdu, 0xa9256e75u, 0xcb07e74cu, 0x16424df4u, 0x106227e5u, 0xcd278d5du,
+        0xaf050464u, 0x7240aedcu, 0x6b401616u, 0xb605bcaeu, 0xd4273597u, 0x09629f2fu,
+        0xe6264403u, 0x3b63eebbu, 0x59416782u, 0x8404cd3au, 0x9d0475f0u, 0x4041df48u,
+        0x22635671u, 0xff26fcc9u, 0x2e238253u, 0xf36628ebu, 0x9144a1d2u, 0x4c010b6au,
+        0x5501b3a0u, 0x88441918u, 0xea669021u, 0x37233a99u, 0xd867e1b5u, 0x05224b0du,
+        0x6700c234u, 0xba45688cu, 0xa345d046u, 0x7e007afeu, 0x1c22f3c7u, 0xc167597fu,
+        0xc747336eu, 0x1a0299d6u, 0x782010efu, 0xa565ba57u, 0xbc65029du, 0x6120a825u,
+        0x0302211cu, 0xde478ba4u, 0x31035088u, 0xec46fa30u, 0x8e647309u, 0x5321d9b1u,
+        0x4a21617bu, 0x9764cbc3u, 0xf54642fau, 0x2803e842u
+    },
+    {
+        0x00000000u, 0x38116facu, 0x7022df58u, 0x4833b0f4u, 0xe045beb0u, 0xd854d11cu,
+        0x906761e8u, 0xa8760e44u, 0xc5670b91u, 0xfd76643du, 0xb545d4c9u, 0x8d54bb65u,
+        0x2522b521u, 0x1d33da8du, 0x55006a79u, 0x6d1105d5u, 0x8f2261d3u, 0xb7330e7fu,
+        0xff00be8bu, 0xc711d127u, 0x6f67df63u, 0x5776b0cfu, 0x1f45003bu, 0x27546f97u,
+        0x4a456a42u, 0x725405eeu, 0x3a67b51au, 0x0276dab6u, 0xaa00d4f2u, 0x9211bb5eu,
+        0xda220baau, 0xe2336406u, 0x1ba8b557u, 0x23b9dafbu, 0x6b8a6a0fu, 0x539b05a3u,
+        0xfbed0be7u, 0xc3fc644bu, 0x8bcfd4bfu, 0xb3debb13u, 0xdecfbec6u, 0xe6ded16au,
+        0xaeed619eu, 0x96fc0e32u, 0x3e8a0076u, 0x069b6fdau, 0x4ea8df2eu, 0x76b9b082u,
+        0x948ad484u, 0xac9bbb28u, 0xe4a80bdcu, 0xdcb96470u, 0x74cf6a34u, 0x4cde0598u,
+        0x04edb56cu, 0x3cfcdac0u, 0x51eddf15u, 0x69fcb0b9u, 0x21cf004du, 0x19de6fe1u,
+        0xb1a861a5u, 0x89b90e09u, 0xc18abefdu, 0xf99bd151u, 0x37516aaeu, 0x0f400502u,
+        0x4773b5f6u, 0x7f62da5au, 0xd714d41eu, 0xef05bbb2u, 0xa7360b46u, 0x9f2764eau,
+        0xf236613fu, 0xca270e93u, 0x8214be67u, 0xba05d1cbu, 0x1273df8fu, 0x2a62b023u,
+        0x625100d7u, 0x5a406f7bu, 0xb8730b7du, 0x806264d1u, 0xc851d425u, 0xf040bb89u,
+        0x5836b5cdu, 0x6027da61u, 0x28146a95u, 0x10050539u, 0x7d1400ecu, 0x45056f40u,
+        0x0d36dfb4u, 0x3527b018u, 0x9d51be5cu, 0xa540d1f0u, 0xed736104u, 0xd5620ea8u,
+        0x2cf9dff9u, 0x14e8b055u, 0x5cdb00a1u, 0x64ca6f0du, 0xccbc6149u, 0xf4ad0ee5u,
+        0xbc9ebe11u, 0x848fd1bdu, 0xe99ed468u, 0xd18fbbc4u, 0x99bc0b30u, 0xa1ad649cu,
+        0x09db6ad8u, 0x31ca0574u, 0x79f9b580u, 0x41e8da2cu, 0xa3dbbe2au, 0x9bcad186u,
+        0xd3f96172u, 0xebe80edeu, 0x439e009au, 0x7b8f6f36u, 0x33bcdfc2u, 0x0badb06eu,
+        0x66bcb5bbu, 0x5eadda17u, 0x169e6ae3u, 0x2e8f054fu, 0x86f90b0bu, 0xbee864a7u,
+        0xf6dbd453u, 0xcecabbffu, 0x6ea2d55cu, 0x56b3baf0u, 0x1e800a04u, 0x269165a8u,
+        0x8ee76becu, 0xb6f60440u, 0xfec5b4b4u, 0xc6d4db18u, 0xabc5decdu, 0x93d4b161u,
+        0xdbe70195u, 0xe3f66e39u, 0x4b80607du, 0x73910fd1u, 0x3ba2bf25u, 0x03b3d089u,
+        0xe180b48fu, 0xd991db23u, 0x91a26bd7u, 0xa9b3047bu, 0x01c50a3fu, 0x39d46593u,
+        0x71e7d567u, 0x49f6bacbu, 0x24e7bf1eu, 0x1cf6d0b2u, 0x54c56046u, 0x6cd40feau,
+        0xc4a201aeu, 0xfcb36e02u, 0xb480def6u, 0x8c91b15au, 0x750a600bu, 0x4d1b0fa7u,
+        0x0528bf53u, 0x3d39d0ffu, 0x954fdebbu, 0xad5eb117u, 0xe56d01e3u, 0xdd7c6e4fu,
+        0xb06d6b9au, 0x887c0436u, 0xc04fb4c2u, 0xf85edb6eu, 0x5028d52au, 0x6839ba86u,
+        0x200a0a72u, 0x181b65deu, 0xfa2801d8u, 0xc2396e74u, 0x8a0ade80u, 0xb21bb12cu,
+        0x1a6dbf68u, 0x227cd0c4u, 0x6a4f6030u, 0x525e0f9cu, 0x3f4f0a49u, 0x075e65e5u,
+        0x4f6dd511u, 0x777cbabdu, 0xdf0ab4f9u, 0xe71bdb55u, 0xaf286ba1u, 0x9739040du,
+        0x59f3bff2u, 0x61e2d05eu, 0x29d160aau, 0x11c00f06u, 0xb9b60142u, 0x81a76eeeu,
+        0xc994de1au, 0xf185b1b6u, 0x9c94b463u, 0xa485dbcfu, 0xecb66b3bu, 0xd4a70497u,
+        0x7cd10ad3u, 0x44c0657fu, 0x0cf3d58bu, 0x34e2ba27u, 0xd6d1de21u, 0xeec0b18du,
+        0xa6f30179u, 0x9ee26ed5u, 0x36946091u, 0x0e850f3du, 0x46b6bfc9u, 0x7ea7d065u,
+        0x13b6d5b0u, 0x2ba7ba1cu, 0x63940ae8u, 0x5b856544u, 0xf3f36b00u, 0xcbe204acu,
+        0x83d1b458u, 0xbbc0dbf4u, 0x425b0aa5u, 0x7a4a6509u, 0x3279d5fdu, 0x0a68ba51u,
+        0xa21eb415u, 0x9a0fdbb9u, 0xd23c6b4du, 0xea2d04e1u, 0x873c0134u, 0xbf2d6e98u,
+        0xf71ede6cu, 0xcf0fb1c0u, 0x6779bf84u, 0x5f68d028u, 0x175b60dcu, 0x2f4a0f70u,
+        0xcd796b76u, 0xf56804dau, 0xbd5bb42eu, 0x854adb82u, 0x2d3cd5c6u, 0x152dba6au,
+        0x5d1e0a9eu, 0x650f6532u, 0x081e60e7u, 0x300f0f4bu, 0x783cbfbfu, 0x402dd013u,
+        0xe85bde57u, 0xd04ab1fbu, 0x9879010fu, 0xa0686ea3u
+    },
+    {
+        0x00000000u, 0xef306b19u, 0xdb8ca0c3u, 0x34bccbdau, 0xb2f53777u, 0x5dc55c6eu,
+        0x697997b4u, 0x8649fcadu, 0x6006181fu, 0x8f367306u, 0xbb8ab8dcu, 0x54bad3c5u,
+        0xd2f32f68u, 0x3dc34471u, 0x097f8fabu, 0xe64fe4b2u, 0xc00c303eu, 0x2f3c5b27u,
+        0x1b8090fdu, 0xf4b0fbe4u, 0x72f90749u, 0x9dc96c50u, 0xa975a78au, 0x4645cc93u,
+        0xa00a2821u, 0x4f3a4338u, 0x7b8688e2u, 0x94b6e3fbu, 0x12ff1f56u, 0xfdcf744fu,
+        0xc973bf95u, 0x2643d48cu, 0x85f4168du, 0x6ac47d94u, 0x5e78b64eu, 0xb148dd57u,
+        0x370121fau, 0xd8314ae3u, 0xec8d8139u, 0x03bdea20u, 0xe5f20e92u, 0x0ac2658bu,
+        0x3e7eae51u, 0xd14ec548u, 0x570739e5u, 0xb83752fcu, 0x8c8b9926u, 0x63bbf23fu,
+        0x45f826b3u, 0xaac84daau, 0x9e748670u, 0x7144ed69u, 0xf70d11c4u, 0x183d7addu,
+        0x2c81b107u, 0xc3b1da1eu, 0x25fe3eacu, 0xcace55b5u, 0xfe729e6fu, 0x1142f576u,
+        0x970b09dbu, 0x783b62c2u, 0x4c87a918u, 0xa3b7c201u, 0x0e045bebu, 0xe13430f2u,
+        0xd588fb28u, 0x3ab89031u, 0xbcf16c9cu, 0x53c10785u, 0x677dcc5fu, 0x884da746u,
+        0x6e0243f4u, 0x813228edu, 0xb58ee337u, 0x5abe882eu, 0xdcf77483u, 0x33c71f9au,
+        0x077bd440u, 0xe84bbf59u, 0xce086bd5u, 0x213800ccu, 0x1584cb16u, 0xfab4a00fu,
+        0x7cfd5ca2u, 0x93cd37bbu, 0xa771fc61u, 0x48419778u, 0xae0e73cau, 0x413e18d3u,
+        0x7582d309u, 0x9ab2b810u, 0x1cfb44bdu, 0xf3cb2fa4u, 0xc777e47eu, 0x28478f67u,
+        0x8bf04d66u, 0x64c0267fu, 0x507ceda5u, 0xbf4c86bcu, 0x39057a11u, 0xd6351108u,
+        0xe289dad2u, 0x0db9b1cbu, 0xebf65579u, 0x04c63e60u, 0x307af5bau, 0xdf4a9ea3u,
+        0x5903620eu, 0xb6330917u, 0x828fc2cdu, 0x6dbfa9d4u, 0x4bfc7d58u, 0xa4cc1641u,
+        0x9070dd9bu, 0x7f40b682u, 0xf9094a2fu, 0x16392136u, 0x2285eaecu, 0xcdb581f5u,
+        0x2bfa6547u, 0xc4ca0e5eu, 0xf076c584u, 0x1f46ae9du, 0x990f5230u, 0x763f3929u,
+        0x4283f2f3u, 0xadb399eau, 0x1c08b7d6u, 0xf338dccfu, 0xc7841715u, 0x28b47c0cu,
+        0xaefd80a1u, 0x41cdebb8u, 0x75712062u, 0x9a414b7bu, 0x7c0eafc9u, 0x933ec4d0u,
+        0xa7820f0au, 0x48b26413u, 0xcefb98beu, 0x21cbf3a7u, 0x1577387du, 0xfa475364u,
+        0xdc0487e8u, 0x3334ecf1u, 0x0788272bu, 0xe8b84c32u, 0x6ef1b09fu, 0x81c1db86u,
+        0xb57d105cu, 0x5a4d7b45u, 0xbc029ff7u, 0x5332f4eeu, 0x678e3f34u, 0x88be542du,
+        0x0ef7a880u, 0xe1c7c399u, 0xd57b0843u, 0x3a4b635au, 0x99fca15bu, 0x76ccca42u,
+        0x42700198u, 0xad406a81u, 0x2b09962cu, 0xc439fd35u, 0xf08536efu, 0x1fb55df6u,
+        0xf9fab944u, 0x16cad25du, 0x22761987u, 0xcd46729eu, 0x4b0f8e33u, 0xa43fe52au,
+        0x90832ef0u, 0x7fb345e9u, 0x59f09165u, 0xb6c0fa7cu, 0x827c31a6u, 0x6d4c5abfu,
+        0xeb05a612u, 0x0435cd0bu, 0x308906d1u, 0xdfb96dc8u, 0x39f6897au, 0xd6c6e263u,
+        0xe27a29b9u, 0x0d4a42a0u, 0x8b03be0du, 0x6433d514u, 0x508f1eceu, 0xbfbf75d7u,
+        0x120cec3du, 0xfd3c8724u, 0xc9804cfeu, 0x26b027e7u, 0xa0f9db4au, 0x4fc9b053u,
+        0x7b757b89u, 0x94451090u, 0x720af422u, 0x9d3a9f3bu, 0xa98654e1u, 0x46b63ff8u,
+        0xc0ffc355u, 0x2fcfa84cu, 0x1b736396u, 0xf443088fu, 0xd200dc03u, 0x3d30b71au,
+        0x098c7cc0u, 0xe6bc17d9u, 0x60f5eb74u, 0x8fc5806du, 0xbb794bb7u, 0x544920aeu,
+        0xb206c41cu, 0x5d36af05u, 0x698a64dfu, 0x86ba0fc6u, 0x00f3f36bu, 0xefc39872u,
+        0xdb7f53a8u, 0x344f38b1u, 0x97f8fab0u, 0x78c891a9u, 0x4c745a73u, 0xa344316au,
+        0x250dcdc7u, 0xca3da6deu, 0xfe816d04u, 0x11b1061du, 0xf7fee2afu, 0x18ce89b6u,
+        0x2c72426cu, 0xc3422975u, 0x450bd5d8u, 0xaa3bbec1u, 0x9e87751bu, 0x71b71e02u,
+        0x57f4ca8eu, 0xb8c4a197u, 0x8c786a4du, 0x63480154u, 0xe501fdf9u, 0x0a3196e0u,
+        0x3e8d5d3au, 0xd1bd3623u, 0x37f2d291u, 0xd8c2b988u, 0xec7e7252u, 0x034e194bu,
+        0x8507e5e6u, 0x6a378effu, 0x5e8b4525u, 0xb1bb2e3cu
+    },
+    {
+        0x00000000u, 0x68032cc8u, 0xd0065990u, 0xb8057558u, 0xa5e0c5d1u, 0xcde3e919u,
+        0x75e69c41u, 0x1de5b089u, 0x4e2dfd53u, 0x262ed19bu, 0x9e2ba4c3u, 0xf628880bu,
+        0xebcd3882u, 0x83ce144au, 0x3bcb6112u, 0x53c84ddau, 0x9c5bfaa6u, 0xf458d66eu,
+        0x4c5da336u, 0x245e8ffeu, 0x39bb3f77u, 0x51b813bfu, 0xe9bd66e7u, 0x81be4a2fu,
+        0xd27607f5u, 0xba752b3du, 0x02705e65u, 0x6a7372adu, 0x7796c224u, 0x1f95eeecu,
+        0xa7909bb4u, 0xcf93b77cu, 0x3d5b83bdu, 0x5558af75u, 0xed5dda2du, 0x855ef6e5u,
+        0x98bb466cu, 0xf0b86aa4u, 0x48bd1ffcu, 0x20be3334u, 0x73767eeeu, 0x1b755226u,
+        0xa370277eu, 0xcb730bb6u, 0xd696bb3fu, 0xbe9597f7u, 0x0690e2afu, 0x6e93ce67u,
+        0xa100791bu, 0xc90355d3u, 0x7106208bu, 0x19050c43u, 0x04e0bccau, 0x6ce39002u,
+        0xd4e6e55au, 0xbce5c992u, 0xef2d8448u, 0x872ea880u, 0x3f2bddd8u, 0x5728f110u,
+        0x4acd4199u, 0x22ce6d51u, 0x9acb1809u, 0xf2c834c1u, 0x7ab7077au, 0x12b42bb2u,
+        0xaab15eeau, 0xc2b27222u, 0xdf57c2abu, 0xb754ee63u, 0x0f519b3bu, 0x6752b7f3u,
+        0x349afa29u, 0x5c99d6e1u, 0xe49ca3b9u, 0x8c9f8f71u, 0x917a3ff8u, 0xf9791330u,
+        0x417c6668u, 0x297f4aa0u, 0xe6ecfddcu, 0x8eefd114u, 0x36eaa44cu, 0x5ee98884u,
+        0x430c380du, 0x2b0f14c5u, 0x930a619du, 0xfb094d55u, 0xa8c1008fu, 0xc0c22c47u,
+        0x78c7591fu, 0x10c475d7u, 0x0d21c55eu, 0x6522e996u, 0xdd279cceu, 0xb524b006u,
+        0x47ec84c7u, 0x2fefa80fu, 0x97eadd57u, 0xffe9f19fu, 0xe20c4116u, 0x8a0f6ddeu,
+        0x320a1886u, 0x5a09344eu, 0x09c17994u, 0x61c2555cu, 0xd9c72004u, 0xb1c40cccu,
+        0xac21bc45u, 0xc422908du, 0x7c27e5d5u, 0x1424c91du, 0xdbb77e61u, 0xb3b452a9u,
+        0x0bb127f1u, 0x63b20b39u, 0x7e57bbb0u, 0x16549778u, 0xae51e220u, 0xc652cee8u,
+        0x959a8332u, 0xfd99affau, 0x459cdaa2u, 0x2d9ff66au, 0x307a46e3u, 0x58796a2bu,
+        0xe07c1f73u, 0x887f33bbu, 0xf56e0ef4u, 0x9d6d223cu, 0x25685764u, 0x4d6b7bacu,
+        0x508ecb25u, 0x388de7edu, 0x808892b5u, 0xe88bbe7du, 0xbb43f3a7u, 0xd340df6fu,
+        0x6b45aa37u, 0x034686ffu, 0x1ea33676u, 0x76a01abeu, 0xcea56fe6u, 0xa6a6432eu,
+        0x6935f452u, 0x0136d89au, 0xb933adc2u, 0xd130810au, 0xccd53183u, 0xa4d61d4bu,
+        0x1cd36813u, 0x74d044dbu, 0x27180901u, 0x4f1b25c9u, 0xf71e5091u, 0x9f1d7c59u,
+        0x82f8ccd0u, 0xeafbe018u, 0x52fe9540u, 0x3afdb988u, 0xc8358d49u, 0xa036a181u,
+        0x1833d4d9u, 0x7030f811u, 0x6dd54898u, 0x05d66450u, 0xbdd31108u, 0xd5d03dc0u,
+        0x8618701au, 0xee1b5cd2u, 0x561e298au, 0x3e1d0542u, 0x23f8b5cbu, 0x4bfb9903u,
+        0xf3feec5bu, 0x9bfdc093u, 0x546e77efu, 0x3c6d5b27u, 0x84682e7fu, 0xec6b02b7u,
+        0xf18eb23eu, 0x998d9ef6u, 0x2188ebaeu, 0x498bc766u, 0x1a438abcu, 0x7240a674u,
+        0xca45d32cu, 0xa246ffe4u, 0xbfa34f6du, 0xd7a063a5u, 0x6fa516fdu, 0x07a63a35u,
+        0x8fd9098eu, 0xe7da2546u, 0x5fdf501eu, 0x37dc7cd6u, 0x2a39cc5fu, 0x423ae097u,
+        0xfa3f95cfu, 0x923cb907u, 0xc1f4f4ddu, 0xa9f7d815u, 0x11f2ad4du, 0x79f18185u,
+        0x6414310cu, 0x0c171dc4u, 0xb412689cu, 0xdc114454u, 0x1382f328u, 0x7b81dfe0u,
+        0xc384aab8u, 0xab878670u, 0xb66236f9u, 0xde611a31u, 0x66646f69u, 0x0e6743a1u,
+        0x5daf0e7bu, 0x35ac22b3u, 0x8da957ebu, 0xe5aa7b23u, 0xf84fcbaau, 0x904ce762u,
+        0x2849923au, 0x404abef2u, 0xb2828a33u, 0xda81a6fbu, 0x6284d3a3u, 0x0a87ff6bu,
+        0x17624fe2u, 0x7f61632au, 0xc7641672u, 0xaf673abau, 0xfcaf7760u, 0x94ac5ba8u,
+        0x2ca92ef0u, 0x44aa0238u, 0x594fb2b1u, 0x314c9e79u, 0x8949eb21u, 0xe14ac7e9u,
+        0x2ed97095u, 0x46da5c5du, 0xfedf2905u, 0x96dc05cdu, 0x8b39b544u, 0xe33a998cu,
+        0x5b3fecd4u, 0x333cc01cu, 0x60f48dc6u, 0x08f7a10eu, 0xb0f2d456u, 0xd8f1f89eu,
+        0xc5144817u, 0xad1764dfu, 0x15121187u, 0x7d113d4fu
+    },
+    {
+        0x00000000u, 0x493c7d27u, 0x9278fa4eu, 0xdb448769u, 0x211d826du, 0x6821ff4au,
+        0xb3657823u, 0xfa590504u, 0x423b04dau, 0x0b0779fdu, 0xd043fe94u, 0x997f83b3u,
+        0x632686b7u, 0x2a1afb90u, 0xf15e7cf9u, 0xb86201deu, 0x847609b4u, 0xcd4a7493u,
+        0x160ef3fau, 0x5f328eddu, 0xa56b8bd9u, 0xec57f6feu, 0x37137197u, 0x7e2f0cb0u,
+        0xc64d0d6eu, 0x8f717049u, 0x5435f720u, 0x1d098a07u, 0xe7508f03u, 0xae6cf224u,
+        0x7528754du, 0x3c14086au, 0x0d006599u, 0x443c18beu, 0x9f789fd7u, 0xd644e2f0u,
+        0x2c1de7f4u, 0x65219ad3u, 0xbe651dbau, 0xf759609du, 0x4f3b6143u, 0x06071c64u,
+        0xdd439b0du, 0x947fe62au, 0x6e26e32eu, 0x271a9e09u, 0xfc5e1960u, 0xb5626447u,
+        0x89766c2du, 0xc04a110au, 0x1b0e9663u, 0x5232eb44u, 0xa86bee40u, 0xe1579367u,
+        0x3a13140eu, 0x732f6929u, 0xcb4d68f7u, 0x827115d0u, 0x593592b9u, 0x1009ef9eu,
+        0xea50ea9au, 0xa36c97bdu, 0x782810d4u, 0x31146df3u, 0x1a00cb32u, 0x533cb615u,
+        0x8878317cu, 0xc1444c5bu, 0x3b1d495fu, 0x72213478u, 0xa965b311u, 0xe059ce36u,
+        0x583bcfe8u, 0x1107b2cfu, 0xca4335a6u, 0x837f4881u, 0x79264d85u, 0x301a30a2u,
+        0xeb5eb7cbu, 0xa262caecu, 0x9e76c286u, 0xd74abfa1u, 0x0c0e38c8u, 0x453245efu,
+        0xbf6b40ebu, 0xf6573dccu, 0x2d13baa5u, 0x642fc782u, 0xdc4dc65cu, 0x9571bb7bu,
+        0x4e353c12u, 0x07094135u, 0xfd504431u, 0xb46c3916u, 0x6f28be7fu, 0x2614c358u,
+        0x1700aeabu, 0x5e3cd38cu, 0x857854e5u, 0xcc4429c2u, 0x361d2cc6u, 0x7f2151e1u,
+        0xa465d688u, 0xed59abafu, 0x553baa71u, 0x1c07d756u, 0xc743503fu, 0x8e7f2d18u,
+        0x7426281cu, 0x3d1a553bu, 0xe65ed252u, 0xaf62af75u, 0x9376a71fu, 0xda4ada38u,
+        0x010e5d51u, 0x48322076u, 0xb26b2572u, 0xfb575855u, 0x2013df3cu, 0x692fa21bu,
+        0xd14da3c5u, 0x9871dee2u, 0x4335598bu, 0x0a0924acu, 0xf05021a8u, 0xb96c5c8fu,
+        0x6228dbe6u, 0x2b14a6c1u, 0x34019664u, 0x7d3deb43u, 0xa6796c2au, 0xef45110du,
+        0x151c1409u, 0x5c20692eu, 0x8764ee47u, 0xce589360u, 0x763a92beu, 0x3f06ef99u,
+        0xe44268f0u, 0xad7e15d7u, 0x572710d3u, 0x1e1b6df4u, 0xc55fea9du, 0x8c6397bau,
+        0xb0779fd0u, 0xf94be2f7u, 0x220f659eu, 0x6b3318b9u, 0x916a1dbdu, 0xd856609au,
+        0x0312e7f3u, 0x4a2e9ad4u, 0xf24c9b0au, 0xbb70e62du, 0x60346144u, 0x29081c63u,
+        0xd3511967u, 0x9a6d6440u, 0x4129e329u, 0x08159e0eu, 0x3901f3fdu, 0x703d8edau,
+        0xab7909b3u, 0xe2457494u, 0x181c7190u, 0x51200cb7u, 0x8a648bdeu, 0xc358f6f9u,
+        0x7b3af727u, 0x32068a00u, 0xe9420d69u, 0xa07e704eu, 0x5a27754au, 0x131b086du,
+        0xc85f8f04u, 0x8163f223u, 0xbd77fa49u, 0xf44b876eu, 0x2f0f0007u, 0x66337d20u,
+        0x9c6a7824u, 0xd5560503u, 0x0e12826au, 0x472eff4du, 0xff4cfe93u, 0xb67083b4u,
+        0x6d3404ddu, 0x240879fau, 0xde517cfeu, 0x976d01d9u, 0x4c2986b0u, 0x0515fb97u,
+        0x2e015d56u, 0x673d2071u, 0xbc79a718u, 0xf545da3fu, 0x0f1cdf3bu, 0x4620a21cu,
+        0x9d642575u, 0xd4585852u, 0x6c3a598cu, 0x250624abu, 0xfe42a3c2u, 0xb77edee5u,
+        0x4d27dbe1u, 0x041ba6c6u, 0xdf5f21afu, 0x96635c88u, 0xaa7754e2u, 0xe34b29c5u,
+        0x380faeacu, 0x7133d38bu, 0x8b6ad68fu, 0xc256aba8u, 0x19122cc1u, 0x502e51e6u,
+        0xe84c5038u, 0xa1702d1fu, 0x7a34aa76u, 0x3308d751u, 0xc951d255u, 0x806daf72u,
+        0x5b29281bu, 0x1215553cu, 0x230138cfu, 0x6a3d45e8u, 0xb179c281u, 0xf845bfa6u,
+        0x021cbaa2u, 0x4b20c785u, 0x906440ecu, 0xd9583dcbu, 0x613a3c15u, 0x28064132u,
+        0xf342c65bu, 0xba7ebb7cu, 0x4027be78u, 0x091bc35fu, 0xd25f4436u, 0x9b633911u,
+        0xa777317bu, 0xee4b4c5cu, 0x350fcb35u, 0x7c33b612u, 0x866ab316u, 0xcf56ce31u,
+        0x14124958u, 0x5d2e347fu, 0xe54c35a1u, 0xac704886u, 0x7734cfefu, 0x3e08b2c8u,
+        0xc451b7ccu, 0x8d6dcaebu, 0x56294d82u, 0x1f1530a5u
+    }
+};
+
+static const u32 crc32c_x2n[32] = {   // x^(2^k) mod p
+    0x40000000u, 0x20000000u, 0x08000000u, 0x00800000u, 0x00008000u, 0x82f63b78u,
+    0x6ea2d55cu, 0x18b8ea18u, 0x510ac59au, 0xb82be955u, 0xb8fdb1e7u, 0x88e56f72u,
+    0x74c360a4u, 0xe4172b16u, 0x0d65762au, 0x35d73a62u, 0x28461564u, 0xbf455269u,
+    0xe2ea32dcu, 0xfe7740e6u, 0xf946610bu, 0x3c204f8fu, 0x538586e3u, 0x59726915u,
+    0x734d5309u, 0xbc1ac763u, 0x7d0722ccu, 0xd289cabeu, 0xe94ca9bcu, 0x05b74f3fu,
+    0xa51e1f42u, 0x40000000u
+};
+
+// a*b modulo the CRC-32C polynomial, both reflected
+static u32
+crc32c_multmodp(u32 a, u32 b)
+{
+    u32 m = 1u << 31;
+    u32 p = 0;
+    for (;;) {
+        if (a & m) {
+            p ^= b;
+            if ((a & (m - 1)) == 0)
+                break;
+        }
+        m >>= 1;
+        b = (b & 1) ? (b >> 1) ^ CRC32C_POLY : b >> 1;
+    }
+    return p;
+}
+
+// x^(n*2^k) modulo the CRC-32C polynomial
+static u32
+crc32c_x2nmodp(u64 n, s32 k)
+{
+    u32 p = 1u << 31; // x^0
+    while (n) {
+        if (n & 1)
+            p = crc32c_multmodp(crc32c_x2n[k & 31], p);
+        n >>= 1;
+        k++;
+    }
+    return p;
+}
+
+#if (defined(__SSE4_2__) || defined(__AVX__)) && (defined(__x86_64__) || defined(_M_X64))
+#define PMK_CRC32C_HW 1
+#include <nmmintrin.h>
+#if defined(__PCLMUL__)
+#include <wmmintrin.h>
+#endif
+#endif
+
+// x^(8n) mod p for n = CRC32C_LONG, 2*CRC32C_LONG and likewise for
+// CRC32C_SHORT, by which the hardware path shifts a stream's CRC over the
+// bytes that follow it; the PCLMUL path multiplies with a carry-less
+// multiply and reduces with the crc32 instruction, so it uses x^(8n-33)
+#if defined(PMK_CRC32C_HW) && defined(__PCLMUL__)
+static const u32 crc32c_shift_long[2]  = { 0x54a86326u, 0x1dc403ccu };
+static const u32 crc32c_shift_short[2] = { 0xb9e02b86u, 0xdd7e3b0cu };
+#elif defined(PMK_CRC32C_HW)
+static const u32 crc32c_shift_long[2]  = { 0x28461564u, 0xbf455269u };
+static const u32 crc32c_shift_short[2] = { 0x88e56f72u, 0x74c360a4u };
+#endif
+
+// slicing-by-8 over the raw (non-inverted) CRC register
+static u32
+crc32c_sw(u32 crc, const u8 * p, s64 len)
+{
+    while (len && ((uintptr_t) p & 7)) {
+        crc = crc32c_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+        len--;
+    }
+    while (len >= 8) {
+        u64 w = load_u64_le(p) ^ crc;
+        crc = crc32c_table[7][ w        & 0xff] ^ crc32c_table[6][(w >>  8) & 0xff] ^
+              crc32c_table[5][(w >> 16) & 0xff] ^ crc32c_table[4][(w >> 24) & 0xff] ^
+              crc32c_table[3][(w >> 32) & 0xff] ^ crc32c_table[2][(w >> 40) & 0xff] ^
+              crc32c_table[1][(w >> 48) & 0xff] ^ crc32c_table[0][ w >> 56        ];
+        p += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc = crc32c_table[0][(crc ^ *p++) & 0xff] ^ (crc >> 8);
+    return crc;
+}
+
+#ifdef PMK_CRC32C_HW
+
+// multiplies crc by one of the shift constants above
+static u32
+crc32c_shift(u32 crc, u32 k)
+{
+#if defined(__PCLMUL__)
+    __m128i prod = _mm_clmulepi64_si128(_mm_cvtsi32_si128((int) crc), _mm_cvtsi32_si128((int) k), 0);
+    return (u32) _mm_crc32_u64(0, (u64) _mm_cvtsi128_si64(prod));
+#else
+    return crc32c_multmodp(k, crc);
+#endif
+}
+
+// three independent crc32 dependency chains hide the instruction's latency
+// and are then merged by shifting the first two over the bytes that follow
+static u32
+crc32c_hw(u32 crc, const u8 * p, s64 len)
+{
+    u64 crc0 = crc;
+    while (len && ((uintptr_t) p & 7)) {
+        crc0 = _mm_crc32_u8((u32) crc0, *p++);
+        len--;
+    }
+    while (len >= 3 * CRC32C_LONG) {
+        u64 crc1 = 0, crc2 = 0;
+        const u8 * end = p + CRC32C_LONG;
+        do {
+            crc0 = _mm_crc32_u64(crc0, load_u64_le(p));
+            crc1 = _mm_crc32_u64(crc1, load_u64_le(p + CRC32C_LONG));
+            crc2 = _mm_crc32_u64(crc2, load_u64_le(p + 2 * CRC32C_LONG));
+            p += 8;
+        } while (p < end);
+        crc0 = crc32c_shift((u32) crc0, crc32c_shift_long[1]) ^
+               crc32c_shift((u32) crc1, crc32c_shift_long[0]) ^ crc2;
+        p += 2 * CRC32C_LONG;
+        len -= 3 * CRC32C_LONG;
+    }
+    while (len >= 3 * CRC32C_SHORT) {
+        u64 crc1 = 0, crc2 = 0;
+        const u8 * end = p + CRC32C_SHORT;
+        do {
+            crc0 = _mm_crc32_u64(crc0, load_u64_le(p));
+            crc1 = _mm_crc32_u64(crc1, load_u64_le(p + CRC32C_SHORT));
+            crc2 = _mm_crc32_u64(crc2, load_u64_le(p + 2 * CRC32C_SHORT));
+            p += 8;
+        } while (p < end);
+        crc0 = crc32c_shift((u32) crc0, crc32c_shift_short[1]) ^
+               crc32c_shift((u32) crc1, crc32c_shift_short[0]) ^ crc2;
+        p += 2 * CRC32C_SHORT;
+        len -= 3 * CRC32C_SHORT;
+    }
+    while (len >= 8) {
+        crc0 = _mm_crc32_u64(crc0, load_u64_le(p));
+        p += 8;
+        len -= 8;
+    }
+    while (len--)
+        crc0 = _mm_crc32_u8((u32) crc0, *p++);
+    return (u32) crc0;
+}
+
+#endif /* PMK_CRC32C_HW */
+
+u32
+string_crc32c(String string, u32 seed)
+{
+#ifdef PMK_CRC32C_HW
+    return ~crc32c_hw(~seed, (const u8 *) string.data, string.len);
+#else
+    return ~crc32c_sw(~seed, (const u8 *) string.data, string.len);
+#endif
+}
+
+// CRC of the concatenation given crc1 of the first part and crc2 of the
+// second part of length len2
+u32
+crc32c_combine(u32 crc1, u32 crc2, s64 len2)
+{
+    return crc32c_multmodp(crc32c_x2nmodp((u64) len2, 3), crc1) ^ crc2;
+}
+
+void
+crc32c_init(Crc32c * hasher)
+{
+    hasher->crc = 0;
+    hasher->len = 0;
+}
+
+void
+crc32c_update(Crc32c * hasher, String string)
+{
+    hasher->crc = string_crc32c(string, hasher->crc);
+    hasher->len += string.len;
+}
+
+u32
+crc32c_final(const Crc32c * hasher)
+{
+    return hasher->crc;
+}
+
+// Edit distance uses the bit-parallel algorithm of Myers as formulated by
+// Hyyrö: each column of the DP matrix is held as vertical +1/-1 delta
+// bitvectors (pv/mv) of the pattern's length, so one text character costs a
+// handful of word operations per 64 pattern characters. peq[c] has bit i set
+// where pattern[i] == c; with more than 64 pattern characters it is laid out
+// as peq[c * nblocks + block].
+
+static void
+myers_build_peq(u64 * peq, s32 nblocks, String pattern)
+{
+    memset(peq, 0, 256 * nblocks * sizeof(peq[0]));
+    for (s32 i = 0; i < pattern.len; i++)
+        peq[(u8) pattern.data[i] * nblocks + i / 64] |= (u64) 1 << (i % 64);
+}
+
+// distance between the pattern (1 <= m <= 64) and text, or max_dist+1 once
+// it is certain to exceed max_dist
+static s32
+myers_single(const u64 * peq, s32 m, String text, s32 max_dist)
+{
+    u64 pv = ~(u64) 0;
+    u64 mv = 0;
+    u64 hibit = (u64) 1 << (m - 1);
+    s32 score = m;
+    for (s32 j = 0; j < text.len; j++) {
+        u64 eq = peq[(u8) text.data[j]];
+        u64 xv = eq | mv;
+        u64 xh = (((eq & pv) + pv) ^ pv) | eq;
+        u64 ph = mv | ~(xh | pv);
+        u64 mh = pv & xh;
+        score += (ph & hibit) ? 1 : (mh & hibit) ? -1 : 0;
+        // each remaining column can lower the score by at most one
+        if (score - (text.len - j - 1) > max_dist)
+            return max_dist + 1;
+        ph = (ph << 1) | 1;
+        mh <<= 1;
+        pv = mh | ~(xv | ph);
+        mv = ph & xv;
+    }
+    return score;
+}
+
+// one 64-row block of a column; hin/return value are the horizontal deltas
+// entering at the top and leaving at the bottom (at bit hibit)
+static s32
+myers_advance_block(u64 * pv_p, u64 * mv_p, u64 eq, s32 hin, u64 hibit)
+{
+    u64 pv = *pv_p;
+    u64 mv = *mv_p;
+    u64 xv = eq | mv;
+    if (hin < 0)
+        eq |= 1;
+    u64 xh = (((eq & pv) + pv) ^ pv) | eq;
+    u64 ph = mv | ~(xh | pv);
+    u64 mh = pv & xh;
+    s32 hout = (ph & hibit) ? 1 : (mh & hibit) ? -1 : 0;
+    ph <<= 1;
+    mh <<= 1;
+    if (hin < 0)
+        mh |= 1;
+    else if (hin > 0)
+        ph |= 1;
+    *pv_p = mh | ~(xv | ph);
+    *mv_p = ph & xv;
+    return hout;
+}
+
+// pv and mv are scratch arrays of nblocks words
+static s32
+myers_blocked(const u64 * peq, s32 nblocks, s32 m, String text, s32 max_dist, u64 * pv, u64 * mv)
+{
+    u64 last_hibit = (u64) 1 << ((m - 1) % 64);
+    for (s32 b = 0; b < nblocks; b++) {
+        pv[b] = ~(u64) 0;
+        mv[b] = 0;
+    }
+    s32 score = m;
+    for (s32 j = 0; j < text.len; j++) {
+        const u64 * eq = peq + (u8) text.data[j] * nblocks;
+        s32 h = 1; // top row: D[0][j] = j
+        for (s32 b = 0; b < nblocks - 1; b++)
+            h = myers_advance_block(&pv[b], &mv[b], eq[b], h, (u64) 1 << 63);
+        score += myers_advance_block(&pv[nblocks-1], &mv[nblocks-1], eq[nblocks-1], h, last_hibit);
+        if (score - (text.len - j - 1) > max_dist)
+            return max_dist + 1;
+    }
+    return score;
+}
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+// myers_single() on four texts at once, one per 64-bit lane
+static void
+myers_single_x4(const u64 * peq, s32 m, const String * texts, s32 max_dist, s32 * out)
+{
+    __m256i ones  = _mm256_set1_epi64x(-1);
+    __m256i hibit = _mm256_set1_epi64x((s64) ((u64) 1 << (m - 1)));
+    __m256i pv    = ones;
+    __m256i mv    = _mm256_setzero_si256();
+    __m256i score = _mm256_set1_epi64x(m);
+    __m256i lens  = _mm256_set_epi64x(texts[3].len, texts[2].len, texts[1].len, texts[0].len);
+    s32 done = 0; // lanes which have finished or exceeded max_dist
+    s32 max_len = 0;
+    for (s32 l = 0; l < 4; l++) {
+        out[l] = -1;
+        if (texts[l].len - m > max_dist || m - texts[l].len > max_dist) {
+            out[l] = max_dist + 1;
+            done |= 1 << l;
+        } else if (texts[l].len > max_len) {
+            max_len = texts[l].len;
+        }
+    }
+
+    for (s32 j = 0; j < max_len && done != 0xf; j++) {
+        u64 eq_lanes[4];
+        for (s32 l = 0; l < 4; l++)
+            eq_lanes[l] = (j < texts[l].len) ? peq[(u8) texts[l].data[j]] : 0;
+        __m256i eq = _mm256_loadu_si256((const __m256i *) eq_lanes);
+        __m256i xv = _mm256_or_si256(eq, mv);
+        __m256i t  = _mm256_add_epi64(_mm256_and_si256(eq, pv), pv);
+        __m256i xh = _mm256_or_si256(_mm256_xor_si256(t, pv), eq);
+        __m256i ph = _mm256_or_si256(mv, _mm256_xor_si256(_mm256_or_si256(xh, pv), ones));
+        __m256i mh = _mm256_and_si256(pv, xh);
+
+        __m256i active = _mm256_cmpgt_epi64(lens, _mm256_set1_epi64x(j));
+        __m256i inc = _mm256_xor_si256(_mm256_cmpeq_epi64(_mm256_and_si256(ph, hibit), _mm256_setzero_si256()), ones);
+        __m256i dec = _mm256_xor_si256(_mm256_cmpeq_epi64(_mm256_and_si256(mh, hibit), _mm256_setzero_si256()), ones);
+        score = _mm256_sub_epi64(score, _mm256_and_si256(inc, active));
+        score = _mm256_add_epi64(score, _mm256_and_si256(dec, active));
+
+        ph = _mm256_or_si256(_mm256_slli_epi64(ph, 1), _mm256_set1_epi64x(1));
+        mh = _mm256_slli_epi64(mh, 1);
+        pv = _mm256_or_si256(mh, _mm256_xor_si256(_mm256_or_si256(xv, ph), ones));
+        mv = _mm256_and_si256(ph, xv);
+
+        if ((j & 7) == 7 || j == max_len - 1) {
+            s64 scores[4];
+            _mm256_storeu_si256((__m256i *) scores, score);
+            for (s32 l = 0; l < 4; l++) {
+                if (done & (1 << l))
+                    continue;
+                if (j >= texts[l].len - 1) {
+                    out[l] = (scores[l] <= max_dist) ? (s32) scores[l] : max_dist + 1;
+                    done |= 1 << l;
+                } else if (scores[l] - (texts[l].len - j - 1) > max_dist) {
+                    out[l] = max_dist + 1;
+                    done |= 1 << l;
+                }
+            }
+        }
+    }
+
+    // empty texts never enter the loop
+    for (s32 l = 0; l < 4; l++) {
+        if (out[l] < 0)
+            out[l] = m;
+    }
+}
+
+#endif /* __AVX2__ */
+
+s32
+string_edit_distance_context(void * context, String a, String b)
+{
+    // the shorter string is the pattern so that it needs fewer words
+    String pattern = (a.len <= b.len) ? a : b;
+    String text    = (a.len <= b.len) ? b : a;
+    if (pattern.len == 0)
+        return text.len;
+    if (pattern.len <= 64) {
+        u64 peq[256];
+        myers_build_peq(peq, 1, pattern);
+        return myers_single(peq, pattern.len, text, INT32_MAX - 1);
+    }
+    s32 nblocks = (pattern.len + 63) / 64;
+    size_t size = (256 + 2) * nblocks * sizeof(u64);
+    u64 * peq = PMK_MALLOC(context, size);
+    myers_build_peq(peq, nblocks, pattern);
+    s32 result = myers_blocked(peq, nblocks, pattern.len, text, INT32_MAX - 1,
+                               peq + 256 * nblocks, peq + 257 * nblocks);
+    PMK_FREE(context, peq);
+    return result;
+}
+
+s32
+string_edit_distance_batch_context(void * context, String query, const String * candidates, s32 count, s32 max_dist, s32 * distances)
+{
+    assert(max_dist >= 0 && max_dist < INT32_MAX);
+    s32 m = query.len;
+    s32 nblocks = MAX((m + 63) / 64, 1);
+    size_t size = (256 + 2) * nblocks * sizeof(u64);
+    u64 peq_small[256];
+    u64 * peq = (m <= 64) ? peq_small : PMK_MALLOC(context, size);
+    myers_build_peq(peq, nblocks, query);
+
+    s32 i = 0;
+#if defined(__AVX2__)
+    if (m > 0 && m <= 64) {
+        for (; i + 4 <= count; i += 4)
+            myers_single_x4(peq, m, candidates + i, max_dist, distances + i);
+    }
+#endif
+    for (; i < count; i++) {
+        String text = candidates[i];
+        if (text.len - m > max_dist || m - text.len > max_dist)
+            distances[i] = max_dist + 1;
+        else if (m == 0)
+            distances[i] = text.len;
+        else if (m <= 64)
+            distances[i] = myers_single(peq, m, text, max_dist);
+        else
+            distances[i] = myers_blocked(peq, nblocks, m, text, max_dist,
+                                         peq + 256 * nblocks, peq + 257 * nblocks);
+    }
+
+    if (peq != peq_small)
+        PMK_FREE(context, peq);
+
+    s32 within = 0;
+    for (i = 0; i < count; i++)
+        within += distances[i] <= max_dist;
+    return within;
+}
+
+GlobPattern
+glob_compile(String pattern)
+{
+    GlobPattern glob = { .pattern = pattern };
+    String wildcards = str_lit("*?");
+
+    s32 first = string_cspan(pattern, wildcards);
+    glob.prefix = string_substr(pattern, 0, first);
+    if (first == pattern.len) {
+        glob.suffix = (String) { .data = pattern.data + pattern.len, .len = 0 };
+        glob.literal = pattern;
+        glob.min_len = pattern.len;
+        return glob;
+    }
+
+    s32 last = pattern.len;
+    while (pattern.data[last-1] != '*' && pattern.data[last-1] != '?')
+        last--;
+    glob.suffix = string_substr(pattern, last, pattern.len);
+
+    for (s32 i = 0; i < pattern.len; ) {
+        String rest = string_substr(pattern, i, pattern.len);
+        s32 run = string_cspan(rest, wildcards);
+        if (run > glob.literal.len)
+            glob.literal = string_substr(rest, 0, run);
+        i += run;
+        if (i < pattern.len) {
+            if (pattern.data[i] == '*')
+                glob.has_star = 1;
+            else
+                glob.min_len++;
+            i++;
+        }
+        glob.min_len += run;
+    }
+    return glob;
+}
+
+// pattern has no '*' and the same length as string
+static int
+glob_match_fixed(String pattern, const char * string)
+{
+    for (s32 i = 0; i < pattern.len; i++) {
+        if (pattern.data[i] != '?' && pattern.data[i] != string[i])
+            return 0;
+    }
+    return 1;
+}
+
+// Segments between stars are matched left to right, each at its leftmost
+// position. Taking the leftmost match is always safe because anything a
+// later position could match is still available to the segments after it,
+// so no segment is ever revisited and there is no backtracking blow-up.
+int
+glob_match(const GlobPattern * glob, String string)
+{
+    if (string.len < glob->min_len)
+        return 0;
+    if (!glob->has_star)
+        return string.len == glob->pattern.len && glob_match_fixed(glob->pattern, string.data);
+
+    if (!string_starts_with(string, glob->prefix) || !string_ends_with(string, glob->suffix))
+        return 0;
+    if (glob->literal.len > MAX(glob->prefix.len, glob->suffix.len) &&
+        string_find(string, glob->literal) == string.len)
+        return 0;
+
+    String pattern = string_substr(glob->pattern, glob->prefix.len, glob->pattern.len - glob->suffix.len);
+    String text    = string_substr(string, glob->prefix.len, string.len - glob->suffix.len);
+
+    // the part before the first star is anchored at the start...
+    s32 star = string_char(pattern, '*');
+    if (!glob_match_fixed(string_substr(pattern, 0, star), text.data))
+        return 0;
+    str_left_adjust(text, star);
+    str_left_adjust(pattern, star);
+
+    // ...and the part after the last star at the end
+    s32 last_star = string_rchar(pattern, '*');
+    String tail = string_substr(pattern, last_star + 1, pattern.len);
+    if (text.len < tail.len || !glob_match_fixed(tail, text.data + text.len - tail.len))
+        return 0;
+    text.len -= tail.len;
+    pattern.len = last_star;
+
+    while (pattern.len > 0) {
+        str_left_adjust(pattern, 1); // skip the star
+        String segment = string_substr(pattern, 0, string_char(pattern, '*'));
+        str_left_adjust(pattern, segment.len);
+        if (segment.len == 0)
+            continue;
+        s32 at;
+        if (string_char(segment, '?') == segment.len) {
+            at = string_find(text, segment);
+            if (at == text.len)
+                return 0;
+        } else {
+            for (at = 0; at <= text.len - segment.len; at++) {
+                if (glob_match_fixed(segment, text.data + at))
+                    break;
+            }
+            if (at > text.len - segment.len)
+                return 0;
+        }
+        str_left_adjust(text, at + segment.len);
+    }
+    return 1;
+}
+
+#define REGEX_EDGE_EPS      -1
+#define REGEX_EDGE_BEGIN    -2  // assertion: at the beginning of the scan
+#define REGEX_EDGE_END      -3  // assertion: at the end of the scan
+
+#define REGEX_MATCH         1
+#define REGEX_DEAD          2
+#define REGEX_END_KNOWN     4
+#define REGEX_END_MATCH     8
+
+#define REGEX_MAX_DEPTH     1000
+
+typedef struct {
+    s32 start;
+    s32 end;
+} RegexFrag;
+
+typedef struct {
+    void * context;
+    String pattern;
+    s32 pos;
+    s32 depth;
+    int error;
+    s32 nstates;
+    s32 nedges, edges_cap;
+    s32 * edge_from;
+    RegexEdge * edges;
+    s32 nsets, sets_cap;
+    u64 (* sets)[4];
+    char run[32];
+    s32 run_len;
+    char best[32];
+    s32 best_len;
+    int top_alt;
+} RegexParser;
+
+static void *
+regex_grow(void * context, void * ptr, s32 * cap, s32 need, size_t elem)
+{
+    if (need <= *cap)
+        return ptr;
+    s32 new_cap = MAX(*cap * 2, MAX(need, 16));
+    ptr = PMK_REALLOC(context, ptr, *cap * elem, new_cap * elem);
+    *cap = new_cap;
+    return ptr;
+}
+
+static s32
+regex_new_state(RegexParser * p)
+{
+    return p->nstates++;
+}
+
+static void
+regex_add_edge(RegexParser * p, s32 from, s32 to, s32 label)
+{
+    s32 cap = p->edges_cap;
+    p->edge_from = regex_grow(p->context, p->edge_from, &cap, p->nedges + 1, sizeof(s32));
+    p->edges = regex_grow(p->context, p->edges, &p->edges_cap, p->nedges + 1, sizeof(RegexEdge));
+    p->edge_from[p->nedges] = from;
+    p->edges[p->nedges] = (RegexEdge) { .to = to, .label = label };
+    p->nedges++;
+}
+
+static s32
+regex_add_set(RegexParser * p, const u64 * set)
+{
+    p->sets = regex_grow(p->context, p->sets, &p->sets_cap, p->nsets + 1, sizeof(p->sets[0]));
+    memcpy(p->sets[p->nsets], set, sizeof(p->sets[0]));
+    return p->nsets++;
+}
+
+static void
+regex_set_add(u64 * set, s32 lo, s32 hi)
+{
+    for (s32 c = lo; c <= hi; c++)
+        set[c >> 6] |= (u64) 1 << (c & 63);
+}
+
+static int
+regex_set_has(const u64 * set, s32 c)
+{
+    return (set[c >> 6] >> (c & 63)) & 1;
+}
+
+// handles \d \w \s and their negations; returns 0 if c is not one of them
+static int
+regex_escape_set(u64 * set, char c)
+{
+    u64 tmp[4] = {0};
+    switch (c) {
+        case 'd': case 'D':
+            regex_set_add(tmp, '0', '9');
+            break;
+        case 'w': case 'W':
+            regex_set_add(tmp, '0', '9');
+            regex_set_add(tmp, 'A', 'Z');
+            regex_set_add(tmp, 'a', 'z');
+            regex_set_add(tmp, '_', '_');
+            break;
+        case 's': case 'S':
+            regex_set_add(tmp, '\t', '\r');
+            regex_set_add(tmp, ' ', ' ');
+            break;
+        default:
+            return 0;
+    }
+    int negate = isupper((unsigned char) c);
+    for (s32 i = 0; i < 4; i++)
+        set[i] |= negate ? ~tmp[i] : tmp[i];
+    return 1;
+}
+
+static u8
+regex_escape_byte(char c)
+{
+    switch (c) {
+        case 'n': return '\n';
+        case 't': return '\t';
+        case 'r': return '\r';
+        case 'f': return '\f';
+        case 'v': return '\v';
+        case '0': return '\0';
+        default:  return (u8) c;
+    }
+}
+
+static RegexFrag
+regex_frag_set(RegexParser * p, const u64 * set)
+{
+    RegexFrag f = { regex_new_state(p), regex_new_state(p) };
+    regex_add_edge(p, f.start, f.end, regex_add_set(p, set));
+    return f;
+}
+
+static RegexFrag regex_parse_alt(RegexParser * p);
+
+static RegexFrag
+regex_parse_class(RegexParser * p)
+{
+    u64 set[4] = {0};
+    String s = p->pattern;
+    int negate = 0;
+    if (p->pos < s.len && s.data[p->pos] == '^') {
+        negate = 1;
+        p->pos++;
+    }
+    s32 first = p->pos;
+    for (;;) {
+        if (p->pos >= s.len) {
+            p->error = 1;
+            return (RegexFrag) {0};
+        }
+        char c = s.data[p->pos++];
+        if (c == ']' && p->pos - 1 > first)
+            break;
+        s32 lo = (u8) c;
+        if (c == '\\') {
+            if (p->pos >= s.len) {
+                p->error = 1;
+                return (RegexFrag) {0};
+            }
+            c = s.data[p->pos++];
+            if (regex_escape_set(set, c))
+                continue;
+            lo = regex_escape_byte(c);
+        }
+        s32 hi = lo;
+        if (p->pos + 1 < s.len && s.data[p->pos] == '-' && s.data[p->pos+1] != ']') {
+            p->pos++;
+            c = s.data[p->pos++];
+            hi = (u8) c;
+            if (c == '\\') {
+                if (p->pos >= s.len) {
+                    p->error = 1;
+                    return (RegexFrag) {0};
+                }
+                hi = regex_escape_byte(s.data[p->pos++]);
+            }
+            if (hi < lo) {
+                p->error = 1;
+                return (RegexFrag) {0};
+            }
+        }
+        regex_set_add(set, lo, hi);
+    }
+    if (negate) {
+        for (s32 i = 0; i < 4; i++)
+            set[i] = ~set[i];
+    }
+    return regex_frag_set(p, set);
+}
+
+// *lit is set to the byte matched if the atom is a single literal, else -1
+static RegexFrag
+regex_parse_atom(RegexParser * p, s32 * lit)
+{
+    String s = p->pattern;
+    u64 set[4] = {0};
+    char c = s.data[p->pos++];
+    *lit = -1;
+    switch (c) {
+        case '(': {
+            if (++p->depth > REGEX_MAX_DEPTH) {
+                p->error = 1;
+                return (RegexFrag) {0};
+            }
+            RegexFrag f = regex_parse_alt(p);
+            p->depth--;
+            if (p->pos >= s.len || s.data[p->pos] != ')')
+                p->error = 1;
+            p->pos++;
+            return f;
+        }
+        case '[':
+            return regex_parse_class(p);
+        case '.':
+            regex_set_add(set, 0, 255);
+            set['\n' >> 6] &= ~((u64) 1 << ('\n' & 63));
+            return regex_frag_set(p, set);
+        case '^':
+        case '$': {
+            RegexFrag f = { regex_new_state(p), regex_new_state(p) };
+            regex_add_edge(p, f.start, f.end, c == '^' ? REGEX_EDGE_BEGIN : REGEX_EDGE_END);
+            return f;
+        }
+        case '*': case '+': case '?': case ')': case '|':
+            p->error = 1;
+            return (RegexFrag) {0};
+        case '\\':
+            if (p->pos >= s.len) {
+                p->error = 1;
+                return (RegexFrag) {0};
+            }
+            c = s.data[p->pos++];
+            if (regex_escape_set(set, c))
+                return regex_frag_set(p, set);
+            c = (char) regex_escape_byte(c);
+            /* fallthrough */
+        default:
+            *lit = (u8) c;
+            regex_set_add(set, (u8) c, (u8) c);
+            return regex_frag_set(p, set);
+    }
+}
+
+// tracks the longest run of required literal bytes at the top level
+static void
+regex_end_run(RegexParser * p)
+{
+    if (p->run_len > p->best_len) {
+        memcpy(p->best, p->run, p->run_len);
+        p->best_len = p->run_len;
+    }
+    p->run_len = 0;
+}
+
+static RegexFrag
+regex_parse_concat(RegexParser * p)
+{
+    String s = p->pattern;
+    RegexFrag result = { regex_new_state(p), 0 };
+    result.end = result.start;
+    while (!p->error && p->pos < s.len && s.data[p->pos] != '|' && s.data[p->pos] != ')') {
+        s32 lit;
+        RegexFrag f = regex_parse_atom(p, &lit);
+        int quantified = 0;
+        int optional = 0;
+        while (!p->error && p->pos < s.len) {
+            char q = s.data[p->pos];
+            if (q != '*' && q != '+' && q != '?')
+                break;
+            p->pos++;
+            RegexFrag g = { regex_new_state(p), regex_new_state(p) };
+            regex_add_edge(p, g.start, f.start, REGEX_EDGE_EPS);
+            regex_add_edge(p, f.end, g.end, REGEX_EDGE_EPS);
+            if (q != '+')
+                regex_add_edge(p, g.start, g.end, REGEX_EDGE_EPS);
+            if (q != '?')
+                regex_add_edge(p, f.end, f.start, REGEX_EDGE_EPS);
+            quantified = 1;
+            optional |= q != '+';
+            f = g;
+        }
+        if (p->depth == 0) {
+            if (lit >= 0 && !optional && p->run_len < (s32) sizeof(p->run))
+                p->run[p->run_len++] = (char) lit;
+            if (lit < 0 || quantified)
+                regex_end_run(p);
+        }
+        regex_add_edge(p, result.end, f.start, REGEX_EDGE_EPS);
+        result.end = f.end;
+    }
+    if (p->depth == 0)
+        regex_end_run(p);
+    return result;
+}
+
+static RegexFrag
+regex_parse_alt(RegexParser * p)
+{
+    RegexFrag f = regex_parse_concat(p);
+    while (!p->error && p->pos < p->pattern.len && p->pattern.data[p->pos] == '|') {
+        p->pos++;
+        if (p->depth == 0)
+            p->top_alt = 1;
+        RegexFrag g = regex_parse_concat(p);
+        RegexFrag alt = { regex_new_state(p), regex_new_state(p) };
+        regex_add_edge(p, alt.start, f.start, REGEX_EDGE_EPS);
+        regex_add_edge(p, alt.start, g.start, REGEX_EDGE_EPS);
+        regex_add_edge(p, f.end, alt.end, REGEX_EDGE_EPS);
+        regex_add_edge(p, g.end, alt.end, REGEX_EDGE_EPS);
+        f = alt;
+    }
+    return f;
+}
+
+// builds the adjacency lists, reversing every edge for the reverse NFA
+static void
+regex_build_nfa(Regex * re, RegexParser * p, RegexNfa * nfa, int reverse, RegexFrag frag)
+{
+    s32 n = p->nstates;
+    nfa->start  = reverse ? frag.end : frag.start;
+    nfa->accept = reverse ? frag.start : frag.end;
+    nfa->edge_index = PMK_MALLOC(re->context, (n + 1) * sizeof(s32));
+    nfa->edges = PMK_MALLOC(re->context, MAX(p->nedges, 1) * sizeof(RegexEdge));
+    nfa->important = PMK_MALLOC(re->context, n);
+    memset(nfa->edge_index, 0, (n + 1) * sizeof(s32));
+    for (s32 i = 0; i < p->nedges; i++) {
+        s32 from = reverse ? p->edges[i].to : p->edge_from[i];
+        nfa->edge_index[from + 1]++;
+    }
+    for (s32 i = 0; i < n; i++)
+        nfa->edge_index[i + 1] += nfa->edge_index[i];
+    for (s32 i = 0; i < p->nedges; i++) {
+        s32 from  = reverse ? p->edges[i].to : p->edge_from[i];
+        s32 to    = reverse ? p->edge_from[i] : p->edges[i].to;
+        s32 label = p->edges[i].label;
+        if (reverse && label == REGEX_EDGE_BEGIN)
+            label = REGEX_EDGE_END;
+        else if (reverse && label == REGEX_EDGE_END)
+            label = REGEX_EDGE_BEGIN;
+        // edge_index[from] is used as a cursor and restored below
+        nfa->edges[nfa->edge_index[from]++] = (RegexEdge) { .to = to, .label = label };
+    }
+    for (s32 i = n; i > 0; i--)
+        nfa->edge_index[i] = nfa->edge_index[i - 1];
+    nfa->edge_index[0] = 0;
+
+    for (s32 i = 0; i < n; i++) {
+        nfa->important[i] = (i == nfa->accept);
+        for (s32 e = nfa->edge_index[i]; e < nfa->edge_index[i + 1]; e++) {
+            if (nfa->edges[e].label >= 0 || nfa->edges[e].label == REGEX_EDGE_END)
+                nfa->important[i] = 1;
+        }
+    }
+}
+
+static void
+regex_init_dfa(Regex * re, RegexDfa * dfa, int reverse, int unanchored)
+{
+    dfa->reverse = reverse;
+    dfa->unanchored = unanchored;
+    dfa->trans = PMK_MALLOC(re->context, REGEX_CACHE_STATES * re->nclasses * sizeof(s32));
+    dfa->flags = PMK_MALLOC(re->context, REGEX_CACHE_STATES);
+    dfa->set_index = PMK_MALLOC(re->context, (REGEX_CACHE_STATES + 1) * sizeof(s32));
+    dfa->pool_cap = REGEX_CACHE_STATES * 16 + 2 * re->nnfa;
+    dfa->set_pool = PMK_MALLOC(re->context, dfa->pool_cap * sizeof(s32));
+    dfa->table = PMK_MALLOC(re->context, 2 * REGEX_CACHE_STATES * sizeof(s32));
+    dfa->nstates = 0;
+    dfa->set_index[0] = 0;
+    dfa->start_state[0] = dfa->start_state[1] = -1;
+    memset(dfa->table, 0xff, 2 * REGEX_CACHE_STATES * sizeof(s32));
+}
+
+Regex
+regex_compile_context(void * context, String pattern)
+{
+    Regex re = { .context = context };
+    RegexParser p = { .context = context, .pattern = pattern };
+    RegexFrag frag = regex_parse_alt(&p);
+    if (p.pos < pattern.len)
+        p.error = 1; // unbalanced ')'
+    if (p.error) {
+        PMK_FREE(context, p.edge_from);
+        PMK_FREE(context, p.edges);
+        PMK_FREE(context, p.sets);
+        re.error = -EINVAL;
+        return re;
+    }
+
+    re.nnfa = p.nstates;
+    re.nsets = p.nsets;
+    re.sets = p.sets;
+    if (!p.top_alt && p.best_len > 0) {
+        memcpy(re.literal, p.best, p.best_len);
+        re.literal_len = p.best_len;
+    }
+
+    // bytes which no set tells apart share a class, which keeps the
+    // transition tables narrow
+    memset(re.byte_class, 0, sizeof(re.byte_class));
+    re.nclasses = 1;
+    for (s32 i = 0; i < re.nsets; i++) {
+        s32 remap[256][2];
+        memset(remap, 0xff, sizeof(remap));
+        s32 n = 0;
+        for (s32 c = 0; c < 256; c++) {
+            s32 in = regex_set_has(re.sets[i], c);
+            s32 * slot = &remap[re.byte_class[c]][in];
+            if (*slot < 0)
+                *slot = n++;
+            re.byte_class[c] = (u8) *slot;
+        }
+        re.nclasses = n;
+    }
+    for (s32 c = 255; c >= 0; c--)
+        re.class_rep[re.byte_class[c]] = (u8) c;
+
+    regex_build_nfa(&re, &p, &re.nfa[0], 0, frag);
+    regex_build_nfa(&re, &p, &re.nfa[1], 1, frag);
+    PMK_FREE(context, p.edge_from);
+    PMK_FREE(context, p.edges);
+
+    re.stack = PMK_MALLOC(context, re.nnfa * sizeof(s32));
+    re.scratch[0] = PMK_MALLOC(context, (re.nnfa + 1) * sizeof(s32));
+    re.scratch[1] = PMK_MALLOC(context, (re.nnfa + 1) * sizeof(s32));
+    re.marks = PMK_MALLOC(context, re.nnfa * sizeof(u32));
+    memset(re.marks, 0, re.nnfa * sizeof(u32));
+
+    regex_init_dfa(&re, &re.forward,  0, 1);
+    regex_init_dfa(&re, &re.reverse,  1, 1);
+    regex_init_dfa(&re, &re.anchored, 0, 0);
+    return re;
+}
+
+static void
+regex_destroy_dfa(Regex * re, RegexDfa * dfa)
+{
+    PMK_FREE(re->context, dfa->trans);
+    PMK_FREE(re->context, dfa->flags);
+    PMK_FREE(re->context, dfa->set_index);
+    PMK_FREE(re->context, dfa->set_pool);
+    PMK_FREE(re->context, dfa->table);
+}
+
+void
+regex_destroy(Regex * re)
+{
+    if (re->error == 0) {
+        for (s32 i = 0; i < 2; i++) {
+            PMK_FREE(re->context, re->nfa[i].edge_index);
+            PMK_FREE(re->context, re->nfa[i].edges);
+            PMK_FREE(re->context, re->nfa[i].important);
+        }
+        regex_destroy_dfa(re, &re->forward);
+        regex_destroy_dfa(re, &re->reverse);
+        regex_destroy_dfa(re, &re->anchored);
+        PMK_FREE(re->context, re->sets);
+        PMK_FREE(re->context, re->stack);
+        PMK_FREE(re->context, re->scratch[0]);
+        PMK_FREE(re->context, re->scratch[1]);
+        PMK_FREE(re->context, re->marks);
+    }
+    *re = (Regex) {0};
+}
+
+static int
+regex_compare_s32(const void * a, const void * b)
+{
+    s32 x = *(const s32 *) a;
+    s32 y = *(const s32 *) b;
+    return (x > y) - (x < y);
+}
+
+// epsilon closure of seed[0..n) into out, keeping only important states,
+// sorted; returns the size of the set
+static s32
+regex_closure(Regex * re, const RegexNfa * nfa, const s32 * seed, s32 n, int at_begin, int at_end, s32 * out)
+{
+    if (++re->generation == 0) {
+        memset(re->marks, 0, re->nnfa * sizeof(u32));
+        re->generation = 1;
+    }
+    u32 gen = re->generation;
+    s32 sp = 0;
+    s32 count = 0;
+    for (s32 i = 0; i < n; i++) {
+        if (re->marks[seed[i]] != gen) {
+            re->marks[seed[i]] = gen;
+            re->stack[sp++] = seed[i];
+        }
+    }
+    while (sp > 0) {
+        s32 q = re->stack[--sp];
+        if (nfa->important[q])
+            out[count++] = q;
+        for (s32 e = nfa->edge_index[q]; e < nfa->edge_index[q + 1]; e++) {
+            s32 label = nfa->edges[e].label;
+            if (label == REGEX_EDGE_EPS ||
+                (label == REGEX_EDGE_BEGIN && at_begin) ||
+                (label == REGEX_EDGE_END && at_end)) {
+                s32 to = nfa->edges[e].to;
+                if (re->marks[to] != gen) {
+                    re->marks[to] = gen;
+                    re->stack[sp++] = to;
+                }
+            }
+        }
+    }
+    qsort(out, count, sizeof(s32), regex_compare_s32);
+    return count;
+}
+
+static void
+regex_flush(RegexDfa * dfa)
+{
+    dfa->nstates = 0;
+    dfa->set_index[0] = 0;
+    dfa->start_state[0] = dfa->start_state[1] = -1;
+    memset(dfa->table, 0xff, 2 * REGEX_CACHE_STATES * sizeof(s32));
+}
+
+// returns the DFA state for the given set of NFA states, adding it if need
+// be, or -1 if the cache is full
+static s32
+regex_add_state(Regex * re, RegexDfa * dfa, const s32 * set, s32 n)
+{
+    u32 h = 2166136261u;
+    for (s32 i = 0; i < n; i++)
+        h = (h ^ (u32) set[i]) * 16777619u;
+    u32 mask = 2 * REGEX_CACHE_STATES - 1;
+    for (u32 slot = h & mask; ; slot = (slot + 1) & mask) {
+        s32 state = dfa->table[slot];
+        if (state < 0) {
+            if (dfa->nstates == REGEX_CACHE_STATES || dfa->set_index[dfa->nstates] + n > dfa->pool_cap)
+                return -1;
+            state = dfa->nstates++;
+            s32 * dst = dfa->set_pool + dfa->set_index[state];
+            memcpy(dst, set, n * sizeof(s32));
+            dfa->set_index[state + 1] = dfa->set_index[state] + n;
+            const RegexNfa * nfa = &re->nfa[dfa->reverse];
+            u8 flags = 0;
+            for (s32 i = 0; i < n; i++) {
+                if (set[i] == nfa->accept)
+                    flags |= REGEX_MATCH;
+            }
+            if (n == 0 && !dfa->unanchored)
+                flags |= REGEX_DEAD;
+            dfa->flags[state] = flags;
+            memset(dfa->trans + state * re->nclasses, 0xff, re->nclasses * sizeof(s32));
+            dfa->table[slot] = state;
+            return state;
+        }
+        s32 len = dfa->set_index[state + 1] - dfa->set_index[state];
+        if (len == n && memcmp(dfa->set_pool + dfa->set_index[state], set, n * sizeof(s32)) == 0)
+            return state;
+    }
+}
+
+static s32
+regex_start(Regex * re, RegexDfa * dfa, int at_begin)
+{
+    if (dfa->start_state[at_begin] >= 0)
+        return dfa->start_state[at_begin];
+    const RegexNfa * nfa = &re->nfa[dfa->reverse];
+    s32 n = regex_closure(re, nfa, &nfa->start, 1, at_begin, 0, re->scratch[1]);
+    s32 state = regex_add_state(re, dfa, re->scratch[1], n);
+    if (state < 0) {
+        regex_flush(dfa);
+        state = regex_add_state(re, dfa, re->scratch[1], n);
+    }
+    dfa->start_state[at_begin] = state;
+    return state;
+}
+
+// builds the transition from state on byte class cls
+static s32
+regex_step_slow(Regex * re, RegexDfa * dfa, s32 state, s32 cls)
+{
+    const RegexNfa * nfa = &re->nfa[dfa->reverse];
+    u8 rep = re->class_rep[cls];
+    s32 * seed = re->scratch[0];
+    s32 n = 0;
+    // every NFA state has at most one byte edge, so seed cannot overflow
+    for (s32 i = dfa->set_index[state]; i < dfa->set_index[state + 1]; i++) {
+        s32 q = dfa->set_pool[i];
+        for (s32 e = nfa->edge_index[q]; e < nfa->edge_index[q + 1]; e++) {
+            s32 label = nfa->edges[e].label;
+            if (label >= 0 && regex_set_has(re->sets[label], rep))
+                seed[n++] = nfa->edges[e].to;
+        }
+    }
+    if (dfa->unanchored)
+        seed[n++] = nfa->start;
+    n = regex_closure(re, nfa, seed, n, 0, 0, re->scratch[1]);
+    s32 next = regex_add_state(re, dfa, re->scratch[1], n);
+    if (next < 0) {
+        // the cache is full: start over; state no longer exists, so the
+        // transition is not recorded
+        regex_flush(dfa);
+        return regex_add_state(re, dfa, re->scratch[1], n);
+    }
+    dfa->trans[state * re->nclasses + cls] = next;
+    return next;
+}
+
+// whether the state matches when the scan ends here ('$' for the forward
+// direction, '^' for the reverse)
+static int
+regex_accepts_at_end(Regex * re, RegexDfa * dfa, s32 state)
+{
+    u8 flags = dfa->flags[state];
+    if (!(flags & REGEX_END_KNOWN)) {
+        const RegexNfa * nfa = &re->nfa[dfa->reverse];
+        s32 start = dfa->set_index[state];
+        s32 n = regex_closure(re, nfa, dfa->set_pool + start, dfa->set_index[state + 1] - start,
+                              0, 1, re->scratch[1]);
+        flags |= REGEX_END_KNOWN;
+        for (s32 i = 0; i < n; i++) {
+            if (re->scratch[1][i] == nfa->accept)
+                flags |= REGEX_END_MATCH;
+        }
+        dfa->flags[state] = flags;
+    }
+    return (flags & REGEX_END_MATCH) != 0;
+}
+
+#define REGEX_STEP(RE, DFA, STATE, BYTE) do { \
+    s32 cls_ = (RE)->byte_class[(u8) (BYTE)]; \
+    s32 next_ = (DFA)->trans[(STATE) * (RE)->nclasses + cls_]; \
+    (STATE) = (next_ >= 0) ? next_ : regex_step_slow(RE, DFA, STATE, cls_); \
+} while (0)
+
+int
+regex_find(Regex * re, String string, String * match)
+{
+    if (re->error)
+        return 0;
+    if (re->literal_len > 0) {
+        String literal = { .data = re->literal, .len = re->literal_len };
+        if (string_find(string, literal) == string.len)
+            return 0;
+    }
+
+    // is there a match at all? stops at the earliest end of any match
+    RegexDfa * dfa = &re->forward;
+    s32 state = regex_start(re, dfa, 1);
+    int found = dfa->flags[state] & REGEX_MATCH;
+    for (s32 i = 0; i < string.len && !found; i++) {
+        REGEX_STEP(re, dfa, state, string.data[i]);
+        found = dfa->flags[state] & REGEX_MATCH;
+    }
+    if (!found && !regex_accepts_at_end(re, dfa, state))
+        return 0;
+
+    // the leftmost start is the last position at which the reversed regex
+    // matches when scanning backwards from the end
+    dfa = &re->reverse;
+    state = regex_start(re, dfa, 1);
+    s32 start = (dfa->flags[state] & REGEX_MATCH) ? string.len : -1;
+    for (s32 i = string.len - 1; i >= 0; i--) {
+        REGEX_STEP(re, dfa, state, string.data[i]);
+        if (dfa->flags[state] & REGEX_MATCH)
+            start = i;
+    }
+    if (regex_accepts_at_end(re, dfa, state))
+        start = 0;
+    assert(start >= 0);
+
+    // the longest match from there
+    dfa = &re->anchored;
+    state = regex_start(re, dfa, start == 0);
+    s32 end = (dfa->flags[state] & REGEX_MATCH) ? start : -1;
+    s32 i = start;
+    for (; i < string.len && !(dfa->flags[state] & REGEX_DEAD); i++) {
+        REGEX_STEP(re, dfa, state, string.data[i]);
+        if (dfa->flags[state] & REGEX_MATCH)
+            end = i + 1;
+    }
+    if (i == string.len && !(dfa->flags[state] & REGEX_DEAD) && regex_accepts_at_end(re, dfa, state))
+        end = string.len;
+    assert(end >= start);
+
+    if (match)
+        *match = string_substr(string, start, end);
+    return 1;
+}
+
+#undef REGEX_STEP
+
+// SA-IS (Nong, Zhang & Chan). The text is either bytes (t8) or, in the
+// recursive calls, the s32 names of the LMS substrings (t32). A virtual
+// sentinel smaller than every character follows the text, so it need not
+// be stored.
+
+#define SAIS_CHR(I)     (t8 ? (s32) t8[I] : t32[I])
+#define SAIS_IS_S(I)    ((types[(I) >> 3] >> ((I) & 7)) & 1)
+#define SAIS_IS_LMS(I)  ((I) > 0 && SAIS_IS_S(I) && !SAIS_IS_S((I) - 1))
+
+// sets bit i of types if suffix i is S-type, i.e. smaller than suffix i+1
+static void
+sais_types(const u8 * t8, const s32 * t32, s32 n, u8 * types)
+{
+    memset(types, 0, (size_t) n / 8 + 1);
+    for (s32 i = n - 2; i >= 0; i--) {
+        s32 c = SAIS_CHR(i), d = SAIS_CHR(i + 1);
+        if (c < d || (c == d && SAIS_IS_S(i + 1)))
+            types[i >> 3] |= 1 << (i & 7);
+    }
+}
+
+static void
+sais_buckets(const u8 * t8, const s32 * t32, s32 n, s32 k, s32 * bkt, int end)
+{
+    memset(bkt, 0, k * sizeof(s32));
+    for (s32 i = 0; i < n; i++)
+        bkt[SAIS_CHR(i)]++;
+    s32 sum = 0;
+    for (s32 c = 0; c < k; c++) {
+        sum += bkt[c];
+        bkt[c] = end ? sum : sum - bkt[c];
+    }
+}
+
+static void
+sais_induce(const u8 * t8, const s32 * t32, s32 * sa, s32 n, s32 k, const u8 * types, s32 * bkt)
+{
+    sais_buckets(t8, t32, n, k, bkt, 0);
+    // the sentinel comes first and the suffix before it is always L-type
+    sa[bkt[SAIS_CHR(n - 1)]++] = n - 1;
+    for (s32 i = 0; i < n; i++) {
+        s32 j = sa[i] - 1;
+        if (sa[i] > 0 && !SAIS_IS_S(j))
+            sa[bkt[SAIS_CHR(j)]++] = j;
+    }
+    sais_buckets(t8, t32, n, k, bkt, 1);
+    for (s32 i = n - 1; i >= 0; i--) {
+        s32 j = sa[i] - 1;
+        if (sa[i] > 0 && SAIS_IS_S(j))
+            sa[--bkt[SAIS_CHR(j)]] = j;
+    }
+}
+
+// spare[0..spare_len) is unused memory the bucket counters may live in
+static void
+sais(void * context, const u8 * t8, const s32 * t32, s32 * sa, s32 n, s32 k, s32 * spare, s32 spare_len)
+{
+    if (n <= 1) {
+        if (n == 1)
+            sa[0] = 0;
+        return;
+    }
+
+    u8 * types = PMK_MALLOC(context, (size_t) n / 8 + 1);
+    sais_types(t8, t32, n, types);
+    s32 * bkt = k <= spare_len ? spare : PMK_MALLOC(context, k * sizeof(s32));
+
+    // sort the LMS substrings by placing them at the ends of their buckets
+    // and inducing
+    sais_buckets(t8, t32, n, k, bkt, 1);
+    for (s32 i = 0; i < n; i++)
+        sa[i] = -1;
+    for (s32 i = n - 1; i > 0; i--) {
+        if (SAIS_IS_LMS(i))
+            sa[--bkt[SAIS_CHR(i)]] = i;
+    }
+    sais_induce(t8, t32, sa, n, k, types, bkt);
+
+    s32 n1 = 0;
+    for (s32 i = 0; i < n; i++) {
+        if (SAIS_IS_LMS(sa[i]))
+            sa[n1++] = sa[i];
+    }
+
+    // name them; LMS positions are at least two apart, so sa[n1 + pos/2]
+    // has room for every name
+    for (s32 i = n1; i < n; i++)
+        sa[i] = -1;
+    s32 name = 0;
+    s32 prev = -1;
+    for (s32 i = 0; i < n1; i++) {
+        s32 pos = sa[i];
+        int diff = 0;
+        for (s32 d = 0; ; d++) {
+            if (prev < 0 || pos + d == n || prev + d == n ||
+                SAIS_CHR(pos + d) != SAIS_CHR(prev + d) ||
+                SAIS_IS_S(pos + d) != SAIS_IS_S(prev + d)) {
+                diff = 1;
+                break;
+            }
+            if (d > 0 && (SAIS_IS_LMS(pos + d) || SAIS_IS_LMS(prev + d)))
+                break;
+        }
+        if (diff) {
+            name++;
+            prev = pos;
+        }
+        sa[n1 + pos / 2] = name - 1;
+    }
+    for (s32 i = n - 1, j = n - 1; i >= n1; i--) {
+        if (sa[i] >= 0)
+            sa[j--] = sa[i];
+    }
+
+    // sort the reduced string, recursing only if the names are not unique.
+    // The types and counters are rebuilt afterwards, so only one level's
+    // are held at a time, and the recursion keeps its counters between sa1
+    // and s1 when they fit.
+    s32 * s1 = sa + n - n1;
+    s32 * sa1 = sa;
+    if (name < n1) {
+        if (bkt != spare)
+            PMK_FREE(context, bkt);
+        PMK_FREE(context, types);
+        sais(context, NULL, s1, sa1, n1, name, sa + n1, n - 2 * n1);
+        types = PMK_MALLOC(context, (size_t) n / 8 + 1);
+        sais_types(t8, t32, n, types);
+        bkt = k <= spare_len ? spare : PMK_MALLOC(context, k * sizeof(s32));
+    } else {
+        for (s32 i = 0; i < n1; i++)
+            sa1[s1[i]] = i;
+    }
+
+    // place the sorted LMS suffixes and induce the rest
+    for (s32 i = 1, j = 0; i < n; i++) {
+        if (SAIS_IS_LMS(i))
+            s1[j++] = i;
+    }
+    for (s32 i = 0; i < n1; i++)
+        sa1[i] = s1[sa1[i]];
+    for (s32 i = n1; i < n; i++)
+        sa[i] = -1;
+    sais_buckets(t8, t32, n, k, bkt, 1);
+    for (s32 i = n1 - 1; i >= 0; i--) {
+        s32 j = sa[i];
+        sa[i] = -1;
+        sa[--bkt[SAIS_CHR(j)]] = j;
+    }
+    sais_induce(t8, t32, sa, n, k, types, bkt);
+
+    if (bkt != spare)
+        PMK_FREE(context, bkt);
+    PMK_FREE(context, types);
+}
+
+#undef SAIS_CHR
+#undef SAIS_IS_S
+#undef SAIS_IS_LMS
+
+SuffixArray
+sa_build_context(void * context, String text)
+{
+    SuffixArray sa = { .text = text };
+    sa.sa = PMK_MALLOC(context, MAX(text.len, 1) * sizeof(s32));
+    sais(context, (const u8 *) text.data, NULL, sa.sa, text.len, 256, NULL, 0);
+    return sa;
+}
+
+// Kasai et al.
+void
+sa_build_lcp_context(void * context, SuffixArray * sa)
+{
+    s32 n = sa->text.len;
+    const u8 * t = (const u8 *) sa->text.data;
+    s32 * rank = PMK_MALLOC(context, MAX(n, 1) * sizeof(s32));
+    sa->lcp = PMK_MALLOC(context, MAX(n, 1) * sizeof(s32));
+    for (s32 i = 0; i < n; i++)
+        rank[sa->sa[i]] = i;
+    s32 h = 0;
+    for (s32 i = 0; i < n; i++) {
+        if (rank[i] == 0) {
+            sa->lcp[0] = 0;
+            h = 0;
+            continue;
+        }
+        s32 j = sa->sa[rank[i] - 1];
+        while (i + h < n && j + h < n && t[i + h] == t[j + h])
+            h++;
+        sa->lcp[rank[i]] = h;
+        if (h > 0)
+            h--;
+    }
+    PMK_FREE(context, rank);
+}
+
+void
+sa_destroy_context(void * context, SuffixArray * sa)
+{
+    PMK_FREE(context, sa->sa);
+    if (sa->lcp)
+        PMK_FREE(context, sa->lcp);
+    *sa = (SuffixArray) {0};
+}
+
+// compares the first needle.len bytes of the suffix at pos with needle; a
+// suffix shorter than needle compares less if it is a prefix of it
+static int
+sa_compare(const SuffixArray * sa, s32 pos, String needle)
+{
+    s32 avail = sa->text.len - pos;
+    int cmp = memcmp(sa->text.data + pos, needle.data, MIN(avail, needle.len));
+    if (cmp == 0 && avail < needle.len)
+        return -1;
+    return cmp;
+}
+
+s32
+sa_find_all(const SuffixArray * sa, String needle, s32 * first)
+{
+    s32 lo = 0, hi = sa->text.len;
+    while (lo < hi) {
+        s32 mid = lo + (hi - lo) / 2;
+        if (sa_compare(sa, sa->sa[mid], needle) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    s32 begin = lo;
+    hi = sa->text.len;
+    while (lo < hi) {
+        s32 mid = lo + (hi - lo) / 2;
+        if (sa_compare(sa, sa->sa[mid], needle) <= 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    *first = begin;
+    return lo - begin;
+}
+
+#define TRIGRAM(P) ((u32) (u8) (P)[0] << 16 | (u32) (u8) (P)[1] << 8 | (u32) (u8) (P)[2])
+
+static u32
+trigram_slot(const TrigramIndex * index, u32 trigram)
+{
+    // the top bits of the product depend on every bit of the trigram; cap
+    // is a power of two of at least 1024
+    u32 mask = (u32) index->cap - 1;
+    u32 slot = (trigram * 0x9e3779b1u) >> (32 - ctz64((u64) index->cap));
+    while (index->keys[slot] != trigram && index->keys[slot] != TRIGRAM_EMPTY)
+        slot = (slot + 1) & mask;
+    return slot;
+}
+
+// Two passes over the documents: the first finds the distinct trigrams and
+// the encoded size of each posting list, the second writes the lists into a
+// single exactly-sized buffer. Documents are visited in order, so comparing
+// with the last document seen per trigram is enough to drop duplicates.
+TrigramIndex
+trigram_index_build_context(void * context, const String * docs, s32 count)
+{
+    TrigramIndex index = { .docs = docs, .ndocs = count, .cap = 1024 };
+    index.keys = PMK_MALLOC(context, index.cap * sizeof(u32));
+    memset(index.keys, 0xff, index.cap * sizeof(u32));
+    s32 * last = PMK_MALLOC(context, index.cap * sizeof(s32));
+    s32 * size = PMK_MALLOC(context, index.cap * sizeof(s32));
+    s32 used = 0;
+
+    for (s32 d = 0; d < count; d++) {
+        for (s32 i = 0; i + 3 <= docs[d].len; i++) {
+            u32 t = TRIGRAM(docs[d].data + i);
+            u32 slot = trigram_slot(&index, t);
+            if (index.keys[slot] == TRIGRAM_EMPTY) {
+                if (2 * (used + 1) > index.cap) {
+                    // rehash into a table twice the size
+                    TrigramIndex bigger = { .cap = index.cap * 2 };
+                    bigger.keys = PMK_MALLOC(context, bigger.cap * sizeof(u32));
+                    memset(bigger.keys, 0xff, bigger.cap * sizeof(u32));
+                    s32 * bigger_last = PMK_MALLOC(context, bigger.cap * sizeof(s32));
+                    s32 * bigger_size = PMK_MALLOC(context, bigger.cap * sizeof(s32));
+                    for (s32 j = 0; j < index.cap; j++) {
+                        if (index.keys[j] == TRIGRAM_EMPTY)
+                            continue;
+                        u32 to = trigram_slot(&bigger, index.keys[j]);
+                        bigger.keys[to] = index.keys[j];
+                        bigger_last[to] = last[j];
+                        bigger_size[to] = size[j];
+                    }
+                    PMK_FREE(context, index.keys);
+                    PMK_FREE(context, last);
+                    PMK_FREE(context, size);
+                    index.keys = bigger.keys;
+                    index.cap = bigger.cap;
+                    last = bigger_last;
+                    size = bigger_size;
+                    slot = trigram_slot(&index, t);
+                }
+                index.keys[slot] = t;
+                last[slot] = -1;
+                size[slot] = 0;
+                used++;
+            }
+            if (last[slot] != d) {
+                size[slot] += varint_len((u64) (d - last[slot] - 1));
+                last[slot] = d;
+            }
+        }
+    }
+
+    index.counts = PMK_MALLOC(context, index.cap * sizeof(s32));
+    index.offsets = PMK_MALLOC(context, (index.cap + 1) * sizeof(s32));
+    s64 total = 0;
+    for (s32 j = 0; j < index.cap; j++) {
+        index.offsets[j] = (s32) total;
+        index.counts[j] = 0;
+        if (index.keys[j] != TRIGRAM_EMPTY)
+            total += size[j];
+        assert(total <= INT32_MAX);
+        last[j] = -1;
+        size[j] = 0; // reused as the write cursor
+    }
+    index.offsets[index.cap] = (s32) total;
+    index.postings = PMK_MALLOC(context, MAX(total, 1));
+
+    for (s32 d = 0; d < count; d++) {
+        for (s32 i = 0; i + 3 <= docs[d].len; i++) {
+            u32 slot = trigram_slot(&index, TRIGRAM(docs[d].data + i));
+            if (last[slot] != d) {
+                u8 * dst = index.postings + index.offsets[slot] + size[slot];
+                size[slot] += encode_varint(dst, (u64) (d - last[slot] - 1));
+                last[slot] = d;
+                index.counts[slot]++;
+            }
+        }
+    }
+
+    PMK_FREE(context, last);
+    PMK_FREE(context, size);
+    return index;
+}
+
+void
+trigram_index_destroy_context(void * context, TrigramIndex * index)
+{
+    PMK_FREE(context, index->keys);
+    PMK_FREE(context, index->counts);
+    PMK_FREE(context, index->offsets);
+    PMK_FREE(context, index->postings);
+    *index = (TrigramIndex) {0};
+}
+
+s32
+trigram_index_find(const TrigramIndex * index, String needle, s32 * out)
+{
+    s32 n = 0;
+    if (needle.len < 3) {
+        // too short to have a trigram: check every document
+        for (s32 d = 0; d < index->ndocs; d++) {
+            if (needle.len == 0 || string_find(index->docs[d], needle) < index->docs[d].len)
+                out[n++] = d;
+        }
+        return n;
+    }
+
+    // the distinct trigrams of the needle, rarest first
+    u32 slots[64];
+    s32 nslots = 0;
+    for (s32 i = 0; i + 3 <= needle.len; i++) {
+        u32 slot = trigram_slot(index, TRIGRAM(needle.data + i));
+        if (index->keys[slot] == TRIGRAM_EMPTY)
+            return 0;
+        s32 j = 0;
+        while (j < nslots && slots[j] != slot)
+            j++;
+        if (j < nslots)
+            continue;
+        if (nslots == (s32) (sizeof(slots)/sizeof(slots[0]))) {
+            // enough to narrow things down; verification does the rest
+            break;
+        }
+        // insertion sort by posting list length
+        for (j = nslots++; j > 0 && index->counts[slots[j-1]] > index->counts[slot]; j--)
+            slots[j] = slots[j-1];
+        slots[j] = slot;
+    }
+
+    // decode the shortest list, then intersect the others into it in place
+    for (s32 k = 0; k < nslots && (k == 0 || n > 0); k++) {
+        String list = {
+            .data = (char *) index->postings + index->offsets[slots[k]],
+            .len = index->offsets[slots[k] + 1] - index->offsets[slots[k]],
+        };
+        StringReader reader = reader_from_string(list);
+        s32 doc = -1;
+        u64 delta;
+        if (k == 0) {
+            while (reader_read_varint(&reader, &delta) == 0)
+                out[n++] = doc += (s32) delta + 1;
+            continue;
+        }
+        s32 kept = 0;
+        for (s32 i = 0; i < n; i++) {
+            while (doc < out[i] && reader_read_varint(&reader, &delta) == 0)
+                doc += (s32) delta + 1;
+            if (doc == out[i])
+                out[kept++] = out[i];
+            else if (doc < out[i])
+                break; // list exhausted
+        }
+        n = kept;
+    }
+
+    s32 found = 0;
+    for (s32 i = 0; i < n; i++) {
+        String doc = index->docs[out[i]];
+        if (string_find(doc, needle) < doc.len)
+            out[found++] = out[i];
+    }
+    return found;
+}
+
+#undef TRIGRAM
+
+#define HASH_K1 0x9e3779b97f4a7c15ull
+#define HASH_K2 0xc2b2ae3d27d4eb4full
+
+static u64
+rotl64(u64 x, s32 r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static u64
+hash_fmix64(u64 h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdull;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ull;
+    h ^= h >> 33;
+    return h;
+}
+
+// the 1 to 7 bytes at p as a little-endian word, zero-padded; overlapping
+// loads avoid a copy and a byte loop
+static u64
+load_tail_le(const u8 * p, s32 n)
+{
+    if (n >= 4) {
+        u64 lo = load_u32_le(p), hi = load_u32_le(p + n - 4);
+        return lo | hi << (8 * (n - 4));
+    }
+    return (u64) p[0] | (u64) p[n / 2] << (8 * (n / 2)) | (u64) p[n - 1] << (8 * (n - 1));
+}
+
+// Each little-endian word is multiplied before it is mixed in, which keeps
+// the multiply off the dependency chain through h. The length seeds h, so
+// zero-padding the last word cannot make two strings collide.
+u64
+string_hash(String string)
+{
+    const u8 * p = (const u8 *) string.data;
+    s32 n = string.len;
+    u64 h = HASH_K2 ^ (u64) n * HASH_K1;
+    for (; n >= 8; n -= 8, p += 8)
+        h = rotl64(h ^ load_u64_le(p) * HASH_K2, 31) * HASH_K1;
+    if (n > 0)
+        h = rotl64(h ^ load_tail_le(p, n) * HASH_K2, 31) * HASH_K1;
+    return hash_fmix64(h);
+}
+
+u32
+phash_index(u64 hash, u32 displacement, u32 n)
+{
+    u64 x = (hash ^ (u64) displacement * HASH_K1) * 0xff51afd7ed558ccdull;
+    return (u32) (((x >> 32) * n) >> 32);
+}
+
+void
+string_hash_batch(const String * keys, s32 n, u64 * out)
+{
+    // the keys are independent, so out-of-order execution overlaps their
+    // multiply chains; AVX2 lanes would need three 32-bit multiplies for each
+    // 64-bit one, which measured slower than this loop
+    for (s32 i = 0; i < n; i++)
+        out[i] = string_hash(keys[i]);
+}
+
+// splitmix64 outputs for seeds HASH_K1, 2*HASH_K1, ...; constant rather
+// than generated on first use, so that concurrent callers need no
+// synchronization
+static const u64 gear_table[256] = {
+    0xe220a8397b1dcdafull, 0x6e789e6aa1b965f4ull, 0x06c45d188009454full, 0xf88bb8a8724c81ecull,
+    0x1b39896a51a8749bull, 0x53cb9f0c747ea2eaull, 0x2c829abe1f4532e1ull, 0xc584133ac916ab3cull,
+    0x3ee5789041c98ac3ull, 0xf3b8488c368cb0a6ull, 0x657eecdd3cb13d09ull, 0xc2d326e0055bdef6ull,
+    0x8621a03fe0bbdb7bull, 0x8e1f7555983aa92full, 0xb54e0f1600cc4d19ull, 0x84bb3f97971d80abull,
+    0x7d29825c75521255ull, 0xc3cf17102b7f7f86ull, 0x3466e9a083914f64ull, 0xd81a8d2b5a4485acull,
+    0xdb01602b100b9ed7ull, 0xa9038a921825f10dull, 0xedf5f1d90dca2f6aull, 0x54496ad67bd2634cull,
+    0xdd7c01d4f5407269ull, 0x935e82f1db4c4f7bull, 0x69b82ebc92233300ull, 0x40d29eb57de1d510ull,
+    0xa2f09dabb45c6316ull, 0xee521d7a0f4d3872ull, 0xf16952ee72f3454full, 0x377d35dea8e40225ull,
+    0x0c7de8064963bab0ull, 0x05582d37111ac529ull, 0xd254741f599dc6f7ull, 0x69630f7593d108c3ull,
+    0x417ef96181daa383ull, 0x3c3c41a3b43343a1ull, 0x6e19905dcbe531dfull, 0x4fa9fa7324851729ull,
+    0x84eb4454a792922aull, 0x134f7096918175ceull, 0x07dc930b302278a8ull, 0x12c015a97019e937ull,
+    0xcc06c31652ebf438ull, 0xecee65630a691e37ull, 0x3e84ecb1763e79adull, 0x690ed476743aae49ull,
+    0x774615d7b1a1f2e1ull, 0x22b353f04f4f52daull, 0xe3ddd86ba71a5eb1ull, 0xdf268adeb6513356ull,
+    0x2098eb73d4367d77ull, 0x03d6845323ce3c71ull, 0xc952c5620043c714ull, 0x9b196bca844f1705ull,
+    0x30260345dd9e0ec1ull, 0xcf448a5882bb9698ull, 0xf4a578dccbc87656ull, 0xbfdeaed9a17b3c8full,
+    0xed79402d1d5c5d7bull, 0x55f070ab1cbbf170ull, 0x3e00a34929a88f1dull, 0xe255b237b8bb18fbull,
+    0x2a7b67af6c6ad50eull, 0x466d5e7f3e46f143ull, 0x42375cb399a4fc72ull, 0x8c8a1f148a8bb259ull,
+    0x32fcab5daed5bdfcull, 0x9e60398c8d8553c0ull, 0xee89cceb8c4064c0ull, 0xdb0215941d86a66full,
+    0x5ccde78203c367a8ull, 0xf1bcbc6a1ec11786ull, 0xef054fceee954551ull, 0xdf82012d0555c6dfull,
+    0x292566ff72403c08ull, 0xc4dd302a1bfa1137ull, 0xd85f219db5c554e1ull, 0x6a27ff807441bcd2ull,
+    0x96a573e9b48216e8ull, 0x46a9fdac40bf0048ull, 0x3dd12464a0ee15b4ull, 0x451e521296a7eea1ull,
+    0x56e4398a98f8a0fdull, 0x7b7dc2160e3335a7ull, 0xc679ee0bebcb1ccaull, 0x928d6f2d7453424eull,
+    0x1b38994205234c6dull, 0x8086d193a6f2b568ull, 0x21c6e26639ac2c65ull, 0xd9dccac414d23c6full,
+    0x91cd642057e00235ull, 0x77fc607dc6589373ull, 0x05b8abe26dd3aee7ull, 0x12f6436ac376cc66ull,
+    0x64952424897b2307ull, 0xee8c2baf6343e5c3ull, 0xdc4c613d9eba2304ull, 0x3505b7796bd1a506ull,
+    0x8176daf800a05f50ull, 0x8bd8ff7a0385cdbcull, 0x1a764a3cd78101daull, 0xbe4d15bf6ca266acull,
+    0xa85e1f38bb2dc749ull, 0x56759a968493cd8cull, 0xf3a9bce7336bd182ull, 0x365b15013741519bull,
+    0x1f7a44a6b109ac94ull, 0x3521d628813cb177ull, 0x6a77afab0f7c9370ull, 0x179642d8cde95015ull,
+    0x5ef102a8fb354461ull, 0xf51c504764ed82f2ull, 0xc58427f041ce6808ull, 0xfad8fc45c9643c37ull,
+    0xcf8682f9a70fa9c0ull, 0x7e1b3b75a4005729ull, 0x992dd867927b52d8ull, 0x7fbd5db142f6791full,
+    0x370595aacab4adaeull, 0xb1392dbdc5ab61d6ull, 0x9fea7dfc79d452d9ull, 0x40b12b120085641cull,
+    0xa192afe3157c85d0ull, 0xc847729f4e08f3a3ull, 0x6f1384a306c41fc2ull, 0x12d05c4045a39c19ull,
+    0x9899202fd20f0841ull, 0xe9c7191857e774b8ull, 0x4eead809af5b0cc3ull, 0xe809acafa23864a4ull,
+    0x4da1edaba1d0f7bdull, 0x846eb9673349f8e4ull, 0x87bae55b86039fe8ull, 0x7f367b8bd953eff2ull,
+    0x3884700f650d04e1ull, 0xbfe4b2ab46980cadull, 0xc5fc89075299106cull, 0x37b2fa361adea7cdull,
+    0x7d75d813f04895b4ull, 0x702f5b393f62c0e0ull, 0x0a3fc775f4ecf37full, 0xe4b23787a352437full,
+    0xf83fa245c34d6363ull, 0xb99bcf040786cf50ull, 0x38b6ea0a0e6c9d8aull, 0x093fdc76776e37e1ull,
+    0x1a75e6f76ba7eee8ull, 0x442cdcfee9660c62ull, 0x22d58d35116b5e0bull, 0x87d4a5180f6a3645ull,
+    0x589fb216bd82131bull, 0x91d031cad319aec0ull, 0xabecf76a553d320bull, 0xb8686cb347612dcfull,
+    0xfcab66337c0a77f5ull, 0xac318214381ec437ull, 0x6eb7f0fca24494aeull, 0xcf42861dcdc895a9ull,
+    0x4abad7a1586d7a91ull, 0xc21b318dc2f49745ull, 0xd49474dc2acbd1f0ull, 0xb1d4873747c1c8e1ull,
+    0x5434dc8c7d015bf6ull, 0xe1c486287511b6a9ull, 0xa8616df62e89a193ull, 0x31ce6319498d8347ull,
+    0xafd0b486123d6faaull, 0xe6495f5d102301ebull, 0x0dc51ced17a43c52ull, 0x8bcbcde81355ef2dull,
+    0x2412af73fdee7cfcull, 0xc8d589e486e29eedull, 0x23390e8664517f89ull, 0x251ade58e8a6849dull,
+    0xf8555dbd2e8f9cb0ull, 0xcb417c3eef54f7c3ull, 0x8028f8e1aac3a919ull, 0x10e31052acf748a0ull,
+    0x2d886c073b1e1b78ull, 0x972974d90df9faeeull, 0xbc1b7b38796893baull, 0x1958ed432070e652ull,
+    0xca5f297197a12dccull, 0xe025a27375704f28ull, 0x418010a570a924fbull, 0x9828e2941bfc419cull,
+    0x4fbacd2f52b85c1full, 0x33dd5b756211cc67ull, 0x23c8dfdd1db57ff0ull, 0x32f81801a1a8e901ull,
+    0x26884eac5ada36daull, 0xcaa82f9bb42e37d4ull, 0x19fb1a7491d6a7d1ull, 0x5aa0243aa357f38eull,
+    0xb31d917809e447f0ull, 0x3f9c197225215be0ull, 0xdc3c315a1e33c095ull, 0x3dd399ad533e80acull,
+    0x566f32cce8301d95ull, 0xc880188083d9ba21ull, 0xb9cc357f3b0e7d2eull, 0x0237d2123a8a8d6cull,
+    0xbf636e9aa7cbf6bdull, 0xd7bd4284c4e2a6a7ull, 0xda2ebb47d50577a9ull, 0x90ba1c11b539087dull,
+    0x44993d31552b4f57ull, 0x32c2d6f80a8a8898ull, 0x450583ed7fb54b19ull, 0xec2b0b09e50ef3efull,
+    0xd918a0b6e2efd65cull, 0xe37a868d9785f572ull, 0x7d1a6118f2b0f37aull, 0x9e2e3cc13b343439ull,
+    0xefd82c11212e37e8ull, 0xaf89c05cd4fc75edull, 0x55bc16bb9697108eull, 0x6c4701fa5db69beeull,
+    0x9237338441daf445ull, 0x248cf0831e81a5fcull, 0xacc13557e77de273ull, 0x520970c25e06513aull,
+    0x657329cb02987cabull, 0xa9b0b3366a4e55a8ull, 0xc4d06ca2f39acdd4ull, 0x5dce37d68170cde1ull,
+    0x5f1e44e77e1854c9ull, 0x6883d452d55df899ull, 0x05c5bd62f1067032ull, 0xe680b683ce60fab0ull,
+    0x5dc9da3f286d18b1ull, 0x94b4bf3ab85ed6d8ull, 0xce65f449e3acc5a3ull, 0x34b0209642cea639ull,
+    0xc14c3c771d904827ull, 0x6addcee2bd9cdee5ull, 0xe24eed137ffbb613ull, 0x75dd58ef79963d1bull,
+    0xfdb83ecf6cc24920ull, 0x7a1d0057c57169fbull, 0x339200f4feb62d07ull, 0xd33f4d4ac88469f4ull,
+    0x8226f234e68dfee4ull, 0x320def4f2a105536ull, 0x7786f3b13aefc159ull, 0xb28225ac9df63ee2ull,
+    0x781b9d0376cc6044ull, 0x05bd0115226c6ab6ull, 0xd302230207bdfdabull, 0xdb898abd8e0d2933ull,
+    0x9e79a397ba00b9ccull, 0x89df84a5f0003ee8ull, 0x011f04f2a75fb9beull, 0x5a5832bb47bcf19eull
+};
+
+// Scans p[i..end) for a boundary, returning the chunk length or 0. The hash
+// advances two bytes per step, h = 4h + 2g[a] + g[b], so the dependency chain
+// through h is one shift and one add per two bytes; the hash after the first
+// byte is tested off that chain, which gives exactly the byte-wise result.
+static s32
+cdc_scan(const u8 * p, s32 * i, s32 end, u64 * hash, u64 mask)
+{
+    u64 h = *hash;
+    s32 j = *i;
+    for (; j + 2 <= end; j += 2) {
+        u64 ga = gear_table[p[j]];
+        u64 gb = gear_table[p[j+1]];
+        u64 mid = (h << 1) + ga;
+        h = (h << 2) + ((ga << 1) + gb);
+        if (!(mid & mask))
+            return j + 1;
+        if (!(h & mask))
+            return j + 2;
+    }
+    if (j < end) {
+        h = (h << 1) + gear_table[p[j]];
+        if (!(h & mask))
+            return j + 1;
+        j++;
+    }
+    *hash = h;
+    *i = j;
+    return 0;
+}
+
+// length of the chunk at the start of p. The first min bytes cannot hold a
+// boundary and are not hashed at all. Before avg the mask has one bit more
+// than log2(avg), making a boundary less likely; after it one bit fewer.
+// The masks select the high bits of the hash, which the shift has mixed
+// with the most recent bytes.
+static s32
+cdc_cut(const u8 * p, s32 n, s32 min, s32 avg, s32 max, u64 mask_s, u64 mask_l)
+{
+    if (n <= min)
+        return n;
+    if (n > max)
+        n = max;
+    u64 h = 0;
+    s32 i = min;
+    s32 len = cdc_scan(p, &i, MIN(avg, n), &h, mask_s);
+    if (len == 0)
+        len = cdc_scan(p, &i, n, &h, mask_l);
+    return len ? len : n;
+}
+
+s32
+string_cdc_chunks_hashed(String string, s32 min, s32 avg, s32 max, String * out, u64 * hashes)
+{
+    if (min <= 0 || min > avg || avg > max || avg < 4)
+        return -EINVAL;
+    s32 bits = 63 - clz64((u64) avg);
+    u64 mask_s = ~0ull << (64 - (bits + 1));
+    u64 mask_l = ~0ull << (64 - (bits - 1));
+    const u8 * p = (const u8 *) string.data;
+    s32 count = 0;
+    for (s32 pos = 0; pos < string.len; ) {
+        s32 len = cdc_cut(p + pos, string.len - pos, min, avg, max, mask_s, mask_l);
+        out[count] = (String) { .data = string.data + pos, .len = len };
+        if (hashes)
+            hashes[count] = string_hash(out[count]);
+        count++;
+        pos += len;
+    }
+    return count;
+}
+
+#define RK_BASE 0x100000001b3ull // odd, so multiplying by it is invertible mod 2^64
+
+// The polynomial hash is exact mod 2^64 but its low bits depend on few
+// bytes, so the table and filter are indexed by the mixed high bits.
+static u64
+rk_mix(u64 h)
+{
+    return (h ^ (h >> 29)) * HASH_K1;
+}
+
+static s32
+rk_probe(const RollingSearcher * searcher, u64 h, String window)
+{
+    u32 mask = (1u << searcher->bits) - 1;
+    u32 slot = (u32) (rk_mix(h) >> (64 - searcher->bits));
+    for (; searcher->ids[slot] >= 0; slot = (slot + 1) & mask) {
+        if (searcher->hashes[slot] == h && string_equal(searcher->needles[searcher->ids[slot]], window))
+            return searcher->ids[slot];
+    }
+    return -1;
+}
+
+// two bits set in one word of the filter
+static int
+rk_bloom_test(const RollingSearcher * searcher, u64 m)
+{
+    u64 word = searcher->bloom[m >> (64 - searcher->bloom_bits)];
+    u64 bits = (u64) 1 << (m & 63) | (u64) 1 << ((m >> 6) & 63);
+    return (word & bits) == bits;
+}
+
+RollingSearcher
+rolling_searcher_build_context(void * context, const String * needles, s32 count)
+{
+    RollingSearcher searcher = { .needles = needles, .count = count };
+    searcher.len = count > 0 ? needles[0].len : 1;
+    for (s32 i = 0; i < count; i++) {
+        if (needles[i].len != searcher.len)
+            searcher.error = -EINVAL;
+    }
+    if (searcher.len <= 0)
+        searcher.error = -EINVAL;
+    if (searcher.error)
+        return searcher;
+
+    searcher.pow = 1;
+    for (s32 i = 0; i < searcher.len; i++)
+        searcher.pow *= RK_BASE;
+
+    // at most half full; the filter has 16 bits per needle
+    searcher.bits = 4;
+    while ((1 << searcher.bits) < 2 * count)
+        searcher.bits++;
+    searcher.bloom_bits = MAX(searcher.bits - 3, 0);
+    s32 cap = 1 << searcher.bits;
+    searcher.hashes = PMK_MALLOC(context, cap * sizeof(u64));
+    searcher.ids = PMK_MALLOC(context, cap * sizeof(s32));
+    searcher.bloom = PMK_MALLOC(context, ((size_t) 1 << searcher.bloom_bits) * sizeof(u64));
+    memset(searcher.ids, 0xff, cap * sizeof(s32));
+    memset(searcher.bloom, 0, ((size_t) 1 << searcher.bloom_bits) * sizeof(u64));
+
+    for (s32 i = 0; i < count; i++) {
+        u64 h = 0;
+        for (s32 j = 0; j < searcher.len; j++)
+            h = h * RK_BASE + (u8) needles[i].data[j];
+        if (rk_probe(&searcher, h, needles[i]) >= 0)
+            continue; // duplicate
+        u32 slot = (u32) (rk_mix(h) >> (64 - searcher.bits));
+        while (searcher.ids[slot] >= 0)
+            slot = (slot + 1) & (cap - 1);
+        searcher.hashes[slot] = h;
+        searcher.ids[slot] = i;
+        u64 m = rk_mix(h);
+        searcher.bloom[m >> (64 - searcher.bloom_bits)] |= (u64) 1 << (m & 63) | (u64) 1 << ((m >> 6) & 63);
+    }
+    return searcher;
+}
+
+void
+rolling_searcher_destroy_context(void * context, RollingSearcher * searcher)
+{
+    PMK_FREE(context, searcher->hashes);
+    PMK_FREE(context, searcher->ids);
+    PMK_FREE(context, searcher->bloom);
+    *searcher = (RollingSearcher) {0};
+}
+
+s32
+rolling_searcher_find(const RollingSearcher * searcher, String haystack, s32 pos, s32 * needle)
+{
+    s32 len = searcher->len;
+    if (searcher->error || searcher->count == 0 || pos < 0 || haystack.len - pos < len)
+        return haystack.len;
+    const u8 * p = (const u8 *) haystack.data;
+    u64 h = 0;
+    for (s32 j = 0; j < len; j++)
+        h = h * RK_BASE + p[pos + j];
+    for (s32 i = pos; ; i++) {
+        if (rk_bloom_test(searcher, rk_mix(h))) {
+            s32 id = rk_probe(searcher, h, (String) { .data = haystack.data + i, .len = len });
+            if (id >= 0) {
+                if (needle)
+                    *needle = id;
+                return i;
+            }
+        }
+        if (i + len >= haystack.len)
+            break;
+        // only the multiply and one add depend on the previous h
+        h = h * RK_BASE + (p[i + len] - p[i] * searcher->pow);
+    }
+    return haystack.len;
+}
+
+#define LZ4_MIN_MATCH   4
+#define LZ4_LAST_LITS   5       // the last 5 bytes are always literals
+#define LZ4_MF_LIMIT    12      // and no match starts in the last 12
+#define LZ4_MAX_OFFSET  65535
+#define LZ4_HASH_BITS   16
+#define LZ4_CHAIN_DEPTH 16      // candidates examined per position
+
+static u32
+lz4_hash(const u8 * p)
+{
+    u32 x;
+    memcpy(&x, p, 4);
+    return (x * 2654435761u) >> (32 - LZ4_HASH_BITS);
+}
+
+static u8 *
+lz4_put_length(u8 * op, s32 len)
+{
+    for (; len >= 255; len -= 255)
+        *op++ = 255;
+    *op++ = (u8) len;
+    return op;
+}
+
+static u8 *
+lz4_put_sequence(u8 * op, const u8 * lits, s32 nlits, s32 offset, s32 match_len)
+{
+    u8 * token = op++;
+    *token = (u8) (MIN(nlits, 15) << 4);
+    if (nlits >= 15)
+        op = lz4_put_length(op, nlits - 15);
+    memcpy(op, lits, nlits);
+    op += nlits;
+    if (match_len == 0)
+        return op; // the last sequence has no match
+    *op++ = (u8) offset;
+    *op++ = (u8) (offset >> 8);
+    s32 ml = match_len - LZ4_MIN_MATCH;
+    *token |= (u8) MIN(ml, 15);
+    if (ml >= 15)
+        op = lz4_put_length(op, ml - 15);
+    return op;
+}
+
+// Greedy parse with a hash-chain match finder: head[] holds the latest
+// position for each hash of 4 bytes and prev[] links each position in the
+// 64 KiB window to the previous one with the same hash.
+void
+builder_compress_into_context(void * context, StringBuilder * builder, String src)
+{
+    const u8 * in = (const u8 *) src.data;
+    s32 n = src.len;
+    s64 bound = (s64) n + n / 255 + 16;
+    assert(builder->len + bound < INT32_MAX);
+    builder_grow(context, builder, (s32) bound);
+    u8 * op = (u8 *) builder->data + builder->len;
+
+    s32 anchor = 0;
+    if (n > LZ4_MF_LIMIT) {
+        s32 * head = PMK_MALLOC(context, (1 << LZ4_HASH_BITS) * sizeof(s32));
+        s32 * prev = PMK_MALLOC(context, (LZ4_MAX_OFFSET + 1) * sizeof(s32));
+        memset(head, 0xff, (1 << LZ4_HASH_BITS) * sizeof(s32));
+        s32 match_limit = n - LZ4_LAST_LITS;
+        s32 inserted = 0;
+        for (s32 ip = 0; ip <= n - LZ4_MF_LIMIT; ) {
+            for (; inserted <= ip; inserted++) {
+                u32 h = lz4_hash(in + inserted);
+                prev[inserted & LZ4_MAX_OFFSET] = head[h];
+                head[h] = inserted;
+            }
+            s32 best_len = 0, best_pos = 0;
+            s32 cand = prev[ip & LZ4_MAX_OFFSET];
+            for (s32 depth = 0; depth < LZ4_CHAIN_DEPTH && cand >= 0 && ip - cand <= LZ4_MAX_OFFSET; depth++) {
+                if (in[cand + best_len] == in[ip + best_len] && memcmp(in + cand, in + ip, 4) == 0) {
+                    s32 len = 4;
+                    while (ip + len + 8 <= match_limit && load_u64_le(in + cand + len) == load_u64_le(in + ip + len))
+                        len += 8;
+                    while (ip + len < match_limit && in[cand + len] == in[ip + len])
+                        len++;
+                    if (len > best_len) {
+                        best_len = len;
+                        best_pos = cand;
+                    }
+                }
+                s32 next = prev[cand & LZ4_MAX_OFFSET];
+                if (next >= cand)
+                    break; // overwritten slot from outside the window
+                cand = next;
+            }
+            if (best_len < LZ4_MIN_MATCH) {
+                ip++;
+                continue;
+            }
+            // extend the match backwards into the pending literals
+            while (ip > anchor && best_pos > 0 && in[ip - 1] == in[best_pos - 1]) {
+                ip--;
+                best_pos--;
+                best_len++;
+            }
+            op = lz4_put_sequence(op, in + anchor, ip - anchor, ip - best_pos, best_len);
+            ip += best_len;
+            anchor = ip;
+        }
+        PMK_FREE(context, head);
+        PMK_FREE(context, prev);
+    }
+    op = lz4_put_sequence(op, in + anchor, n - anchor, 0, 0);
+
+    builder->len = (s32) (op - (u8 *) builder->data);
+    builder->data[builder->len] = '\0';
+}
+
+int
+builder_decompress_into_context(void * context, StringBuilder * builder, String src, s32 expected_len)
+{
+    if (expected_len < 0 || src.len <= 0)
+        return -EINVAL;
+    builder_grow(context, builder, expected_len);
+    const u8 * ip = (const u8 *) src.data;
+    const u8 * iend = ip + src.len;
+    u8 * out = (u8 *) builder->data + builder->len;
+    u8 * op = out;
+    u8 * oend = out + expected_len;
+
+    for (;;) {
+        u32 token = *ip++;
+        size_t nlits = token >> 4;
+        if (nlits == 15) {
+            u32 b;
+            do {
+                if (ip == iend)
+                    return -EINVAL;
+                b = *ip++;
+                nlits += b;
+            } while (b == 255);
+        }
+        if ((size_t) (iend - ip) < nlits || (size_t) (oend - op) < nlits)
+            return -EINVAL;
+        memcpy(op, ip, nlits);
+        op += nlits;
+        ip += nlits;
+        if (ip == iend)
+            break; // the last sequence ends after its literals
+
+        if (iend - ip < 2)
+            return -EINVAL;
+        size_t offset = ip[0] | (size_t) ip[1] << 8;
+        ip += 2;
+        size_t len = token & 15;
+        if (len == 15) {
+            u32 b;
+            do {
+                if (ip == iend)
+                    return -EINVAL;
+                b = *ip++;
+                len += b;
+            } while (b == 255);
+        }
+        len += LZ4_MIN_MATCH;
+        if (offset == 0 || (size_t) (op - out) < offset || (size_t) (oend - op) < len)
+            return -EINVAL;
+
+        const u8 * m = op - offset;
+        if (offset >= len) {
+            memcpy(op, m, len);
+        } else if (offset >= 8) {
+            // overlapping, but each 8-byte step reads only bytes already written
+            size_t i = 0;
+            for (; i + 8 <= len; i += 8)
+                memcpy(op + i, m + i, 8);
+            for (; i < len; i++)
+                op[i] = m[i];
+        } else {
+            for (size_t i = 0; i < len; i++)
+                op[i] = m[i];
+        }
+        op += len;
+        if (ip == iend)
+            return -EINVAL; // a block ends with literals
+    }
+    if (op != oend)
+        return -EINVAL;
+
+    builder->len += expected_len;
+    builder->data[builder->len] = '\0';
+    return 0;
+}
+
+#define FSST_GENERATIONS 5
+
+static u64
+fsst_mask(s32 len)
+{
+    return len == 8 ? ~(u64) 0 : ((u64) 1 << (8 * len)) - 1;
+}
+
+static u32
+fsst_hash(u64 w)
+{
+    return (u32) (((w & 0xffffff) * 0x9e3779b1u) >> 15) & (FSST_HASH_SLOTS - 1);
+}
+
+// len << 8 | code of the longest symbol at p: the hashed symbol starting
+// with the same 3 bytes if it matches, else the one- or two-byte symbol
+static u32
+fsst_match(const FsstTable * table, const u8 * p, s32 avail)
+{
+    if (avail >= 3) {
+        u64 w;
+        if (avail >= 8) {
+            w = load_u64_le(p);
+        } else {
+            u8 tail[8] = {0};
+            memcpy(tail, p, avail);
+            w = load_u64_le(tail);
+        }
+        u32 h = fsst_hash(w);
+        s32 len = table->hash_lens[h];
+        if (len && len <= avail && (w & fsst_mask(len)) == table->hash_symbols[h])
+            return (u32) len << 8 | table->hash_codes[h];
+        return table->short_codes[w & 0xffff];
+    }
+    if (avail == 2)
+        return table->short_codes[p[0] | p[1] << 8];
+    return table->byte_codes[p[0]];
+}
+
+typedef struct {
+    u64 symbol;
+    u64 gain;
+    s32 len;
+} FsstCandidate;
+
+static int
+fsst_cmp_symbol(const void * a, const void * b)
+{
+    const FsstCandidate * x = a, * y = b;
+    if (x->len != y->len)
+        return x->len - y->len;
+    return (x->symbol > y->symbol) - (x->symbol < y->symbol);
+}
+
+static int
+fsst_cmp_gain(const void * a, const void * b)
+{
+    const FsstCandidate * x = a, * y = b;
+    if (x->gain != y->gain)
+        return (x->gain < y->gain) - (x->gain > y->gain);
+    return fsst_cmp_symbol(b, a);
+}
+
+// rebuilds the table from candidates in order of preference; a symbol of 3+
+// bytes whose hash slot is taken by a better one is dropped
+static void
+fsst_index(FsstTable * table, const FsstCandidate * cands, s32 count)
+{
+    table->nsymbols = 0;
+    memset(table->hash_lens, 0, sizeof(table->hash_lens));
+    for (s32 i = 0; i < count && table->nsymbols < 255; i++) {
+        u8 code = (u8) table->nsymbols;
+        if (cands[i].len >= 3) {
+            u32 h = fsst_hash(cands[i].symbol);
+            if (table->hash_lens[h])
+                continue;
+            table->hash_symbols[h] = cands[i].symbol;
+            table->hash_lens[h] = (u8) cands[i].len;
+            table->hash_codes[h] = code;
+        }
+        table->symbols[code] = cands[i].symbol;
+        table->lens[code] = (u8) cands[i].len;
+        table->nsymbols++;
+    }
+    for (s32 b = 0; b < 256; b++)
+        table->byte_codes[b] = 1 << 8 | FSST_ESCAPE;
+    for (s32 c = 0; c < table->nsymbols; c++) {
+        if (table->lens[c] == 1)
+            table->byte_codes[table->symbols[c]] = (u16) (1 << 8 | c);
+    }
+    for (s32 x = 0; x < 65536; x++)
+        table->short_codes[x] = table->byte_codes[x & 0xff];
+    for (s32 c = 0; c < table->nsymbols; c++) {
+        if (table->lens[c] == 2)
+            table->short_codes[table->symbols[c]] = (u16) (2 << 8 | c);
+    }
+}
+
+// Each generation compresses the sample with the current table, counting
+// how often each symbol and each pair of adjacent symbols is used (escaped
+// bytes count as pseudo-symbols 256..511), then keeps the 255 symbols and
+// concatenations of pairs that would save the most bytes.
+FsstTable *
+fsst_train_context(void * context, const String * sample, s32 count)
+{
+    FsstTable * table = PMK_MALLOC(context, sizeof(FsstTable));
+    table->short_codes = PMK_MALLOC(context, 65536 * sizeof(u16));
+    fsst_index(table, NULL, 0);
+
+    u32 * count1 = PMK_MALLOC(context, 512 * sizeof(u32));
+    u32 * count2 = PMK_MALLOC(context, 512 * 512 * sizeof(u32));
+    FsstCandidate * cands = PMK_MALLOC(context, (512 + 512 * 512) * sizeof(FsstCandidate));
+    for (s32 gen = 0; gen < FSST_GENERATIONS; gen++) {
+        memset(count1, 0, 512 * sizeof(u32));
+        memset(count2, 0, 512 * 512 * sizeof(u32));
+        for (s32 i = 0; i < count; i++) {
+            const u8 * p = (const u8 *) sample[i].data;
+            s32 prev = -1;
+            for (s32 pos = 0; pos < sample[i].len; ) {
+                u32 m = fsst_match(table, p + pos, sample[i].len - pos);
+                s32 code = (m & 0xff) == FSST_ESCAPE ? 256 + p[pos] : (s32) (m & 0xff);
+                count1[code]++;
+                if ((m >> 8) > 1)
+                    count1[256 + p[pos]]++; // the first byte alone stays a candidate
+                if (prev >= 0)
+                    count2[prev * 512 + code]++;
+                prev = code;
+                pos += m >> 8;
+            }
+        }
+
+        s32 n = 0;
+        for (s32 a = 0; a < 512; a++) {
+            if (!count1[a])
+                continue;
+            u64 sa = a < 256 ? table->symbols[a] : (u64) (a - 256);
+            s32 la = a < 256 ? table->lens[a] : 1;
+            cands[n++] = (FsstCandidate) { .symbol = sa, .len = la, .gain = (u64) count1[a] * la };
+            if (la == 8)
+                continue;
+            for (s32 b = 0; b < 512; b++) {
+                u32 c2 = count2[a * 512 + b];
+                if (!c2)
+                    continue;
+                u64 sb = b < 256 ? table->symbols[b] : (u64) (b - 256);
+                s32 lb = b < 256 ? table->lens[b] : 1;
+                s32 len = MIN(la + lb, 8);
+                u64 sym = (sa | sb << (8 * la)) & fsst_mask(len);
+                cands[n++] = (FsstCandidate) { .symbol = sym, .len = len, .gain = (u64) c2 * len };
+            }
+        }
+
+        // merge duplicate candidates, then rank them
+        qsort(cands, n, sizeof(FsstCandidate), fsst_cmp_symbol);
+        s32 merged = 0;
+        for (s32 i = 0; i < n; i++) {
+            if (merged && cands[merged-1].len == cands[i].len && cands[merged-1].symbol == cands[i].symbol)
+                cands[merged-1].gain += cands[i].gain;
+            else
+                cands[merged++] = cands[i];
+        }
+        qsort(cands, merged, sizeof(FsstCandidate), fsst_cmp_gain);
+        fsst_index(table, cands, merged);
+    }
+    PMK_FREE(context, count1);
+    PMK_FREE(context, count2);
+    PMK_FREE(context, cands);
+    return table;
+}
+
+void
+fsst_destroy_context(void * context, FsstTable * table)
+{
+    if (table == NULL)
+        return;
+    PMK_FREE(context, table->short_codes);
+    PMK_FREE(context, table);
+}
+
+void
+builder_append_fsst_context(void * context, StringBuilder * builder, const FsstTable * table, String string)
+{
+    assert(builder->len + 2 * (s64) string.len < INT32_MAX);
+    builder_grow(context, builder, 2 * string.len);
+    const u8 * p = (const u8 *) string.data;
+    u8 * op = (u8 *) builder->data + builder->len;
+    for (s32 pos = 0; pos < string.len; ) {
+        u32 m = fsst_match(table, p + pos, string.len - pos);
+        *op++ = (u8) m;
+        if ((m & 0xff) == FSST_ESCAPE)
+            *op++ = p[pos];
+        pos += m >> 8;
+    }
+    builder->len = (s32) (op - (u8 *) builder->data);
+    builder->data[builder->len] = '\0';
+}
+
+int
+builder_append_fsst_decoded_context(void * context, StringBuilder * builder, const FsstTable * table, String compressed)
+{
+    const u8 * ip = (const u8 *) compressed.data;
+    const u8 * iend = ip + compressed.len;
+    s64 total = 0;
+    for (const u8 * q = ip; q < iend; q++) {
+        if (*q == FSST_ESCAPE) {
+            if (++q == iend)
+                return -EINVAL;
+            total++;
+        } else if (*q < table->nsymbols) {
+            total += table->lens[*q];
+        } else {
+            return -EINVAL;
+        }
+    }
+    // slack for writing each symbol as a whole word
+    assert(builder->len + total + 7 < INT32_MAX);
+    builder_grow(context, builder, (s32) total + 7);
+    u8 * op = (u8 *) builder->data + builder->len;
+    while (ip < iend) {
+        u8 code = *ip++;
+        if (code == FSST_ESCAPE) {
+            *op++ = *ip++;
+        } else {
+            u64 w = table->symbols[code];
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+            for (s32 k = 0; k < 8; k++)
+                op[k] = (u8) (w >> (8 * k));
+#else
+            memcpy(op, &w, 8);
+#endif
+            op += table->lens[code];
+        }
+    }
+    builder->len += (s32) total;
+    builder->data[builder->len] = '\0';
+    return 0;
+}
+
+void
+fsst_compress_strings_context(void * context, const FsstTable * table, const String * strings, s32 count,
+                              StringBuilder * heap, s32 * offsets)
+{
+    s64 bound = 0;
+    for (s32 i = 0; i < count; i++)
+        bound += 2 * (s64) strings[i].len;
+    assert(heap->len + bound < INT32_MAX);
+    builder_grow(context, heap, (s32) bound);
+    for (s32 i = 0; i < count; i++) {
+        offsets[i] = heap->len;
+        builder_append_fsst_context(context, heap, table, strings[i]);
+    }
+    offsets[count] = heap->len;
+}
+
+// number of equal leading bytes, comparing a word at a time
+static s32
+common_prefix_len(const char * a, const char * b, s32 n)
+{
+    s32 i = 0;
+    for (; i + 8 <= n; i += 8) {
+        u64 x = load_u64_le(a + i) ^ load_u64_le(b + i);
+        if (x)
+            return i + ctz64(x) / 8;
+    }
+    while (i < n && a[i] == b[i])
+        i++;
+    return i;
+}
+
+// number of equal trailing bytes of a[0..n) and b[0..n)
+static s32
+common_suffix_len(const char * a, const char * b, s32 n)
+{
+    s32 i = 0;
+    for (; i + 8 <= n; i += 8) {
+        u64 x = load_u64_le(a + n - i - 8) ^ load_u64_le(b + n - i - 8);
+        if (x)
+            return i + clz64(x) / 8;
+    }
+    while (i < n && a[n - i - 1] == b[n - i - 1])
+        i++;
+    return i;
+}
+
+static String *
+diff_split_lines(void * context, String s, s32 * count)
+{
+    s32 n = string_count(s, '\n') + (s.len > 0 && s.data[s.len-1] != '\n');
+    String * lines = PMK_MALLOC(context, MAX(n, 1) * sizeof(String));
+    s32 start = 0;
+    for (s32 i = 0; i < n; i++) {
+        s32 end = start;
+        while (end < s.len && s.data[end] != '\n')
+            end++;
+        end = MIN(end + 1, s.len);
+        lines[i] = string_substr(s, start, end);
+        start = end;
+    }
+    *count = n;
+    return lines;
+}
+
+typedef struct {
+    const s32 * a;
+    const s32 * b;
+    u8 * a_changed;
+    u8 * b_changed;
+    s32 * v1;
+    s32 * v2;
+} DiffState;
+
+static void diff_recurse(DiffState * st, s32 a_lo, s32 a_hi, s32 b_lo, s32 b_hi);
+
+// Searches forward from the start and backward from the end at once, one
+// edit distance d at a time, until the two paths overlap; the overlap is a
+// point on an optimal path, which splits the problem in two. Only the
+// furthest-reaching x on each diagonal is kept, so space is O(N+M).
+static void
+diff_bisect(DiffState * st, s32 a_lo, s32 a_hi, s32 b_lo, s32 b_hi)
+{
+    const s32 * a = st->a + a_lo;
+    const s32 * b = st->b + b_lo;
+    s32 n = a_hi - a_lo, m = b_hi - b_lo;
+    s32 max_d = (n + m + 1) / 2;
+    s32 offset = max_d;
+    s32 v_len = 2 * max_d + 2;
+    s32 * v1 = st->v1;
+    s32 * v2 = st->v2;
+    for (s32 i = 0; i < v_len; i++)
+        v1[i] = v2[i] = -1;
+    v1[offset + 1] = v2[offset + 1] = 0;
+    s32 delta = n - m;
+    int front = delta & 1; // odd delta: the paths meet during a forward step
+    s32 k1_start = 0, k1_end = 0, k2_start = 0, k2_end = 0;
+
+    for (s32 d = 0; d < max_d; d++) {
+        for (s32 k1 = -d + k1_start; k1 <= d - k1_end; k1 += 2) {
+            s32 i1 = offset + k1;
+            s32 x1 = (k1 == -d || (k1 != d && v1[i1 - 1] < v1[i1 + 1])) ? v1[i1 + 1] : v1[i1 - 1] + 1;
+            s32 y1 = x1 - k1;
+            while (x1 < n && y1 < m && a[x1] == b[y1]) {
+                x1++;
+                y1++;
+            }
+            v1[i1] = x1;
+            if (x1 > n) {
+                k1_end += 2;   // off the right edge
+            } else if (y1 > m) {
+                k1_start += 2; // off the bottom edge
+            } else if (front) {
+                s32 i2 = offset + delta - k1;
+                if (i2 >= 0 && i2 < v_len && v2[i2] != -1 && x1 >= n - v2[i2]) {
+                    diff_recurse(st, a_lo, a_lo + x1, b_lo, b_lo + y1);
+                    diff_recurse(st, a_lo + x1, a_hi, b_lo + y1, b_hi);
+                    return;
+                }
+            }
+        }
+        for (s32 k2 = -d + k2_start; k2 <= d - k2_end; k2 += 2) {
+            s32 i2 = offset + k2;
+            s32 x2 = (k2 == -d || (k2 != d && v2[i2 - 1] < v2[i2 + 1])) ? v2[i2 + 1] : v2[i2 - 1] + 1;
+            s32 y2 = x2 - k2;
+            while (x2 < n && y2 < m && a[n - x2 - 1] == b[m - y2 - 1]) {
+                x2++;
+                y2++;
+            }
+            v2[i2] = x2;
+            if (x2 > n) {
+                k2_end += 2;
+            } else if (y2 > m) {
+                k2_start += 2;
+            } else if (!front) {
+                s32 i1 = offset + delta - k2;
+                if (i1 >= 0 && i1 < v_len && v1[i1] != -1) {
+                    s32 x1 = v1[i1];
+                    s32 y1 = offset + x1 - i1;
+                    if (x1 >= n - x2) {
+                        diff_recurse(st, a_lo, a_lo + x1, b_lo, b_lo + y1);
+                        diff_recurse(st, a_lo + x1, a_hi, b_lo + y1, b_hi);
+                        return;
+                    }
+                }
+            }
+        }
+    }
+    // nothing in common
+    memset(st->a_changed + a_lo, 1, n);
+    memset(st->b_changed + b_lo, 1, m);
+}
+
+static void
+diff_recurse(DiffState * st, s32 a_lo, s32 a_hi, s32 b_lo, s32 b_hi)
+{
+    while (a_lo < a_hi && b_lo < b_hi && st->a[a_lo] == st->b[b_lo]) {
+        a_lo++;
+        b_lo++;
+    }
+    while (a_lo < a_hi && b_lo < b_hi && st->a[a_hi - 1] == st->b[b_hi - 1]) {
+        a_hi--;
+        b_hi--;
+    }
+    if (a_lo == a_hi)
+        memset(st->b_changed + b_lo, 1, b_hi - b_lo);
+    else if (b_lo == b_hi)
+        memset(st->a_changed + a_lo, 1, a_hi - a_lo);
+    else
+        diff_bisect(st, a_lo, a_hi, b_lo, b_hi);
+}
+
+// The common prefix and suffix (whole lines only) are skipped by comparing
+// bytes a word at a time. The remaining lines are hashed once and interned,
+// so the diff itself compares s32 ids.
+int
+string_diff_lines_context(void * context, String a, String b, DiffCallback callback, void * user)
+{
+    s32 prefix = common_prefix_len(a.data, b.data, MIN(a.len, b.len));
+    if (prefix == a.len && prefix == b.len)
+        return 0;
+    while (prefix > 0 && a.data[prefix - 1] != '\n')
+        prefix--;
+    s32 rest = MIN(a.len, b.len) - prefix;
+    s32 suffix = common_suffix_len(a.data + a.len - rest, b.data + b.len - rest, rest);
+    // the suffix must start at a line start in both
+    while (suffix > 0 && ((a.len - suffix > 0 && a.data[a.len - suffix - 1] != '\n') ||
+                          (b.len - suffix > 0 && b.data[b.len - suffix - 1] != '\n')))
+        suffix--;
+    s32 skipped = string_count(string_substr(a, 0, prefix), '\n');
+
+    s32 na, nb;
+    String * la = diff_split_lines(context, string_substr(a, prefix, a.len - suffix), &na);
+    String * lb = diff_split_lines(context, string_substr(b, prefix, b.len - suffix), &nb);
+
+    s32 cap = 16;
+    while (cap < 2 * (na + nb))
+        cap *= 2;
+    u64 * hashes = PMK_MALLOC(context, cap * sizeof(u64));
+    String * reps = PMK_MALLOC(context, cap * sizeof(String));
+    s32 * slot_ids = PMK_MALLOC(context, cap * sizeof(s32));
+    memset(slot_ids, 0xff, cap * sizeof(s32));
+    s32 * ids = PMK_MALLOC(context, MAX(na + nb, 1) * sizeof(s32));
+    s32 nids = 0;
+    for (s32 i = 0; i < na + nb; i++) {
+        String line = i < na ? la[i] : lb[i - na];
+        u64 h = string_hash(line);
+        u32 slot = (u32) (h >> 32) & (cap - 1);
+        while (slot_ids[slot] >= 0 && !(hashes[slot] == h && string_equal(reps[slot], line)))
+            slot = (slot + 1) & (cap - 1);
+        if (slot_ids[slot] < 0) {
+            hashes[slot] = h;
+            reps[slot] = line;
+            slot_ids[slot] = nids++;
+        }
+        ids[i] = slot_ids[slot];
+    }
+
+    DiffState st = {
+        .a = ids,
+        .b = ids + na,
+        .a_changed = PMK_MALLOC(context, na + nb + 1),
+        .v1 = PMK_MALLOC(context, (na + nb + 3) * sizeof(s32)),
+        .v2 = PMK_MALLOC(context, (na + nb + 3) * sizeof(s32)),
+    };
+    st.b_changed = st.a_changed + na;
+    memset(st.a_changed, 0, na + nb + 1);
+    diff_recurse(&st, 0, na, 0, nb);
+
+    int result = 0;
+    for (s32 i = 0, j = 0; result == 0 && (i < na || j < nb); ) {
+        if (i < na && j < nb && !st.a_changed[i] && !st.b_changed[j]) {
+            i++;
+            j++;
+            continue;
+        }
+        DiffHunk hunk = { .a_start = skipped + i, .b_start = skipped + j };
+        for (; i < na && st.a_changed[i]; i++)
+            hunk.a_count++;
+        for (; j < nb && st.b_changed[j]; j++)
+            hunk.b_count++;
+        result = callback(user, hunk);
+    }
+
+    PMK_FREE(context, la);
+    PMK_FREE(context, lb);
+    PMK_FREE(context, hashes);
+    PMK_FREE(context, reps);
+    PMK_FREE(context, slot_ids);
+    PMK_FREE(context, ids);
+    PMK_FREE(context, st.a_changed);
+    PMK_FREE(context, st.v1);
+    PMK_FREE(context, st.v2);
+    return result;
+}
+
+typedef struct {
+    void * context;
+    DiffHunk * hunks;
+    s32 len;
+    s32 cap;
+} DiffHunks;
+
+static int
+diff_collect(void * user, DiffHunk hunk)
+{
+    DiffHunks * list = user;
+    if (list->len == list->cap) {
+        s32 new_cap = MAX(2 * list->cap, 16);
+        list->hunks = PMK_REALLOC(list->context, list->hunks, list->cap * sizeof(DiffHunk), new_cap * sizeof(DiffHunk));
+        list->cap = new_cap;
+    }
+    list->hunks[list->len++] = hunk;
+    return 0;
+}
+
+static void
+builder_append_diff_range(void * context, StringBuilder * builder, s32 start, s32 count)
+{
+    // a range of no lines is named by the line before it
+    builder_append_int_context(context, builder, count == 0 ? start : start + 1);
+    if (count != 1) {
+        builder_append_context(context, builder, str_lit(","));
+        builder_append_int_context(context, builder, count);
+    }
+}
+
+static void
+builder_append_diff_line(void * context, StringBuilder * builder, char mark, String line)
+{
+    builder_append_context(context, builder, (String) { .data = &mark, .len = 1 });
+    builder_append_context(context, builder, line);
+    if (line.len == 0 || line.data[line.len - 1] != '\n')
+        builder_append_context(context, builder, str_lit("\n\\ No newline at end of file\n"));
+}
+
+void
+builder_append_unified_diff_context(void * context, StringBuilder * builder, String a, String b, s32 context_lines)
+{
+    DiffHunks list = { .context = context };
+    string_diff_lines_context(context, a, b, diff_collect, &list);
+    if (list.len == 0)
+        return;
+    s32 na, nb;
+    String * la = diff_split_lines(context, a, &na);
+    String * lb = diff_split_lines(context, b, &nb);
+
+    for (s32 first = 0; first < list.len; ) {
+        // changes separated by at most 2 * context_lines share a hunk
+        s32 last = first;
+        while (last + 1 < list.len &&
+               list.hunks[last + 1].a_start - (list.hunks[last].a_start + list.hunks[last].a_count) <= 2 * context_lines)
+            last++;
+        DiffHunk f = list.hunks[first], l = list.hunks[last];
+        s32 lead = MIN(context_lines, f.a_start);
+        s32 a_start = f.a_start - lead;
+        s32 b_start = f.b_start - lead;
+        s32 a_end = MIN(l.a_start + l.a_count + context_lines, na);
+        s32 b_end = l.b_start + l.b_count + (a_end - (l.a_start + l.a_count));
+
+        builder_append_context(context, builder, str_lit("@@ -"));
+        builder_append_diff_range(context, builder, a_start, a_end - a_start);
+        builder_append_context(context, builder, str_lit(" +"));
+        builder_append_diff_range(context, builder, b_start, b_end - b_start);
+        builder_append_context(context, builder, str_lit(" @@\n"));
+
+        s32 i = a_start;
+        for (s32 h = first; h <= last; h++) {
+            DiffHunk d = list.hunks[h];
+            for (; i < d.a_start; i++)
+                builder_append_diff_line(context, builder, ' ', la[i]);
+            for (; i < d.a_start + d.a_count; i++)
+                builder_append_diff_line(context, builder, '-', la[i]);
+            for (s32 j = d.b_start; j < d.b_start + d.b_count; j++)
+                builder_append_diff_line(context, builder, '+', lb[j]);
+        }
+        for (; i < a_end; i++)
+            builder_append_diff_line(context, builder, ' ', la[i]);
+        first = last + 1;
+    }
+
+    PMK_FREE(context, la);
+    PMK_FREE(context, lb);
+    PMK_FREE(context, list.hunks);
+}
+
+#ifdef PMK_STRING_PTHREADS
+#include <pthread.h>
+#endif
+
+// a sorted sequence of lines: a slice of an in-memory run, or a spill file
+typedef struct {
+    FILE * fp;
+    StringBuilder line;
+    const String * next;
+    const String * end;
+    String current;
+    int done;
+} MergeSource;
+
+static int
+merge_source_advance(void * context, MergeSource * src)
+{
+    if (src->fp == NULL) {
+        src->done = src->next == src->end;
+        if (!src->done)
+            src->current = *src->next++;
+        return 0;
+    }
+    src->line.len = 0;
+    int err = builder_getline_context(context, &src->line, src->fp);
+    if (err)
+        return err;
+    src->done = src->line.len == 0 && feof(src->fp);
+    src->current = builder_to_string(src->line);
+    return 0;
+}
+
+// exhausted sources compare greater than everything
+static int
+merge_less(const MergeSource * sources, s32 i, s32 j)
+{
+    if (sources[i].done || sources[j].done)
+        return !sources[i].done || (sources[j].done && i < j);
+    int cmp = string_compare(sources[i].current, sources[j].current);
+    return cmp < 0 || (cmp == 0 && i < j);
+}
+
+// Fills the internal nodes 1..k-1 of the loser tree under node, whose
+// leaves k..2k-1 are the sources, and returns the winner
+static s32
+loser_tree_build(const MergeSource * sources, s32 * tree, s32 k, s32 node)
+{
+    if (node >= k)
+        return node - k;
+    s32 l = loser_tree_build(sources, tree, k, 2 * node);
+    s32 r = loser_tree_build(sources, tree, k, 2 * node + 1);
+    int l_wins = merge_less(sources, l, r);
+    tree[node] = l_wins ? r : l;
+    return l_wins ? l : r;
+}
+
+// Merges the sources into out. After the winner is consumed only the path
+// from its leaf to the root is replayed: log2(k) comparisons per line.
+static int
+merge_sources(void * context, MergeSource * sources, s32 k, FILE * out, int unique)
+{
+    int err = 0;
+    for (s32 i = 0; i < k && !err; i++)
+        err = merge_source_advance(context, &sources[i]);
+    s32 * tree = PMK_MALLOC(context, MAX(k, 1) * sizeof(s32));
+    s32 winner = k > 1 ? loser_tree_build(sources, tree, k, 1) : 0;
+    StringBuilder last = {0};
+    int have_last = 0;
+
+    while (!err && k > 0 && !sources[winner].done) {
+        String line = sources[winner].current;
+        if (!unique || !have_last || !string_equal(line, builder_to_string(last))) {
+            if (fwrite(line.data, 1, line.len, out) != (size_t) line.len || putc('\n', out) == EOF) {
+                err = -errno;
+                break;
+            }
+            if (unique) {
+                last.len = 0;
+                builder_append_context(context, &last, line);
+                have_last = 1;
+            }
+        }
+        err = merge_source_advance(context, &sources[winner]);
+        for (s32 node = (winner + k) / 2; node > 0; node /= 2) {
+            if (merge_less(sources, tree[node], winner)) {
+                s32 t = tree[node];
+                tree[node] = winner;
+                winner = t;
+            }
+        }
+    }
+    PMK_FREE(context, tree);
+    builder_destroy_context(context, &last);
+    return err;
+}
+
+typedef struct {
+    String * lines;
+    s32 count;
+} SortSlice;
+
+static void *
+sort_slice(void * arg)
+{
+    SortSlice * slice = arg;
+    qsort(slice->lines, slice->count, sizeof(String), string_compare_qsort);
+    return NULL;
+}
+
+// sorts a run of lines (in slices on several threads) and merges the
+// slices into out
+static int
+sort_run(void * context, String * lines, s32 count, s32 threads, FILE * out, int unique)
+{
+    s32 nslices = MAX(1, MIN(threads, count / 1024));
+    SortSlice * slices = PMK_MALLOC(context, nslices * sizeof(SortSlice));
+    MergeSource * sources = PMK_MALLOC(context, nslices * sizeof(MergeSource));
+    for (s32 i = 0; i < nslices; i++) {
+        s32 lo = (s32) ((s64) count * i / nslices);
+        s32 hi = (s32) ((s64) count * (i + 1) / nslices);
+        slices[i] = (SortSlice) { .lines = lines + lo, .count = hi - lo };
+        sources[i] = (MergeSource) { .next = lines + lo, .end = lines + hi };
+    }
+#ifdef PMK_STRING_PTHREADS
+    pthread_t * tids = PMK_MALLOC(context, nslices * sizeof(pthread_t));
+    s32 started = 0;
+    for (s32 i = 1; i < nslices; i++, started++) {
+        if (pthread_create(&tids[i], NULL, sort_slice, &slices[i]) != 0)
+            break;
+    }
+    sort_slice(&slices[0]);
+    for (s32 i = 1; i <= started; i++)
+        pthread_join(tids[i], NULL);
+    for (s32 i = started + 1; i < nslices; i++)
+        sort_slice(&slices[i]); // thread creation failed
+    PMK_FREE(context, tids);
+#else
+    for (s32 i = 0; i < nslices; i++)
+        sort_slice(&slices[i]);
+#endif
+    int err = merge_sources(context, sources, nslices, out, unique);
+    PMK_FREE(context, slices);
+    PMK_FREE(context, sources);
+    return err;
+}
+
+// merges runs[0..count) into out, closing (and so deleting) them
+static int
+merge_runs(void * context, FILE ** runs, s32 count, FILE * out, int unique)
+{
+    MergeSource * sources = PMK_MALLOC(context, count * sizeof(MergeSource));
+    for (s32 i = 0; i < count; i++) {
+        rewind(runs[i]);
+        sources[i] = (MergeSource) { .fp = runs[i] };
+    }
+    int err = merge_sources(context, sources, count, out, unique);
+    for (s32 i = 0; i < count; i++) {
+        builder_destroy_context(context, &sources[i].line);
+        fclose(runs[i]);
+    }
+    PMK_FREE(context, sources);
+    return err;
+}
+
+// spilled runs, oldest first; a run of level l holds EXTERNAL_SORT_FAN_IN^l
+// runs' worth of input, and levels never increase from one run to the next
+typedef struct {
+    FILE ** files;
+    s32 * levels;
+    s32 count;
+    s32 cap;
+} SpillRuns;
+
+// adds a run of level 0, then merges the newest EXTERNAL_SORT_FAN_IN runs
+// into one of the next level whenever they share a level, so that at most
+// EXTERNAL_SORT_FAN_IN - 1 runs per level are open at any time
+static int
+spill_runs_push(void * context, SpillRuns * sr, FILE * run, int unique)
+{
+    if (sr->count == sr->cap) {
+        s32 new_cap = MAX(2 * sr->cap, 16);
+        sr->files = PMK_REALLOC(context, sr->files, sr->cap * sizeof(FILE *), new_cap * sizeof(FILE *));
+        sr->levels = PMK_REALLOC(context, sr->levels, sr->cap * sizeof(s32), new_cap * sizeof(s32));
+        sr->cap = new_cap;
+    }
+    sr->files[sr->count] = run;
+    sr->levels[sr->count++] = 0;
+    while (sr->count >= EXTERNAL_SORT_FAN_IN &&
+           sr->levels[sr->count - EXTERNAL_SORT_FAN_IN] == sr->levels[sr->count - 1]) {
+        s32 first = sr->count - EXTERNAL_SORT_FAN_IN;
+        FILE * merged = tmpfile();
+        if (merged == NULL)
+            return -errno;
+        int err = merge_runs(context, sr->files + first, EXTERNAL_SORT_FAN_IN, merged, unique);
+        sr->count = first + 1;
+        sr->files[first] = merged;
+        sr->levels[first]++;
+        if (err)
+            return err;
+    }
+    return 0;
+}
+
+int
+external_sort_lines_context(void * context, const char * in_path, const char * out_path,
+                            s64 mem_budget, s32 threads, int flags)
+{
+    int unique = (flags & EXTERNAL_SORT_UNIQUE) != 0;
+    FILE * in = fopen(in_path, "r");
+    if (in == NULL)
+        return -errno;
+
+    // a run is limited by the budget and by what s32 offsets can address
+    s64 run_budget = MIN(mem_budget, INT32_MAX / 2);
+    StringBuilder heap = {0}, line = {0};
+    s32 * starts = NULL;
+    s32 nlines = 0, lines_cap = 0;
+    SpillRuns runs = {0};
+    FILE * out = NULL;
+    int err = 0;
+
+    for (int eof = 0; !eof && !err; ) {
+        // read a run: line bytes go into heap, starts[i] is where line i begins
+        heap.len = 0;
+        nlines = 0;
+        while (nlines == 0 || heap.len + (s64) nlines * (s64) (sizeof(s32) + sizeof(String)) < run_budget) {
+            line.len = 0;
+            if ((err = builder_getline_context(context, &line, in)) != 0)
+                break;
+            if (line.len == 0 && feof(in)) {
+                eof = 1;
+                break;
+            }
+            if (nlines + 1 >= lines_cap) {
+                s32 new_cap = MAX(2 * lines_cap, 1024);
+                starts = PMK_REALLOC(context, starts, lines_cap * sizeof(s32), new_cap * sizeof(s32));
+                lines_cap = new_cap;
+            }
+            starts[nlines++] = heap.len;
+            builder_append_context(context, &heap, builder_to_string(line));
+            if (feof(in)) {
+                eof = 1;
+                break;
+            }
+        }
+        if (err)
+            break;
+        if (nlines > 0)
+            starts[nlines] = heap.len;
+
+        // the whole input fits in one run: no spill file
+        FILE * dst;
+        int spill = !(eof && runs.count == 0);
+        if (!spill) {
+            if ((out = fopen(out_path, "w")) == NULL) {
+                err = -errno;
+                break;
+            }
+            dst = out;
+        } else if ((dst = tmpfile()) == NULL) {
+            err = -errno;
+            break;
+        }
+        String * lines = PMK_MALLOC(context, MAX(nlines, 1) * sizeof(String));
+        for (s32 i = 0; i < nlines; i++)
+            lines[i] = (String) { .data = heap.data + starts[i], .len = starts[i+1] - starts[i] };
+        err = sort_run(context, lines, nlines, threads, dst, unique);
+        PMK_FREE(context, lines);
+        if (spill) {
+            if (err)
+                fclose(dst);
+            else
+                err = spill_runs_push(context, &runs, dst, unique);
+        }
+    }
+    fclose(in);
+    builder_destroy_context(context, &heap);
+    builder_destroy_context(context, &line);
+    PMK_FREE(context, starts);
+
+    // the runs left over from each level may still exceed one loser tree:
+    // merge the newest ones, smallest first, until they fit
+    while (!err && runs.count > EXTERNAL_SORT_FAN_IN) {
+        FILE * merged = tmpfile();
+        if (merged == NULL) {
+            err = -errno;
+            break;
+        }
+        s32 first = runs.count - EXTERNAL_SORT_FAN_IN;
+        err = merge_runs(context, runs.files + first, EXTERNAL_SORT_FAN_IN, merged, unique);
+        runs.files[first] = merged;
+        runs.count = first + 1;
+    }
+    if (!err && runs.count > 0) {
+        if ((out = fopen(out_path, "w")) == NULL) {
+            err = -errno;
+        } else {
+            err = merge_runs(context, runs.files, runs.count, out, unique);
+            runs.count = 0; // closed by merge_runs()
+        }
+    }
+    for (s32 i = 0; i < runs.count; i++)
+        fclose(runs.files[i]);
+    PMK_FREE(context, runs.files);
+    PMK_FREE(context, runs.levels);
+    if (out && fclose(out) != 0 && !err)
+        err = -errno;
+    return err;
+}
+
+// index of the first of strings[lo..n) that is not less than key, probing
+// lo, lo+1, lo+3, lo+7, ... before a binary search of the last step: O(log d)
+// comparisons for an answer d places away
+static s32
+gallop(const String * strings, s32 lo, s32 n, String key)
+{
+    s32 step = 1, hi = lo;
+    while (hi < n) {
+        if (string_compare(strings[hi], key) >= 0)
+            break;
+        lo = hi + 1;
+        hi = (step < n - lo) ? lo + step - 1 : n;
+        step *= 2;
+    }
+    hi = MIN(hi, n);
+    while (lo < hi) {
+        s32 mid = lo + (hi - lo) / 2;
+        if (string_compare(strings[mid], key) < 0)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+s32
+string_set_intersect(const String * a, s32 na, const String * b, s32 nb, String * out)
+{
+    if (na > nb)
+        return string_set_intersect(b, nb, a, na, out);
+    s32 n = 0;
+    for (s32 i = 0, j = 0; i < na && j < nb; i++) {
+        j = gallop(b, j, nb, a[i]);
+        if (j < nb && string_equal(a[i], b[j]))
+            out[n++] = b[j++];
+    }
+    return n;
+}
+
+s32
+string_set_union(const String * a, s32 na, const String * b, s32 nb, String * out)
+{
+    s32 n = 0, i = 0, j = 0;
+    while (i < na && j < nb) {
+        int cmp = string_compare(a[i], b[j]);
+        if (cmp == 0) {
+            out[n++] = a[i++];
+            j++;
+        } else if (cmp < 0) {
+            s32 k = gallop(a, i, na, b[j]);
+            memcpy(out + n, a + i, (k - i) * sizeof(String));
+            n += k - i;
+            i = k;
+        } else {
+            s32 k = gallop(b, j, nb, a[i]);
+            memcpy(out + n, b + j, (k - j) * sizeof(String));
+            n += k - j;
+            j = k;
+        }
+    }
+    memcpy(out + n, a + i, (na - i) * sizeof(String));
+    n += na - i;
+    memcpy(out + n, b + j, (nb - j) * sizeof(String));
+    n += nb - j;
+    return n;
+}
+
+s32
+string_set_difference(const String * a, s32 na, const String * b, s32 nb, String * out)
+{
+    s32 n = 0, i = 0, j = 0;
+    while (i < na && j < nb) {
+        int cmp = string_compare(a[i], b[j]);
+        if (cmp == 0) {
+            i++;
+            j++;
+        } else if (cmp < 0) {
+            s32 k = gallop(a, i, na, b[j]);
+            memcpy(out + n, a + i, (k - i) * sizeof(String));
+            n += k - i;
+            i = k;
+        } else {
+            j = gallop(b, j, nb, a[i]);
+        }
+    }
+    memcpy(out + n, a + i, (na - i) * sizeof(String));
+    return n + na - i;
+}
+
+s32
+string_unique(String * strings, s32 count)
+{
+    s32 n = 0;
+    for (s32 i = 0; i < count; i++) {
+        if (n == 0 || !string_equal(strings[i], strings[n-1]))
+            strings[n++] = strings[i];
+    }
+    return n;
+}
+
+CountMinSketch
+cms_create_context(void * context, s32 width, s32 depth)
+{
+    CountMinSketch cms = { .width = 1, .depth = MAX(depth, 1) };
+    while (cms.width < width)
+        cms.width *= 2;
+    size_t size = (size_t) cms.width * cms.depth * sizeof(u32);
+    cms.counts = PMK_MALLOC(context, size);
+    memset(cms.counts, 0, size);
+    return cms;
+}
+
+void
+cms_destroy_context(void * context, CountMinSketch * cms)
+{
+    PMK_FREE(context, cms->counts);
+    *cms = (CountMinSketch) {0};
+}
+
+// the rows use the independent-enough positions h1 + i * h2 (Kirsch and
+// Mitzenmacher), all taken from one 64-bit hash
+static u32
+cms_column(const CountMinSketch * cms, u64 hash, s32 row)
+{
+    u32 h1 = (u32) hash, h2 = (u32) (hash >> 32) | 1;
+    return (h1 + (u32) row * h2) & (u32) (cms->width - 1);
+}
+
+void
+cms_add_hash(CountMinSketch * cms, u64 hash, u32 count)
+{
+    for (s32 i = 0; i < cms->depth; i++) {
+        u32 * c = &cms->counts[(size_t) i * cms->width + cms_column(cms, hash, i)];
+        *c = (*c > UINT32_MAX - count) ? UINT32_MAX : *c + count;
+    }
+    cms->total += count;
+}
+
+u32
+cms_estimate_hash(const CountMinSketch * cms, u64 hash)
+{
+    u32 estimate = UINT32_MAX;
+    for (s32 i = 0; i < cms->depth; i++)
+        estimate = MIN(estimate, cms->counts[(size_t) i * cms->width + cms_column(cms, hash, i)]);
+    return estimate;
+}
+
+int
+cms_merge(CountMinSketch * dst, const CountMinSketch * src)
+{
+    if (dst->width != src->width || dst->depth != src->depth)
+        return -EINVAL;
+    for (size_t i = 0; i < (size_t) dst->width * dst->depth; i++) {
+        u32 a = dst->counts[i], b = src->counts[i];
+        dst->counts[i] = (a > UINT32_MAX - b) ? UINT32_MAX : a + b;
+    }
+    dst->total += src->total;
+    return 0;
+}
+
+SpaceSaving
+space_saving_create_context(void * context, s32 k)
+{
+    SpaceSaving ss = { .context = context, .k = MAX(k, 1), .table_bits = 1 };
+    while ((1 << ss.table_bits) < 2 * ss.k)
+        ss.table_bits++;
+    ss.keys = PMK_MALLOC(context, ss.k * sizeof(StringBuilder));
+    ss.hashes = PMK_MALLOC(context, ss.k * sizeof(u64));
+    ss.counts = PMK_MALLOC(context, ss.k * sizeof(u64));
+    ss.errors = PMK_MALLOC(context, ss.k * sizeof(u64));
+    ss.heap = PMK_MALLOC(context, ss.k * sizeof(s32));
+    ss.heap_pos = PMK_MALLOC(context, ss.k * sizeof(s32));
+    ss.table = PMK_MALLOC(context, ((size_t) 1 << ss.table_bits) * sizeof(s32));
+    memset(ss.keys, 0, ss.k * sizeof(StringBuilder));
+    memset(ss.table, 0xff, ((size_t) 1 << ss.table_bits) * sizeof(s32));
+    return ss;
+}
+
+void
+space_saving_destroy_context(void * context, SpaceSaving * ss)
+{
+    for (s32 i = 0; i < ss->k; i++)
+        builder_destroy_context(context, &ss->keys[i]);
+    PMK_FREE(context, ss->keys);
+    PMK_FREE(context, ss->hashes);
+    PMK_FREE(context, ss->counts);
+    PMK_FREE(context, ss->errors);
+    PMK_FREE(context, ss->heap);
+    PMK_FREE(context, ss->heap_pos);
+    PMK_FREE(context, ss->table);
+    *ss = (SpaceSaving) {0};
+}
+
+static u32
+ss_home(const SpaceSaving * ss, u64 hash)
+{
+    return (u32) (hash >> (64 - ss->table_bits));
+}
+
+// table index holding the slot for key, or of the empty entry ending its probe
+static u32
+ss_lookup(const SpaceSaving * ss, String key, u64 hash)
+{
+    u32 mask = (1u << ss->table_bits) - 1;
+    u32 i = ss_home(ss, hash);
+    for (; ss->table[i] >= 0; i = (i + 1) & mask) {
+        s32 slot = ss->table[i];
+        if (ss->hashes[slot] == hash && string_equal(builder_to_string(ss->keys[slot]), key))
+            break;
+    }
+    return i;
+}
+
+// linear probing deletion: later entries of the cluster whose home is not
+// after the hole move back into it
+static void
+ss_table_remove(SpaceSaving * ss, u32 i)
+{
+    u32 mask = (1u << ss->table_bits) - 1;
+    for (u32 j = (i + 1) & mask; ss->table[j] >= 0; j = (j + 1) & mask) {
+        u32 home = ss_home(ss, ss->hashes[ss->table[j]]);
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            ss->table[i] = ss->table[j];
+            i = j;
+        }
+    }
+    ss->table[i] = -1;
+}
+
+static void
+ss_heap_swap(SpaceSaving * ss, s32 a, s32 b)
+{
+    s32 t = ss->heap[a];
+    ss->heap[a] = ss->heap[b];
+    ss->heap[b] = t;
+    ss->heap_pos[ss->heap[a]] = a;
+    ss->heap_pos[ss->heap[b]] = b;
+}
+
+static void
+ss_sift_down(SpaceSaving * ss, s32 i)
+{
+    for (;;) {
+        s32 least = i, l = 2 * i + 1, r = 2 * i + 2;
+        if (l < ss->len && ss->counts[ss->heap[l]] < ss->counts[ss->heap[least]])
+            least = l;
+        if (r < ss->len && ss->counts[ss->heap[r]] < ss->counts[ss->heap[least]])
+            least = r;
+        if (least == i)
+            return;
+        ss_heap_swap(ss, i, least);
+        i = least;
+    }
+}
+
+static void
+ss_sift_up(SpaceSaving * ss, s32 i)
+{
+    while (i > 0 && ss->counts[ss->heap[(i - 1) / 2]] > ss->counts[ss->heap[i]]) {
+        ss_heap_swap(ss, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+}
+
+static void
+ss_add(SpaceSaving * ss, String key, u64 hash, u64 count, u64 error)
+{
+    u32 i = ss_lookup(ss, key, hash);
+    s32 slot = ss->table[i];
+    if (slot >= 0) {
+        ss->counts[slot] += count;
+        ss->errors[slot] += error;
+        ss_sift_down(ss, ss->heap_pos[slot]);
+        return;
+    }
+    if (ss->len < ss->k) {
+        slot = ss->len++;
+        ss->heap[slot] = slot;
+        ss->heap_pos[slot] = slot;
+        ss->counts[slot] = 0;
+        ss->errors[slot] = error;
+    } else {
+        // replace the least counted value, which it may have been all along
+        slot = ss->heap[0];
+        ss_table_remove(ss, ss_lookup(ss, builder_to_string(ss->keys[slot]), ss->hashes[slot]));
+        i = ss_lookup(ss, key, hash);
+        ss->errors[slot] = ss->counts[slot] + error;
+    }
+    ss->keys[slot].len = 0;
+    builder_append_context(ss->context, &ss->keys[slot], key);
+    ss->hashes[slot] = hash;
+    ss->counts[slot] += count;
+    ss->table[i] = slot;
+    ss_sift_up(ss, ss->heap_pos[slot]);
+    ss_sift_down(ss, ss->heap_pos[slot]);
+}
+
+void
+space_saving_add_hash(SpaceSaving * ss, String key, u64 hash, u64 count)
+{
+    ss_add(ss, key, hash, count, 0);
+}
+
+static int
+heavy_hitter_cmp(const void * a, const void * b)
+{
+    const HeavyHitter * x = a, * y = b;
+    if (x->count != y->count)
+        return (x->count < y->count) - (x->count > y->count);
+    return string_compare(x->key, y->key);
+}
+
+s32
+space_saving_top(const SpaceSaving * ss, HeavyHitter * out, s32 n)
+{
+    if (n >= ss->len) {
+        for (s32 i = 0; i < ss->len; i++)
+            out[i] = (HeavyHitter) { builder_to_string(ss->keys[i]), ss->counts[i], ss->errors[i] };
+        qsort(out, ss->len, sizeof(HeavyHitter), heavy_hitter_cmp);
+        return ss->len;
+    }
+    HeavyHitter * all = PMK_MALLOC(ss->context, ss->len * sizeof(HeavyHitter));
+    s32 count = space_saving_top(ss, all, ss->len);
+    memcpy(out, all, n * sizeof(HeavyHitter));
+    PMK_FREE(ss->context, all);
+    return MIN(n, count);
+}
+
+// A value missing from one summary may have been counted up to that
+// summary's minimum there, so it is credited with the minimum as both count
+// and error (Agarwal et al., Mergeable Summaries).
+int
+space_saving_merge(SpaceSaving * dst, const SpaceSaving * src)
+{
+    if (dst->k != src->k)
+        return -EINVAL;
+    u64 dst_min = dst->len == dst->k ? dst->counts[dst->heap[0]] : 0;
+    u64 src_min = src->len == src->k ? src->counts[src->heap[0]] : 0;
+    SpaceSaving merged = space_saving_create_context(dst->context, dst->k);
+    HeavyHitter * all = PMK_MALLOC(dst->context, (dst->len + src->len) * sizeof(HeavyHitter));
+    u64 * hashes = PMK_MALLOC(dst->context, (dst->len + src->len) * sizeof(u64));
+    s32 n = 0;
+    for (s32 i = 0; i < dst->len; i++) {
+        String key = builder_to_string(dst->keys[i]);
+        s32 j = src->table[ss_lookup(src, key, dst->hashes[i])];
+        all[n] = (HeavyHitter) { key, dst->counts[i], dst->errors[i] };
+        all[n].count += j >= 0 ? src->counts[j] : src_min;
+        all[n].error += j >= 0 ? src->errors[j] : src_min;
+        hashes[n++] = dst->hashes[i];
+    }
+    for (s32 j = 0; j < src->len; j++) {
+        String key = builder_to_string(src->keys[j]);
+        if (dst->table[ss_lookup(dst, key, src->hashes[j])] >= 0)
+            continue;
+        all[n] = (HeavyHitter) { key, src->counts[j] + dst_min, src->errors[j] + dst_min };
+        hashes[n++] = src->hashes[j];
+    }
+    // keep the k largest
+    for (s32 i = 0; i < n; i++) {
+        if (merged.len < merged.k) {
+            ss_add(&merged, all[i].key, hashes[i], all[i].count, all[i].error);
+        } else if (all[i].count > merged.counts[merged.heap[0]]) {
+            s32 slot = merged.heap[0];
+            ss_table_remove(&merged, ss_lookup(&merged, builder_to_string(merged.keys[slot]), merged.hashes[slot]));
+            merged.keys[slot].len = 0;
+            builder_append_context(merged.context, &merged.keys[slot], all[i].key);
+            merged.hashes[slot] = hashes[i];
+            merged.counts[slot] = all[i].count;
+            merged.errors[slot] = all[i].error;
+            merged.table[ss_lookup(&merged, all[i].key, hashes[i])] = slot;
+            ss_sift_down(&merged, 0);
+        }
+    }
+    PMK_FREE(dst->context, all);
+    PMK_FREE(dst->context, hashes);
+    space_saving_destroy_context(dst->context, dst);
+    *dst = merged;
+    return 0;
+}
+
+HyperLogLog
+hll_create_context(void * context, s32 precision)
+{
+    HyperLogLog hll = { .precision = MIN(MAX(precision, 4), 18) };
+    hll.registers = PMK_MALLOC(context, (size_t) 1 << hll.precision);
+    memset(hll.registers, 0, (size_t) 1 << hll.precision);
+    return hll;
+}
+
+void
+hll_destroy_context(void * context, HyperLogLog * hll)
+{
+    PMK_FREE(context, hll->registers);
+    *hll = (HyperLogLog) {0};
+}
+
+// the top bits choose a register, which keeps the longest run of leading
+// zeros seen in the remaining bits
+void
+hll_add_hash(HyperLogLog * hll, u64 hash)
+{
+    s32 p = hll->precision;
+    u64 rest = hash << p | (u64) 1 << (p - 1); // the marker bounds the rank
+    u8 rank = (u8) (clz64(rest) + 1);
+    u8 * r = &hll->registers[hash >> (64 - p)];
+    if (*r < rank)
+        *r = rank;
+}
+
+// 2^-r for 0 <= r <= 64, built from its IEEE 754 bits (no libm)
+static double
+hll_pow2_neg(u8 r)
+{
+    u64 bits = (u64) (1023 - r) << 52;
+    double x;
+    memcpy(&x, &bits, sizeof(x));
+    return x;
+}
+
+// natural log of x > 0 without libm: x = f * 2^e with f in [1, 2), and
+// ln f = 2 atanh((f - 1) / (f + 1)) by its series, which converges fast as
+// the argument is below 1/3
+static double
+hll_log(double x)
+{
+    u64 bits;
+    memcpy(&bits, &x, sizeof(bits));
+    s32 e = (s32) ((bits >> 52) & 0x7ff) - 1023;
+    bits = (bits & 0x000fffffffffffffull) | 0x3ff0000000000000ull;
+    double f;
+    memcpy(&f, &bits, sizeof(f));
+    double t = (f - 1) / (f + 1), t2 = t * t, term = t, sum = 0;
+    for (s32 k = 1; k < 40; k += 2) {
+        sum += term / k;
+        term *= t2;
+    }
+    return 2 * sum + e * 0.69314718055994530942;
+}
+
+double
+hll_count(const HyperLogLog * hll)
+{
+    s32 m = 1 << hll->precision;
+    double sum = 0;
+    s32 zeros = 0;
+    for (s32 i = 0; i < m; i++) {
+        sum += hll_pow2_neg(hll->registers[i]);
+        zeros += hll->registers[i] == 0;
+    }
+    double alpha = m == 16 ? 0.673 : m == 32 ? 0.697 : m == 64 ? 0.709 : 0.7213 / (1 + 1.079 / m);
+    double estimate = alpha * m * m / sum;
+    // small cardinalities: linear counting of empty registers is more accurate
+    if (estimate <= 2.5 * m && zeros > 0)
+        estimate = m * hll_log((double) m / zeros);
+    return estimate;
+}
+
+int
+hll_merge(HyperLogLog * dst, const HyperLogLog * src)
+{
+    if (dst->precision != src->precision)
+        return -EINVAL;
+    for (s32 i = 0; i < 1 << dst->precision; i++)
+        dst->registers[i] = MAX(dst->registers[i], src->registers[i]);
+    return 0;
+}
+
+#define STRING_FILTER_HEADER 64
+#define STRING_FILTER_MAGIC  "PMKF"
+
+// high 64 bits of a * b
+static u64
+mulhi64(u64 a, u64 b)
+{
+#if defined(__SIZEOF_INT128__)
+    return (u64) (((unsigned __int128) a * b) >> 64);
+#else
+    u64 a_lo = (u32) a, a_hi = a >> 32, b_lo = (u32) b, b_hi = b >> 32;
+    u64 mid = (a_lo * b_lo >> 32) + (u32) (a_hi * b_lo) + a_lo * b_hi;
+    return a_hi * b_hi + (a_hi * b_lo >> 32) + (mid >> 32);
+#endif
+}
+
+// Bloom: the block comes from the high half of the hash, the k bit
+// positions within it from h1 + i * h2 on the low half
+static u32
+bloom_block(const StringFilter * filter, u64 hash)
+{
+    return (u32) (((hash >> 32) * filter->size) >> 32);
+}
+
+// xor: the three positions are in consecutive segments, offset within them
+// by different bits of the hash
+static void
+fuse_positions(const StringFilter * filter, u64 h, u32 pos[3])
+{
+    u32 mask = filter->size - 1;
+    pos[0] = (u32) mulhi64(h, (u64) filter->segment_count * filter->size);
+    pos[1] = (pos[0] + filter->size) ^ ((u32) (h >> 18) & mask);
+    pos[2] = (pos[0] + 2 * filter->size) ^ ((u32) h & mask);
+}
+
+static u8
+fuse_fingerprint(u64 h)
+{
+    return (u8) (h ^ (h >> 32));
+}
+
+static int
+u64_cmp(const void * a, const void * b)
+{
+    u64 x = *(const u64 *) a, y = *(const u64 *) b;
+    return (x > y) - (x < y);
+}
+
+// Peels the 3-hypergraph of keys: a position hit by exactly one key gets
+// that key assigned last, so its fingerprint can be set to make the key's
+// three entries xor to its fingerprint. Retries with a new seed if the
+// graph has a core that cannot be peeled.
+static int
+fuse_build(void * context, StringFilter * filter, u64 * hashes, s32 n, u8 * fingerprints)
+{
+    u32 len = filter->data_len;
+    u8 * counts = PMK_MALLOC(context, len);
+    u64 * xors = PMK_MALLOC(context, len * sizeof(u64));
+    u32 * queue = PMK_MALLOC(context, len * sizeof(u32));
+    u64 * stack_hash = PMK_MALLOC(context, MAX(n, 1) * sizeof(u64));
+    u8 * stack_which = PMK_MALLOC(context, MAX(n, 1));
+    u32 * stack_pos = PMK_MALLOC(context, MAX(n, 1) * sizeof(u32));
+    int ok = 0;
+    for (s32 attempt = 0; attempt < 100 && !ok; attempt++) {
+        filter->seed = hash_fmix64(filter->seed + HASH_K1);
+        memset(counts, 0, len);
+        memset(xors, 0, len * sizeof(u64));
+        for (s32 i = 0; i < n; i++) {
+            u64 h = hash_fmix64(hashes[i] + filter->seed);
+            u32 pos[3];
+            fuse_positions(filter, h, pos);
+            for (s32 j = 0; j < 3; j++) {
+                counts[pos[j]] = (u8) MIN(counts[pos[j]] + 1, 255);
+                xors[pos[j]] ^= h;
+            }
+        }
+        u32 nqueue = 0;
+        for (u32 i = 0; i < len; i++) {
+            if (counts[i] == 1)
+                queue[nqueue++] = i;
+        }
+        s32 peeled = 0;
+        while (nqueue > 0) {
+            u32 i = queue[--nqueue];
+            if (counts[i] != 1)
+                continue;
+            u64 h = xors[i];
+            u32 pos[3];
+            fuse_positions(filter, h, pos);
+            stack_hash[peeled] = h;
+            stack_pos[peeled] = i;
+            stack_which[peeled] = (u8) (pos[0] == i ? 0 : pos[1] == i ? 1 : 2);
+            peeled++;
+            for (s32 j = 0; j < 3; j++) {
+                counts[pos[j]]--;
+                xors[pos[j]] ^= h;
+                if (counts[pos[j]] == 1)
+                    queue[nqueue++] = pos[j];
+            }
+        }
+        ok = peeled == n;
+    }
+    if (ok) {
+        memset(fingerprints, 0, len);
+        for (s32 i = n - 1; i >= 0; i--) {
+            u32 pos[3];
+            fuse_positions(filter, stack_hash[i], pos);
+            s32 w = stack_which[i];
+            fingerprints[stack_pos[i]] = fuse_fingerprint(stack_hash[i]) ^
+                                         fingerprints[pos[(w + 1) % 3]] ^ fingerprints[pos[(w + 2) % 3]];
+        }
+    }
+    PMK_FREE(context, counts);
+    PMK_FREE(context, xors);
+    PMK_FREE(context, queue);
+    PMK_FREE(context, stack_hash);
+    PMK_FREE(context, stack_which);
+    PMK_FREE(context, stack_pos);
+    return ok ? 0 : -EINVAL;
+}
+
+// n at which the binary fuse segment length reaches 2^3, 2^4, ... 2^18:
+// ceil(3.33^(e - 2.25))
+static const u32 fuse_size_steps[] = {
+    3, 9, 28, 92, 304, 1010, 3362, 11193, 37273, 124118, 413310, 1376322,
+    4583150, 15261887, 50822082, 169237530,
+};
+
+// log2(n) in 16.16 fixed point for n >= 1, by repeated squaring of the
+// mantissa, so that sizing a filter needs no libm
+static u64
+log2_fixed16(u64 n)
+{
+    s32 e = 63 - clz64(n);
+    u64 x = (e <= 31) ? n << (31 - e) : n >> (e - 31); // [1, 2) as 1.31
+    u64 result = (u64) e << 16;
+    for (u64 bit = 1 << 15; bit != 0; bit >>= 1) {
+        x = (x * x) >> 31;
+        if (x >= ((u64) 1 << 32)) {
+            x >>= 1;
+            result |= bit;
+        }
+    }
+    return result;
+}
+
+StringFilter
+string_filter_build_context(void * context, int kind, const String * strings, s32 count, s32 bits_per_key)
+{
+    StringFilter filter = { .kind = kind };
+    if (count < 0 || (kind != STRING_FILTER_BLOOM && kind != STRING_FILTER_XOR)) {
+        filter.error = -EINVAL;
+        return filter;
+    }
+    u64 * hashes = PMK_MALLOC(context, MAX(count, 1) * sizeof(u64));
+    for (s32 i = 0; i < count; i++)
+        hashes[i] = string_hash(strings[i]);
+
+    if (kind == STRING_FILTER_BLOOM) {
+        bits_per_key = bits_per_key > 0 ? bits_per_key : 10;
+        filter.k = (u32) MIN(MAX(bits_per_key * 69 / 100, 1), 16);
+        filter.size = (u32) MAX(((s64) count * bits_per_key + 511) / 512, 1);
+        filter.data_len = filter.size * 64;
+    } else {
+        // sizes from Graf and Lemire, Binary Fuse Filters (2022)
+        qsort(hashes, count, sizeof(u64), u64_cmp);
+        s32 n = 0;
+        for (s32 i = 0; i < count; i++) {
+            if (n == 0 || hashes[i] != hashes[n-1])
+                hashes[n++] = hashes[i];
+        }
+        count = n;
+        // segment length 2^floor(log(n) / log(3.33) + 2.25), at most 2^18
+        s32 e = 2;
+        while (e < 18 && (u32) n >= fuse_size_steps[e - 2])
+            e++;
+        filter.size = 1u << e;
+        // n * max(1.125, 0.875 + 0.25 * log(10^6) / log(n)), in 16.16 fixed point
+        s64 capacity = 0;
+        if (n >= 2) {
+            u64 log2_n = log2_fixed16((u64) n);
+            u64 log2_million = 1306235; // log2(10^6) * 2^16
+            capacity = ((s64) n * 7 + 4) / 8 + (s64) (((u64) n * log2_million + 2 * log2_n) / (4 * log2_n));
+            capacity = MAX(capacity, ((s64) n * 9 + 4) / 8);
+        }
+        s64 segments = (capacity + filter.size - 1) / filter.size - 2;
+        filter.segment_count = (u32) MAX(segments, 1);
+        filter.data_len = (filter.segment_count + 2) * filter.size;
+    }
+
+    // 64-byte aligned, for Bloom blocks
+    filter.owned = PMK_MALLOC(context, filter.data_len + 63);
+    u8 * data = (u8 *) (((uintptr_t) filter.owned + 63) & ~(uintptr_t) 63);
+    filter.data = data;
+    memset(data, 0, filter.data_len);
+    if (kind == STRING_FILTER_BLOOM) {
+        for (s32 i = 0; i < count; i++) {
+            u8 * block = data + (size_t) bloom_block(&filter, hashes[i]) * 64;
+            u32 h1 = (u32) hashes[i], h2 = (u32) (hashes[i] >> 23) | 1;
+            for (u32 j = 0; j < filter.k; j++) {
+                u32 bit = (h1 + j * h2) & 511;
+                block[bit >> 3] |= (u8) (1 << (bit & 7));
+            }
+        }
+    } else {
+        filter.error = fuse_build(context, &filter, hashes, count, data);
+    }
+    PMK_FREE(context, hashes);
+    return filter;
+}
+
+void
+string_filter_destroy_context(void * context, StringFilter * filter)
+{
+    if (filter->owned)
+        PMK_FREE(context, filter->owned);
+    *filter = (StringFilter) {0};
+}
+
+int
+string_filter_contains_hash(const StringFilter * filter, u64 hash)
+{
+    if (filter->kind == STRING_FILTER_BLOOM) {
+        const u8 * block = filter->data + (size_t) bloom_block(filter, hash) * 64;
+        u32 h1 = (u32) hash, h2 = (u32) (hash >> 23) | 1;
+        for (u32 j = 0; j < filter->k; j++) {
+            u32 bit = (h1 + j * h2) & 511;
+            if (!(block[bit >> 3] & (1 << (bit & 7))))
+                return 0;
+        }
+        return 1;
+    }
+    u64 h = hash_fmix64(hash + filter->seed);
+    u32 pos[3];
+    fuse_positions(filter, h, pos);
+    return (fuse_fingerprint(h) ^ filter->data[pos[0]] ^ filter->data[pos[1]] ^ filter->data[pos[2]]) == 0;
+}
+
+static void
+put_u32_le(u8 * p, u32 x)
+{
+    for (s32 i = 0; i < 4; i++)
+        p[i] = (u8) (x >> (8 * i));
+}
+
+static u32
+get_u32_le(const u8 * p)
+{
+    return (u32) p[0] | (u32) p[1] << 8 | (u32) p[2] << 16 | (u32) p[3] << 24;
+}
+
+// header: magic, kind, k, size, segment_count, data_len, seed (all
+// little-endian), zero padding to 64 bytes; then the data
+void
+builder_append_string_filter_context(void * context, StringBuilder * builder, const StringFilter * filter)
+{
+    u8 header[STRING_FILTER_HEADER] = {0};
+    memcpy(header, STRING_FILTER_MAGIC, 4);
+    put_u32_le(header + 4, (u32) filter->kind);
+    put_u32_le(header + 8, filter->k);
+    put_u32_le(header + 12, filter->size);
+    put_u32_le(header + 16, filter->segment_count);
+    put_u32_le(header + 20, filter->data_len);
+    put_u32_le(header + 24, (u32) filter->seed);
+    put_u32_le(header + 28, (u32) (filter->seed >> 32));
+    builder_append_context(context, builder, (String) { .data = (char *) header, .len = STRING_FILTER_HEADER });
+    builder_append_context(context, builder, (String) { .data = (char *) filter->data, .len = (s32) filter->data_len });
+}
+
+int
+string_filter_view(String blob, StringFilter * filter)
+{
+    const u8 * p = (const u8 *) blob.data;
+    if (blob.len < STRING_FILTER_HEADER || memcmp(p, STRING_FILTER_MAGIC, 4) != 0)
+        return -EINVAL;
+    StringFilter f = {
+        .kind = (int) get_u32_le(p + 4),
+        .k = get_u32_le(p + 8),
+        .size = get_u32_le(p + 12),
+        .segment_count = get_u32_le(p + 16),
+        .data_len = get_u32_le(p + 20),
+        .seed = get_u32_le(p + 24) | (u64) get_u32_le(p + 28) << 32,
+        .data = p + STRING_FILTER_HEADER,
+    };
+    int valid = f.data_len <= (u32) blob.len - STRING_FILTER_HEADER && f.size > 0;
+    if (f.kind == STRING_FILTER_BLOOM)
+        valid = valid && f.k >= 1 && f.k <= 16 && (u64) f.size * 64 == f.data_len;
+    else if (f.kind == STRING_FILTER_XOR)
+        valid = valid && (f.size & (f.size - 1)) == 0 && f.segment_count > 0 &&
+                ((u64) f.segment_count + 2) * f.size == f.data_len;
+    else
+        valid = 0;
+    if (!valid)
+        return -EINVAL;
+    *filter = f;
+    return 0;
+}
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+enum { RADIX_LEAF, RADIX_NODE4, RADIX_NODE16, RADIX_NODE48, RADIX_NODE256 };
+
+typedef struct {
+    u8 type;
+    s32 value;
+    String key;         // bytes follow the leaf
+} RadixLeaf;
+
+// header shared by the inner nodes; prefix points into the key of some leaf
+// below the node, so it needs no storage of its own
+typedef struct {
+    u8 type;
+    u16 count;
+    s32 prefix_len;
+    const char * prefix;
+    RadixLeaf * leaf;   // key ending at this node, after the prefix
+} RadixNode;
+
+typedef struct { RadixNode n; u8 keys[4];    void * children[4];   } RadixNode4;
+typedef struct { RadixNode n; u8 keys[16];   void * children[16];  } RadixNode16;
+typedef struct { RadixNode n; u8 index[256]; void * children[48];  } RadixNode48; // index is child + 1, 0 if none
+typedef struct { RadixNode n;                void * children[256]; } RadixNode256;
+
+static void **
+radix_child(RadixNode * node, u8 byte)
+{
+    switch (node->type) {
+    case RADIX_NODE4: {
+        RadixNode4 * n = (RadixNode4 *) node;
+        for (s32 i = 0; i < node->count; i++) {
+            if (n->keys[i] == byte)
+                return &n->children[i];
+        }
+        return NULL;
+    }
+    case RADIX_NODE16: {
+        RadixNode16 * n = (RadixNode16 *) node;
+#if defined(__SSE2__) || defined(_M_X64)
+        __m128i eq = _mm_cmpeq_epi8(_mm_set1_epi8((char) byte), _mm_loadu_si128((const __m128i *) n->keys));
+        u32 mask = (u32) _mm_movemask_epi8(eq) & ((1u << node->count) - 1);
+        return mask ? &n->children[ctz64(mask)] : NULL;
+#else
+        for (s32 i = 0; i < node->count; i++) {
+            if (n->keys[i] == byte)
+                return &n->children[i];
+        }
+        return NULL;
+#endif
+    }
+    case RADIX_NODE48: {
+        RadixNode48 * n = (RadixNode48 *) node;
+        return n->index[byte] ? &n->children[n->index[byte] - 1] : NULL;
+    }
+    default: {
+        RadixNode256 * n = (RadixNode256 *) node;
+        return n->children[byte] ? &n->children[byte] : NULL;
+    }
+    }
+}
+
+static RadixNode *
+radix_node_new(void * context, u8 type)
+{
+    size_t size = (type == RADIX_NODE4)  ? sizeof(RadixNode4)  :
+                  (type == RADIX_NODE16) ? sizeof(RadixNode16) :
+                  (type == RADIX_NODE48) ? sizeof(RadixNode48) : sizeof(RadixNode256);
+    RadixNode * node = PMK_MALLOC(context, size);
+    memset(node, 0, size);
+    node->type = type;
+    return node;
+}
+
+// adds a child to the node in *ref, replacing it with a larger node if full
+static void
+radix_add_child(void * context, void ** ref, u8 byte, void * child)
+{
+    RadixNode * node = *ref;
+    s32 count = node->count;
+    if (node->type == RADIX_NODE4 && count == 4) {
+        RadixNode4 * old = (RadixNode4 *) node;
+        RadixNode16 * n = (RadixNode16 *) radix_node_new(context, RADIX_NODE16);
+        n->n = old->n;
+        n->n.type = RADIX_NODE16;
+        memcpy(n->keys, old->keys, sizeof(old->keys));
+        memcpy(n->children, old->children, sizeof(old->children));
+        PMK_FREE(context, old);
+        node = &n->n;
+    } else if (node->type == RADIX_NODE16 && count == 16) {
+        RadixNode16 * old = (RadixNode16 *) node;
+        RadixNode48 * n = (RadixNode48 *) radix_node_new(context, RADIX_NODE48);
+        n->n = old->n;
+        n->n.type = RADIX_NODE48;
+        for (s32 i = 0; i < 16; i++) {
+            n->index[old->keys[i]] = (u8) (i + 1);
+            n->children[i] = old->children[i];
+        }
+        PMK_FREE(context, old);
+        node = &n->n;
+    } else if (node->type == RADIX_NODE48 && count == 48) {
+        RadixNode48 * old = (RadixNode48 *) node;
+        RadixNode256 * n = (RadixNode256 *) radix_node_new(context, RADIX_NODE256);
+        n->n = old->n;
+        n->n.type = RADIX_NODE256;
+        for (s32 b = 0; b < 256; b++) {
+            if (old->index[b])
+                n->children[b] = old->children[old->index[b] - 1];
+        }
+        PMK_FREE(context, old);
+        node = &n->n;
+    }
+    *ref = node;
+
+    switch (node->type) {
+    case RADIX_NODE4: {
+        RadixNode4 * n = (RadixNode4 *) node;
+        n->keys[count] = byte;
+        n->children[count] = child;
+        break;
+    }
+    case RADIX_NODE16: {
+        RadixNode16 * n = (RadixNode16 *) node;
+        n->keys[count] = byte;
+        n->children[count] = child;
+        break;
+    }
+    case RADIX_NODE48: {
+        RadixNode48 * n = (RadixNode48 *) node;
+        n->index[byte] = (u8) (count + 1);
+        n->children[count] = child;
+        break;
+    }
+    default:
+        ((RadixNode256 *) node)->children[byte] = child;
+        break;
+    }
+    node->count++;
+}
+
+// places leaf below a new node, at the first byte after depth
+static void
+radix_place_leaf(void * context, void ** ref, RadixLeaf * leaf, s32 depth)
+{
+    RadixNode * node = *ref;
+    if (leaf->key.len == depth)
+        node->leaf = leaf;
+    else
+        radix_add_child(context, ref, (u8) leaf->key.data[depth], leaf);
+}
+
+int
+radix_insert_context(void * context, RadixTree * tree, String key, s32 value)
+{
+    RadixLeaf * leaf = PMK_MALLOC(context, sizeof(RadixLeaf) + key.len);
+    leaf->type = RADIX_LEAF;
+    leaf->value = value;
+    leaf->key.data = (char *) (leaf + 1);
+    leaf->key.len = key.len;
+    if (key.len > 0)
+        memcpy(leaf->key.data, key.data, key.len);
+    key = leaf->key;
+
+    void ** ref = &tree->root;
+    s32 depth = 0;
+    while (*ref != NULL) {
+        if (*(u8 *) *ref == RADIX_LEAF) {
+            RadixLeaf * other = *ref;
+            if (string_equal(other->key, key)) {
+                other->value = value;
+                PMK_FREE(context, leaf);
+                return 0;
+            }
+            s32 p = 0;
+            s32 limit = MIN(key.len, other->key.len) - depth;
+            while (p < limit && key.data[depth + p] == other->key.data[depth + p])
+                p++;
+            RadixNode * node = radix_node_new(context, RADIX_NODE4);
+            node->prefix = key.data + depth;
+            node->prefix_len = p;
+            *ref = node;
+            radix_place_leaf(context, ref, other, depth + p);
+            radix_place_leaf(context, ref, leaf, depth + p);
+            tree->count++;
+            return 1;
+        }
+
+        RadixNode * node = *ref;
+        s32 p = 0;
+        s32 limit = MIN(node->prefix_len, key.len - depth);
+        while (p < limit && node->prefix[p] == key.data[depth + p])
+            p++;
+        if (p < node->prefix_len) {
+            // the key leaves the compressed path: split it at p
+            RadixNode * split = radix_node_new(context, RADIX_NODE4);
+            split->prefix = node->prefix;
+            split->prefix_len = p;
+            u8 byte = (u8) node->prefix[p];
+            node->prefix += p + 1;
+            node->prefix_len -= p + 1;
+            *ref = split;
+            radix_add_child(context, ref, byte, node);
+            radix_place_leaf(context, ref, leaf, depth + p);
+            tree->count++;
+            return 1;
+        }
+        depth += node->prefix_len;
+        if (depth == key.len) {
+            if (node->leaf != NULL) {
+                node->leaf->value = value;
+                PMK_FREE(context, leaf);
+                return 0;
+            }
+            node->leaf = leaf;
+            tree->count++;
+            return 1;
+        }
+        void ** child = radix_child(node, (u8) key.data[depth]);
+        if (child == NULL) {
+            radix_add_child(context, ref, (u8) key.data[depth], leaf);
+            tree->count++;
+            return 1;
+        }
+        ref = child;
+        depth++;
+    }
+    *ref = leaf;
+    tree->count++;
+    return 1;
+}
+
+// frees nodes from an explicit stack, since keys can nest deeper than the
+// call stack would allow
+void
+radix_destroy_context(void * context, RadixTree * tree)
+{
+    void ** stack = NULL;
+    s32 len = 0, cap = 0;
+    if (tree->root != NULL) {
+        stack = PMK_MALLOC(context, 16 * sizeof(void *));
+        cap = 16;
+        stack[len++] = tree->root;
+    }
+    while (len > 0) {
+        void * ptr = stack[--len];
+        RadixNode * node = ptr;
+        if (node->type != RADIX_LEAF) {
+            if (node->leaf != NULL)
+                PMK_FREE(context, node->leaf);
+            if (len + node->count > cap) {
+                s32 new_cap = MAX(2 * cap, len + node->count);
+                stack = PMK_REALLOC(context, stack, cap * sizeof(void *), new_cap * sizeof(void *));
+                cap = new_cap;
+            }
+            for (s32 b = 0; b < 256; b++) {
+                void ** child = radix_child(node, (u8) b);
+                if (child != NULL)
+                    stack[len++] = *child;
+            }
+        }
+        PMK_FREE(context, ptr);
+    }
+    PMK_FREE(context, stack);
+    tree->root = NULL;
+    tree->count = 0;
+}
+
+s32
+radix_find(const RadixTree * tree, String key)
+{
+    void * ptr = tree->root;
+    s32 depth = 0;
+    while (ptr != NULL) {
+        if (*(u8 *) ptr == RADIX_LEAF) {
+            RadixLeaf * leaf = ptr;
+            return string_equal(leaf->key, key) ? leaf->value : -1;
+        }
+        RadixNode * node = ptr;
+        if (key.len - depth < node->prefix_len ||
+            memcmp(key.data + depth, node->prefix, node->prefix_len) != 0)
+            return -1;
+        depth += node->prefix_len;
+        if (depth == key.len)
+            return node->leaf ? node->leaf->value : -1;
+        void ** child = radix_child(node, (u8) key.data[depth++]);
+        ptr = child ? *child : NULL;
+    }
+    return -1;
+}
+
+s32
+radix_longest_prefix(const RadixTree * tree, String string, s32 * len)
+{
+    s32 best = -1, best_len = 0;
+    void * ptr = tree->root;
+    s32 depth = 0;
+    while (ptr != NULL) {
+        if (*(u8 *) ptr == RADIX_LEAF) {
+            // bytes before depth already matched on the way down
+            RadixLeaf * leaf = ptr;
+            if (leaf->key.len <= string.len &&
+                memcmp(leaf->key.data + depth, string.data + depth, leaf->key.len - depth) == 0) {
+                best = leaf->value;
+                best_len = leaf->key.len;
+            }
+            break;
+        }
+        RadixNode * node = ptr;
+        if (string.len - depth < node->prefix_len ||
+            memcmp(string.data + depth, node->prefix, node->prefix_len) != 0)
+            break;
+        depth += node->prefix_len;
+        if (node->leaf != NULL) {
+            best = node->leaf->value;
+            best_len = depth;
+        }
+        if (depth == string.len)
+            break;
+        void ** child = radix_child(node, (u8) string.data[depth++]);
+        ptr = child ? *child : NULL;
+    }
+    if (len != NULL)
+        *len = best_len;
+    return best;
+}
+
+StringCounter
+counter_create_context(void * context, s32 n)
+{
+    StringCounter counter = { .context = context, .bits = 4 };
+    while ((1 << counter.bits) < 2 * n)
+        counter.bits++;
+    size_t size = ((size_t) 1 << counter.bits) * sizeof(CounterSlot);
+    counter.slots = PMK_MALLOC(context, size);
+    for (s32 i = 0; i < (1 << counter.bits); i++)
+        counter.slots[i].len = -1;
+    return counter;
+}
+
+void
+counter_destroy_context(void * context, StringCounter * counter)
+{
+    PMK_FREE(context, counter->slots);
+    builder_destroy_context(context, &counter->keys);
+    *counter = (StringCounter) {0};
+}
+
+static int
+counter_slot_equal(const StringCounter * counter, const CounterSlot * slot, String key, u64 hash)
+{
+    if (slot->hash != hash || slot->len != key.len)
+        return 0;
+    if (key.len <= 8)
+        return memcmp(slot->head, key.data, key.len) == 0;
+    return memcmp(counter->keys.data + slot->offset, key.data, key.len) == 0;
+}
+
+// index of the slot holding key, or of the empty slot ending its probe
+static u32
+counter_lookup(const StringCounter * counter, String key, u64 hash)
+{
+    u32 mask = (1u << counter->bits) - 1;
+    u32 i = (u32) (hash >> (64 - counter->bits));
+    while (counter->slots[i].len >= 0 && !counter_slot_equal(counter, &counter->slots[i], key, hash))
+        i = (i + 1) & mask;
+    return i;
+}
+
+// doubles the table; keys stay where they are in the key buffer
+static void
+counter_grow(StringCounter * counter)
+{
+    CounterSlot * old = counter->slots;
+    s32 old_cap = 1 << counter->bits;
+    counter->bits++;
+    u32 mask = (1u << counter->bits) - 1;
+    counter->slots = PMK_MALLOC(counter->context, ((size_t) 1 << counter->bits) * sizeof(CounterSlot));
+    for (u32 i = 0; i <= mask; i++)
+        counter->slots[i].len = -1;
+    for (s32 j = 0; j < old_cap; j++) {
+        if (old[j].len < 0)
+            continue;
+        u32 i = (u32) (old[j].hash >> (64 - counter->bits));
+        while (counter->slots[i].len >= 0)
+            i = (i + 1) & mask;
+        counter->slots[i] = old[j];
+    }
+    PMK_FREE(counter->context, old);
+}
+
+void
+counter_add_hash(StringCounter * counter, String key, u64 hash, u64 count)
+{
+    counter->total += count;
+    u32 i = counter_lookup(counter, key, hash);
+    CounterSlot * slot = &counter->slots[i];
+    if (slot->len >= 0) {
+        slot->count += count;
+        return;
+    }
+    // keep the load at most 1/2
+    if (2 * (counter->len + 1) > (1 << counter->bits)) {
+        counter_grow(counter);
+        slot = &counter->slots[counter_lookup(counter, key, hash)];
+    }
+    counter->len++;
+    slot->hash = hash;
+    slot->count = count;
+    slot->len = key.len;
+    slot->offset = counter->keys.len;
+    memset(slot->head, 0, sizeof(slot->head));
+    memcpy(slot->head, key.data, MIN(key.len, 8));
+    builder_append_context(counter->context, &counter->keys, key);
+}
+
+u64
+counter_get_hash(const StringCounter * counter, String key, u64 hash)
+{
+    const CounterSlot * slot = &counter->slots[counter_lookup(counter, key, hash)];
+    return slot->len >= 0 ? slot->count : 0;
+}
+
+void
+counter_merge(StringCounter * dst, const StringCounter * src)
+{
+    for (s32 j = 0; j < (1 << src->bits); j++) {
+        const CounterSlot * slot = &src->slots[j];
+        if (slot->len >= 0) {
+            String key = { .data = src->keys.data + slot->offset, .len = slot->len };
+            counter_add_hash(dst, key, slot->hash, slot->count);
+        }
+    }
+}
+
+static void
+heavy_hitter_swap(HeavyHitter * a, HeavyHitter * b)
+{
+    HeavyHitter t = *a;
+    *a = *b;
+    *b = t;
+}
+
+// moves the k entries that sort first under heavy_hitter_cmp() to the front,
+// in no particular order (quickselect with median-of-three pivots)
+static void
+heavy_hitter_select(HeavyHitter * a, s32 n, s32 k)
+{
+    s32 lo = 0, hi = n - 1;
+    while (lo < hi) {
+        s32 mid = lo + (hi - lo) / 2;
+        if (heavy_hitter_cmp(&a[mid], &a[lo]) < 0)
+            heavy_hitter_swap(&a[mid], &a[lo]);
+        if (heavy_hitter_cmp(&a[hi], &a[lo]) < 0)
+            heavy_hitter_swap(&a[hi], &a[lo]);
+        if (heavy_hitter_cmp(&a[hi], &a[mid]) < 0)
+            heavy_hitter_swap(&a[hi], &a[mid]);
+        HeavyHitter pivot = a[mid];
+        s32 i = lo, j = hi;
+        while (i <= j) {
+            while (heavy_hitter_cmp(&a[i], &pivot) < 0)
+                i++;
+            while (heavy_hitter_cmp(&pivot, &a[j]) < 0)
+                j--;
+            if (i <= j) {
+                heavy_hitter_swap(&a[i], &a[j]);
+                i++;
+                j--;
+            }
+        }
+        if (k - 1 <= j)
+            hi = j;
+        else if (k - 1 >= i)
+            lo = i;
+        else
+            break;
+    }
+}
+
+s32
+counter_top_k(const StringCounter * counter, HeavyHitter * out, s32 k)
+{
+    k = MIN(MAX(k, 0), counter->len);
+    if (k == 0)
+        return 0;
+    HeavyHitter * all = PMK_MALLOC(counter->context, counter->len * sizeof(HeavyHitter));
+    s32 n = 0;
+    for (s32 j = 0; j < (1 << counter->bits); j++) {
+        const CounterSlot * slot = &counter->slots[j];
+        if (slot->len >= 0) {
+            String key = { .data = counter->keys.data + slot->offset, .len = slot->len };
+            all[n++] = (HeavyHitter) { key, slot->count, 0 };
+        }
+    }
+    if (k < n)
+        heavy_hitter_select(all, n, k);
+    qsort(all, k, sizeof(HeavyHitter), heavy_hitter_cmp);
+    memcpy(out, all, k * sizeof(HeavyHitter));
+    PMK_FREE(counter->context, all);
+    return k;
+}
+
+static u32
+column_prefix4(String string)
+{
+    u32 x = 0;
+    for (s32 i = 0; i < MIN(string.len, 4); i++)
+        x |= (u32) (u8) string.data[i] << (8 * i);
+    return x;
+}
+
+void
+column_append_context(void * context, StringColumn * column, String string)
+{
+    if (column->count == column->cap) {
+        s32 cap = MAX(16, 2 * column->cap);
+        column->lens    = PMK_REALLOC(context, column->lens,    column->cap * sizeof(s32), cap * sizeof(s32));
+        column->offsets = PMK_REALLOC(context, column->offsets, column->cap * sizeof(u32), cap * sizeof(u32));
+        column->prefix4 = PMK_REALLOC(context, column->prefix4, column->cap * sizeof(u32), cap * sizeof(u32));
+        column->cap = cap;
+    }
+    s32 i = column->count++;
+    column->lens[i] = string.len;
+    column->offsets[i] = (u32) column->heap.len;
+    column->prefix4[i] = column_prefix4(string);
+    builder_append_context(context, &column->heap, string);
+}
+
+void
+column_destroy_context(void * context, StringColumn * column)
+{
+    PMK_FREE(context, column->lens);
+    PMK_FREE(context, column->offsets);
+    PMK_FREE(context, column->prefix4);
+    builder_destroy_context(context, &column->heap);
+    *column = (StringColumn) {0};
+}
+
+String
+column_get(const StringColumn * column, s32 i)
+{
+    return (String) { .data = column->heap.data + column->offsets[i], .len = column->lens[i] };
+}
+
+// sets the bitmap to the rows with min_len <= len <= max_len and
+// (prefix4 & mask) == want, and returns their number
+static s32
+column_scan(const StringColumn * column, s32 min_len, s32 max_len, u32 mask, u32 want, u64 * bitmap)
+{
+    const s32 * lens = column->lens;
+    const u32 * prefix4 = column->prefix4;
+    s32 n = column->count;
+    s32 selected = 0;
+    for (s32 base = 0; base < n; base += 64) {
+        u64 word = 0;
+        s32 i = base, end = MIN(n, base + 64);
+        if (end - base == 64) {
+#if defined(__AVX2__)
+            __m256i lo = _mm256_set1_epi32(min_len), hi = _mm256_set1_epi32(max_len);
+            __m256i m = _mm256_set1_epi32((s32) mask), w = _mm256_set1_epi32((s32) want);
+            for (; i < end; i += 8) {
+                __m256i len = _mm256_loadu_si256((const __m256i *) (lens + i));
+                __m256i pre = _mm256_loadu_si256((const __m256i *) (prefix4 + i));
+                __m256i out = _mm256_or_si256(_mm256_cmpgt_epi32(lo, len), _mm256_cmpgt_epi32(len, hi));
+                __m256i eq = _mm256_cmpeq_epi32(_mm256_and_si256(pre, m), w);
+                u32 bits = (u32) _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_andnot_si256(out, eq)));
+                word |= (u64) bits << (i - base);
+            }
+#elif defined(__SSE2__) || defined(_M_X64)
+            __m128i lo = _mm_set1_epi32(min_len), hi = _mm_set1_epi32(max_len);
+            __m128i m = _mm_set1_epi32((s32) mask), w = _mm_set1_epi32((s32) want);
+            for (; i < end; i += 4) {
+                __m128i len = _mm_loadu_si128((const __m128i *) (lens + i));
+                __m128i pre = _mm_loadu_si128((const __m128i *) (prefix4 + i));
+                __m128i out = _mm_or_si128(_mm_cmplt_epi32(len, lo), _mm_cmpgt_epi32(len, hi));
+                __m128i eq = _mm_cmpeq_epi32(_mm_and_si128(pre, m), w);
+                u32 bits = (u32) _mm_movemask_ps(_mm_castsi128_ps(_mm_andnot_si128(out, eq)));
+                word |= (u64) bits << (i - base);
+            }
+#endif
+        }
+        for (; i < end; i++) {
+            int hit = lens[i] >= min_len && lens[i] <= max_len && (prefix4[i] & mask) == want;
+            word |= (u64) hit << (i - base);
+        }
+        bitmap[base / 64] = word;
+        selected += popcount64(word);
+    }
+    return selected;
+}
+
+// clears the rows of the bitmap whose bytes from 4 on differ from value's
+static s32
+column_refine(const StringColumn * column, String value, u64 * bitmap)
+{
+    s32 selected = 0;
+    for (s32 w = 0; w < (column->count + 63) / 64; w++) {
+        for (u64 bits = bitmap[w]; bits != 0; bits &= bits - 1) {
+            s32 i = w * 64 + ctz64(bits);
+            if (memcmp(column->heap.data + column->offsets[i] + 4, value.data + 4, value.len - 4) != 0)
+                bitmap[w] &= ~((u64) 1 << (i % 64));
+        }
+        selected += popcount64(bitmap[w]);
+    }
+    return selected;
+}
+
+s32
+column_filter_len(const StringColumn * column, s32 min_len, s32 max_len, u64 * bitmap)
+{
+    return column_scan(column, min_len, max_len, 0, 0, bitmap);
+}
+
+s32
+column_filter_prefix(const StringColumn * column, String prefix, u64 * bitmap)
+{
+    u32 mask = prefix.len >= 4 ? 0xffffffffu : ((u32) 1 << (8 * prefix.len)) - 1;
+    s32 selected = column_scan(column, prefix.len, INT32_MAX, mask, column_prefix4(prefix), bitmap);
+    if (prefix.len > 4 && selected > 0)
+        selected = column_refine(column, prefix, bitmap);
+    return selected;
+}
+
+s32
+column_equal_const(const StringColumn * column, String value, u64 * bitmap)
+{
+    u32 mask = value.len >= 4 ? 0xffffffffu : ((u32) 1 << (8 * value.len)) - 1;
+    s32 selected = column_scan(column, value.len, value.len, mask, column_prefix4(value), bitmap);
+    if (value.len > 4 && selected > 0)
+        selected = column_refine(column, value, bitmap);
+    return selected;
+}
+
+s32
+bitmap_to_indices(const u64 * bitmap, s32 count, s32 * out)
+{
+    s32 n = 0;
+    for (s32 w = 0; w < (count + 63) / 64; w++) {
+        u64 bits = bitmap[w];
+        if (count - w * 64 < 64)
+            bits &= ((u64) 1 << (count - w * 64)) - 1;
+        for (; bits != 0; bits &= bits - 1)
+            out[n++] = w * 64 + ctz64(bits);
+    }
+    return n;
+}
+
+u32
+dict_code(const DictColumn * column, s32 row)
+{
+    if (column->code_size == 2)
+        return ((const u16 *) column->codes)[row];
+    return ((const u32 *) column->codes)[row];
+}
+
+String
+dict_decode(const DictColumn * column, u32 code)
+{
+    return (String) { .data = column->heap.data + column->offsets[code], .len = column->lens[code] };
+}
+
+// index of the table entry holding value, or of the empty entry ending its probe
+static u32
+dict_probe(const DictColumn * column, String value, u64 hash)
+{
+    u32 mask = (1u << column->table_bits) - 1;
+    u32 i = (u32) (hash >> (64 - column->table_bits));
+    for (; column->table[i] >= 0; i = (i + 1) & mask) {
+        s32 code = column->table[i];
+        if (column->hashes[code] == hash && string_equal(dict_decode(column, code), value))
+            break;
+    }
+    return i;
+}
+
+s64
+dict_lookup(const DictColumn * column, String value)
+{
+    if (column->table == NULL)
+        return -1;
+    return column->table[dict_probe(column, value, string_hash(value))];
+}
+
+static void
+dict_rebuild_table(void * context, DictColumn * column, s32 bits)
+{
+    PMK_FREE(context, column->table);
+    column->table_bits = bits;
+    column->table = PMK_MALLOC(context, ((size_t) 1 << bits) * sizeof(s32));
+    memset(column->table, 0xff, ((size_t) 1 << bits) * sizeof(s32));
+    for (s32 c = 0; c < column->ndict; c++)
+        column->table[dict_probe(column, dict_decode(column, c), column->hashes[c])] = c;
+}
+
+static u32
+dict_intern(void * context, DictColumn * column, String value)
+{
+    if (column->table == NULL)
+        dict_rebuild_table(context, column, 4);
+    u64 hash = string_hash(value);
+    u32 i = dict_probe(column, value, hash);
+    if (column->table[i] >= 0)
+        return (u32) column->table[i];
+
+    s32 code = column->ndict++;
+    if (code == column->dict_cap) {
+        s32 cap = MAX(16, 2 * column->dict_cap);
+        column->offsets = PMK_REALLOC(context, column->offsets, column->dict_cap * sizeof(u32), cap * sizeof(u32));
+        column->lens    = PMK_REALLOC(context, column->lens,    column->dict_cap * sizeof(s32), cap * sizeof(s32));
+        column->hashes  = PMK_REALLOC(context, column->hashes,  column->dict_cap * sizeof(u64), cap * sizeof(u64));
+        column->dict_cap = cap;
+    }
+    column->offsets[code] = (u32) column->heap.len;
+    column->lens[code] = value.len;
+    column->hashes[code] = hash;
+    builder_append_context(context, &column->heap, value);
+    column->table[i] = code;
+    // a new value lands after the others, which breaks sorted order unless it
+    // is the greatest
+    if (column->sorted && code > 0 && string_compare(dict_decode(column, code - 1), value) > 0)
+        column->sorted = 0;
+    if (2 * column->ndict > (1 << column->table_bits))
+        dict_rebuild_table(context, column, column->table_bits + 1);
+    return (u32) code;
+}
+
+u32
+dict_append_context(void * context, DictColumn * column, String value)
+{
+    if (column->count == 0 && column->ndict == 0)
+        column->sorted = 1;
+    if (column->code_size == 0)
+        column->code_size = 2;
+    u32 code = dict_intern(context, column, value);
+    if (code > 0xffff && column->code_size == 2) {
+        u16 * old = column->codes;
+        u32 * wide = PMK_MALLOC(context, column->cap * sizeof(u32));
+        for (s32 r = 0; r < column->count; r++)
+            wide[r] = old[r];
+        PMK_FREE(context, old);
+        column->codes = wide;
+        column->code_size = 4;
+    }
+    if (column->count == column->cap) {
+        s32 cap = MAX(16, 2 * column->cap);
+        column->codes = PMK_REALLOC(context, column->codes, column->cap * column->code_size, cap * column->code_size);
+        column->cap = cap;
+    }
+    if (column->code_size == 2)
+        ((u16 *) column->codes)[column->count++] = (u16) code;
+    else
+        ((u32 *) column->codes)[column->count++] = code;
+    return code;
+}
+
+void
+dict_destroy_context(void * context, DictColumn * column)
+{
+    PMK_FREE(context, column->codes);
+    PMK_FREE(context, column->offsets);
+    PMK_FREE(context, column->lens);
+    PMK_FREE(context, column->hashes);
+    PMK_FREE(context, column->table);
+    builder_destroy_context(context, &column->heap);
+    *column = (DictColumn) {0};
+}
+
+typedef struct {
+    String value;
+    s32 code;
+} DictEntry;
+
+static int
+dict_entry_cmp(const void * a, const void * b)
+{
+    return string_compare(((const DictEntry *) a)->value, ((const DictEntry *) b)->value);
+}
+
+void
+dict_sort_context(void * context, DictColumn * column)
+{
+    s32 n = column->ndict;
+    if (n == 0) {
+        column->sorted = 1;
+        return;
+    }
+    DictEntry * entries = PMK_MALLOC(context, n * sizeof(DictEntry));
+    for (s32 c = 0; c < n; c++)
+        entries[c] = (DictEntry) { dict_decode(column, c), c };
+    qsort(entries, n, sizeof(DictEntry), dict_entry_cmp);
+
+    u32 * offsets = PMK_MALLOC(context, column->dict_cap * sizeof(u32));
+    s32 * lens = PMK_MALLOC(context, column->dict_cap * sizeof(s32));
+    u64 * hashes = PMK_MALLOC(context, column->dict_cap * sizeof(u64));
+    u32 * recode = PMK_MALLOC(context, n * sizeof(u32));
+    for (s32 c = 0; c < n; c++) {
+        s32 old = entries[c].code;
+        offsets[c] = column->offsets[old];
+        lens[c] = column->lens[old];
+        hashes[c] = column->hashes[old];
+        recode[old] = (u32) c;
+    }
+    PMK_FREE(context, column->offsets);
+    PMK_FREE(context, column->lens);
+    PMK_FREE(context, column->hashes);
+    column->offsets = offsets;
+    column->lens = lens;
+    column->hashes = hashes;
+
+    for (s32 i = 0; i < (1 << column->table_bits); i++) {
+        if (column->table[i] >= 0)
+            column->table[i] = (s32) recode[column->table[i]];
+    }
+    if (column->code_size == 2) {
+        u16 * codes = column->codes;
+        for (s32 r = 0; r < column->count; r++)
+            codes[r] = (u16) recode[codes[r]];
+    } else {
+        u32 * codes = column->codes;
+        for (s32 r = 0; r < column->count; r++)
+            codes[r] = recode[codes[r]];
+    }
+    PMK_FREE(context, recode);
+    PMK_FREE(context, entries);
+    column->sorted = 1;
+}
+
+// sets the bitmap to the rows with lo <= code <= hi and returns their number
+static s32
+dict_scan(const DictColumn * column, u32 lo, u32 hi, u64 * bitmap)
+{
+    s32 selected = 0;
+    for (s32 base = 0; base < column->count; base += 64) {
+        s32 end = MIN(column->count, base + 64);
+        u64 word = 0;
+        if (column->code_size == 2) {
+            const u16 * codes = column->codes;
+            for (s32 r = base; r < end; r++)
+                word |= (u64) (codes[r] - lo <= hi - lo) << (r - base);
+        } else {
+            const u32 * codes = column->codes;
+            for (s32 r = base; r < end; r++)
+                word |= (u64) (codes[r] - lo <= hi - lo) << (r - base);
+        }
+        bitmap[base / 64] = word;
+        selected += popcount64(word);
+    }
+    return selected;
+}
+
+s32
+dict_filter_equal(const DictColumn * column, String value, u64 * bitmap)
+{
+    s64 code = dict_lookup(column, value);
+    if (code < 0) {
+        memset(bitmap, 0, ((column->count + 63) / 64) * sizeof(u64));
+        return 0;
+    }
+    return dict_scan(column, (u32) code, (u32) code, bitmap);
+}
+
+// number of dictionary values less than value (or not greater, if inclusive)
+static s32
+dict_bound(const DictColumn * column, String value, int inclusive)
+{
+    s32 lo = 0, hi = column->ndict;
+    while (lo < hi) {
+        s32 mid = lo + (hi - lo) / 2;
+        int cmp = string_compare(dict_decode(column, mid), value);
+        if (cmp < 0 || (inclusive && cmp == 0))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+s32
+dict_filter_range(const DictColumn * column, String lo, String hi, u64 * bitmap)
+{
+    if (!column->sorted && column->ndict > 0)
+        return -EINVAL;
+    s32 first = dict_bound(column, lo, 0);
+    s32 last = dict_bound(column, hi, 1) - 1;
+    if (first > last) {
+        memset(bitmap, 0, ((column->count + 63) / 64) * sizeof(u64));
+        return 0;
+    }
+    return dict_scan(column, (u32) first, (u32) last, bitmap);
+}
+
+void
+dict_group_counts(const DictColumn * column, u64 * counts)
+{
+    memset(counts, 0, column->ndict * sizeof(u64));
+    for (s32 r = 0; r < column->count; r++)
+        counts[dict_code(column, r)]++;
+}
+
+void
+dict_sort_rows_context(void * context, const DictColumn * column, s32 * rows)
+{
+    s32 * start = PMK_MALLOC(context, (column->ndict + 1) * sizeof(s32));
+    memset(start, 0, (column->ndict + 1) * sizeof(s32));
+    for (s32 r = 0; r < column->count; r++)
+        start[dict_code(column, r) + 1]++;
+    for (s32 c = 0; c < column->ndict; c++)
+        start[c + 1] += start[c];
+    for (s32 r = 0; r < column->count; r++)
+        rows[start[dict_code(column, r)]++] = r;
+    PMK_FREE(context, start);
+}
+
+StringSet
+string_set_build_context(void * context, const String * values, s32 count)
+{
+    StringSet set = { .count = count };
+    for (s32 i = 0; i < count; i++)
+        set.max_len = MAX(set.max_len, values[i].len);
+    s32 * per_len = PMK_MALLOC(context, (set.max_len + 1) * sizeof(s32));
+    memset(per_len, 0, (set.max_len + 1) * sizeof(s32));
+    for (s32 i = 0; i < count; i++)
+        per_len[values[i].len]++;
+
+    set.first_group = PMK_MALLOC(context, (set.max_len + 2) * sizeof(s32));
+    s32 ngroups = 0;
+    s64 nbytes = 0;
+    for (s32 n = 0; n <= set.max_len; n++) {
+        set.first_group[n] = ngroups;
+        ngroups += (per_len[n] + 31) / 32;
+        nbytes += (s64) (per_len[n] + 31) / 32 * 32 * n;
+    }
+    set.first_group[set.max_len + 1] = ngroups;
+    set.valid = PMK_MALLOC(context, MAX(ngroups, 1) * sizeof(u32));
+    set.ids = PMK_MALLOC(context, MAX(ngroups, 1) * 32 * sizeof(s32));
+    set.offsets = PMK_MALLOC(context, MAX(ngroups, 1) * sizeof(s32));
+    set.bytes = PMK_MALLOC(context, MAX(nbytes, 1));
+    memset(set.valid, 0, MAX(ngroups, 1) * sizeof(u32));
+    memset(set.bytes, 0, MAX(nbytes, 1));
+    s32 offset = 0;
+    for (s32 n = 0; n <= set.max_len; n++) {
+        for (s32 g = set.first_group[n]; g < set.first_group[n + 1]; g++) {
+            set.offsets[g] = offset;
+            offset += 32 * n;
+        }
+    }
+
+    // per_len now counts the values placed so far
+    memset(per_len, 0, (set.max_len + 1) * sizeof(s32));
+    for (s32 i = 0; i < count; i++) {
+        s32 n = values[i].len;
+        s32 g = set.first_group[n] + per_len[n] / 32;
+        s32 lane = per_len[n]++ % 32;
+        set.valid[g] |= 1u << lane;
+        set.ids[32 * g + lane] = i;
+        for (s32 j = 0; j < n; j++)
+            set.bytes[set.offsets[g] + 32 * j + lane] = (u8) values[i].data[j];
+    }
+    PMK_FREE(context, per_len);
+    return set;
+}
+
+void
+string_set_destroy_context(void * context, StringSet * set)
+{
+    PMK_FREE(context, set->first_group);
+    PMK_FREE(context, set->valid);
+    PMK_FREE(context, set->ids);
+    PMK_FREE(context, set->offsets);
+    PMK_FREE(context, set->bytes);
+    *set = (StringSet) {0};
+}
+
+// bit i set if row[i] == byte, for i < 32
+static u32
+string_set_match_row(const u8 * row, u8 byte)
+{
+#if defined(__AVX2__)
+    __m256i eq = _mm256_cmpeq_epi8(_mm256_loadu_si256((const __m256i *) row), _mm256_set1_epi8((char) byte));
+    return (u32) _mm256_movemask_epi8(eq);
+#elif defined(__SSE2__) || defined(_M_X64)
+    __m128i b = _mm_set1_epi8((char) byte);
+    u32 lo = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) row), b));
+    u32 hi = (u32) _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *) (row + 16)), b));
+    return lo | hi << 16;
+#else
+    u32 mask = 0;
+    for (s32 i = 0; i < 32; i++)
+        mask |= (u32) (row[i] == byte) << i;
+    return mask;
+#endif
+}
+
+s32
+string_find_in_set(const StringSet * set, String key)
+{
+    if (key.len > set->max_len)
+        return -1;
+    for (s32 g = set->first_group[key.len]; g < set->first_group[key.len + 1]; g++) {
+        const u8 * row = set->bytes + set->offsets[g];
+        u32 mask = set->valid[g];
+        for (s32 j = 0; j < key.len && mask != 0; j++, row += 32)
+            mask &= string_set_match_row(row, (u8) key.data[j]);
+        if (mask != 0)
+            return set->ids[32 * g + ctz64(mask)];
+    }
+    return -1;
+}
+
+#ifdef PMK_STRING_TEST
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <regex.h> // POSIX regexec() is the reference for regex_find()
+#endif
+
+static char
+random_printable()
+{
+    int r = (rand() % ('~' - ' ' + 3)) + ' ';
+    assert(r >= ' ');
+    assert(r <= '~' + 2);
+    if (r ==  '~' + 1) r = '\n';
+    if (r ==  '~' + 2) r = '\t';
+    return r;
+}
+
+static void
+gen_random_cstring(char * s, s32 len)
+{
+    for (s32 i = 0; i < len; i++) {
+        s[i] = random_printable();
+    }
+    s[len] = '\0';
+}
+
+static s32
+change_random_char(char * s, s32 len)
+{
+    s32 index = rand() % len;
+    char prev = s[index];
+    char r;
+    do {
+        r = random_printable();
+    } while (r == prev);
+    s[index] = r;
+    return index;
+}
+
+// reference glob matcher for the randomized tests
+static int
+glob_match_slow(String pattern, String string)
+{
+    if (pattern.len == 0)
+        return string.len == 0;
+    if (pattern.data[0] == '*') {
+        for (s32 i = 0; i <= string.len; i++) {
+            if (glob_match_slow(string_substr(pattern, 1, pattern.len), string_substr(string, i, string.len)))
+                return 1;
+        }
+        return 0;
+    }
+    if (string.len == 0 || (pattern.data[0] != '?' && pattern.data[0] != string.data[0]))
+        return 0;
+    return glob_match_slow(string_substr(pattern, 1, pattern.len), string_substr(string, 1, string.len));
+}
+
+// random regex over {a, b} which POSIX extended regexes also accept; anchors
+// are only generated at the top level since glibc lets '^' match again in
+// later iterations of a repeated group
+static void
+gen_random_regex(StringBuilder * builder, s32 depth, int top)
+{
+    s32 npieces = 1 + rand() % 3;
+    if (top && rand() % 8 == 0)
+        builder_append(builder, str_lit("^"));
+    for (s32 i = 0; i < npieces; i++) {
+        s32 r = rand() % (depth > 0 ? 6 : 5);
+        switch (r) {
+            case 0: builder_append(builder, str_lit("a")); break;
+            case 1: builder_append(builder, str_lit("b")); break;
+            case 2: builder_append(builder, str_lit(".")); break;
+            case 3: builder_append(builder, str_lit("[ab]")); break;
+            case 4: builder_append(builder, str_lit("a")); break;
+            case 5:
+                builder_append(builder, str_lit("("));
+                gen_random_regex(builder, depth - 1, 0);
+                builder_append(builder, str_lit(")"));
+                break;
+        }
+        r = rand() % 6;
+        if (r == 0) builder_append(builder, str_lit("*"));
+        if (r == 1) builder_append(builder, str_lit("+"));
+        if (r == 2) builder_append(builder, str_lit("?"));
+    }
+    if (top && rand() % 8 == 0)
+        builder_append(builder, str_lit("$"));
+    if (rand() % 4 == 0) {
+        builder_append(builder, str_lit("|"));
+        gen_random_regex(builder, depth - 1, top);
+    }
+}
+
+static void
+pmk_string_test()
+{
+    // string_equal()
+    assert( string_equal(   str_lit("hello"),   str_lit("hello"))       );
+    assert( string_equal(   str_lit(""),        str_lit(""))            );
+    assert(!string_equal(   str_lit("hello!"),  str_lit("hello?"))      );
+    assert(!string_equal(   str_lit(""),        str_lit("hello"))       );
+    assert(!string_equal(   str_lit("hello"),   str_lit(""))            );
+    assert(!string_equal(   str_lit("hello"),   str_lit("hello there")) );
+    assert(!string_equal(   str_lit("hello!"),  str_lit("hello"))       );
+
+    // string_equaln()
+    assert( string_equaln(  str_lit("hello!"),  str_lit("hello?"),  5)  );
+    assert( string_equaln(  str_lit(""),        str_lit(""),        0)  );
+    assert(!string_equaln(  str_lit("hello!"),  str_lit("hello?"),  6)  );
+    assert(!string_equaln(  str_lit("hello"),   str_lit("hello"),   6)  );
+
+    // string_compare()
+    assert(string_compare(  str_lit("aaa"),     str_lit("bbb")) < 0     );
+    assert(string_compare(  str_lit("bbb"),     str_lit("aaa")) > 0     );
+    assert(string_compare(  str_lit("aaa"),     str_lit("aaa")) == 0    );
+    assert(string_compare(  str_lit("aa"),      str_lit("aaa")) < 0     );
+    assert(string_compare(  str_lit("aa"),      str_lit(""))    > 0     );
+
+    // string_compare_qsort()
+    assert(string_compare_qsort(    &str_lit("aaa"), &str_lit("bbb")) < 0   );
+    assert(string_compare_qsort(    &str_lit("bbb"), &str_lit("aaa")) > 0   );
+    assert(string_compare_qsort(    &str_lit("aaa"), &str_lit("aaa")) == 0  );
+    assert(string_compare_qsort(    &str_lit("aa"),  &str_lit("aaa")) < 0   );
+    assert(string_compare_qsort(    &str_lit("aa"),  &str_lit("")   ) > 0   );
+
+    // string_substr()
+    assert(string_equal(string_substr(  str_lit("hello"), 0, 5),    str_lit("hello"))   );
+    assert(string_equal(string_substr(  str_lit("hello"), 0, 0),    str_lit(""))        );
+    assert(string_equal(string_substr(  str_lit("hello"), -1, 5),   str_lit("o"))       );
+    assert(string_equal(string_substr(  str_lit("hello"), -2, -1),  str_lit("l"))       );
+
+    // string_dup()
+    String dup_str = string_dup(str_lit("hello"));
+    assert(string_equal(dup_str, str_lit("hello")));
+    PMK_FREE(NULL, dup_str.data);
+
+    // string_trim()
+    assert(string_equal(string_trim(str_lit("  good morning \n \t ")), str_lit("good morning")));
+    assert(string_equal(string_trim(str_lit("  ")), str_lit("")));
+
+    // string_char()
+    assert(string_char(str_lit("hello"), 'l') == 2);
+    assert(string_char(str_lit("hello"), 'x') == 5);
+    assert(string_char(str_lit(""), 'x') == 0);
+
+    // string_rchar()
+    assert(string_rchar(str_lit("hello"), 'l') == 3);
+    assert(string_rchar(str_lit("hello"), 'x') == 5);
+    assert(string_rchar(str_lit(""), 'x') == 0);
+
+    // string_span()
+    assert(string_span(     str_lit("good morning"),    str_lit("gdX o"))    == 5   );
+    assert(string_span(     str_lit("good morning"),    str_lit("gn mrodi")) == 12  );
+    assert(string_span(     str_lit("good morning"),    str_lit("XYZ"))      == 0   );
+    assert(string_span(     str_lit("good morning"),    str_lit(""))         == 0   );
+    assert(string_span(     str_lit(""),                str_lit("abc"))      == 0   );
+
+    // string_cspan()
+    assert(string_cspan(    str_lit("good morning"),    str_lit("mr"))      == 5    );
+    assert(string_cspan(    str_lit("good morning"),    str_lit("abc"))     == 12   );
+    assert(string_cspan(    str_lit("good morning"),    str_lit("Xg"))      == 0    );
+    assert(string_cspan(    str_lit("good morning"),    str_lit(""))        == 12   );
+    assert(string_cspan(    str_lit(""),                str_lit("abc"))     == 0    );
+
+    // string_find()
+    assert(string_find(     str_lit("good morning"),    str_lit("morn"))    == 5    );
+    assert(string_find(     str_lit("good morning"),    str_lit("fish"))    == 12   );
+    assert(string_find(     str_lit("good morning"),    str_lit(""))        == 0    );
+    assert(string_find(     str_lit(""),                str_lit("fish"))    == 0    );
+    assert(string_find(     str_lit(""),                str_lit(""))        == 0    );
+
+    // string_break()
+    assert(string_equal(string_break(   str_lit("good morning"),    str_lit("mr")) , str_lit("morning")));
+    assert(string_equal(string_break(   str_lit("good morning"),    str_lit("abc")), str_lit("")));
+    assert(string_equal(string_break(   str_lit("good morning"),    str_lit("Xg")) , str_lit("good morning")));
+    assert(string_equal(string_break(   str_lit("good morning"),    str_lit(""))   , str_lit("")));
+    assert(string_equal(string_break(   str_lit(""),                str_lit("abc")), str_lit("")));
+
+    // string_tokenize()
+    {
+        String input = str_lit("  good \t morning \t ");
+        String delim = str_lit(" \t");
+        s32 save = 0;
+        assert(string_equal(string_tokenize(input, delim, &save), str_lit("good")));
+        assert(string_equal(string_tokenize(input, delim, &save), str_lit("morning")));
+    }
+
+    // string_tr()
+    {
+        char cstring[] = "feet, seen, ten";
+        String string = str_lit(cstring);
+        string_tr(string, 'e', 'o');
+        assert(string_equal(string, str_lit("foot, soon, ton")));
+    }
+
+    // string_toupper(), string_tolower()
+    {
+        char cstring[] = "Good morning";
+        String string = str_lit(cstring);
+        string_toupper(string);
+        assert(string_equal(string, str_lit("GOOD MORNING")));
+        string_tolower(string);
+        assert(string_equal(string, str_lit("good morning")));
     }
 
     // string_count()
@@ -1041,7 +7501,33 @@ pmk_string_test()
         builder_destroy(&builder);
     }
 
-    // TODO: test builder_getline()
+    // builder_getline()
+    {
+        FILE * fp = tmpfile();
+        assert(fp != NULL);
+        for (s32 i = 0; i < 300; i++)
+            fputc('a' + i % 26, fp);
+        fputs("\n\nlast", fp);
+        rewind(fp);
+        StringBuilder builder = {0};
+        assert(builder_getline(&builder, fp) == 0);
+        assert(builder.len == 300 && builder.data[299] == 'a' + 299 % 26);
+        builder.len = 0;
+        assert(builder_getline(&builder, fp) == 0);
+        assert(builder.len == 0 && !feof(fp));
+        assert(builder_getline(&builder, fp) == 0);
+        assert(string_equal(builder_to_string(builder), str_lit("last")));
+        builder.len = 0;
+        assert(builder_getline(&builder, fp) == 0);
+        assert(builder.len == 0 && feof(fp));
+        // lines are appended, and EOF leaves the builder alone
+        builder_append(&builder, str_lit("kept"));
+        assert(builder_getline(&builder, fp) == 0);
+        assert(string_equal(builder_to_string(builder), str_lit("kept")));
+        fclose(fp);
+        builder_destroy(&builder);
+    }
+
     // TODO: test builder_read_file()
 
     // builder_append(), builder_print(), builder_replace() with fixed-sized buffers
@@ -1096,6 +7582,1353 @@ pmk_string_test()
         builder_destroy(&builder);
     }
 
+    // builder_append_int(), builder_consume()
+    {
+        StringBuilder builder = {0};
+        builder_append_int(&builder, 0);
+        builder_append_int(&builder, -42);
+        builder_append_int(&builder, INT64_MIN);
+        assert(string_equal(builder_to_string(builder), str_lit("0-42-9223372036854775808")));
+        builder_consume(&builder, 4);
+        assert(string_equal(builder_to_string(builder), str_lit("-9223372036854775808")));
+        builder_destroy(&builder);
+    }
+
+    // builder_append_resp_*(), string_decode_resp()
+    {
+        StringBuilder rx = {0};
+        builder_append_resp_array(&rx, 2);
+        builder_append_resp_bulk(&rx, str_lit("GET"));
+        builder_append_resp_bulk(&rx, str_lit("key"));
+        builder_append_resp_simple(&rx, str_lit("OK"));
+        builder_append_resp_error(&rx, str_lit("ERR bad"));
+        builder_append_resp_int(&rx, -7);
+        builder_append_resp_null(&rx);
+        assert(string_equal(builder_to_string(rx), str_lit(
+            "*2\r\n$3\r\nGET\r\n$3\r\nkey\r\n+OK\r\n-ERR bad\r\n:-7\r\n$-1\r\n")));
+
+        String buf = builder_to_string(rx);
+        s32 pos = 0;
+        RespValue v, e;
+        assert(string_decode_resp(buf, &pos, &v) == 1);
+        assert(v.type == '*' && v.integer == 2);
+        s32 epos = 0;
+        assert(string_decode_resp(v.string, &epos, &e) == 1);
+        assert(e.type == '$' && string_equal(e.string, str_lit("GET")));
+        assert(string_decode_resp(v.string, &epos, &e) == 1);
+        assert(e.type == '$' && string_equal(e.string, str_lit("key")));
+        assert(epos == v.string.len);
+        assert(string_decode_resp(buf, &pos, &v) == 1);
+        assert(v.type == '+' && string_equal(v.string, str_lit("OK")));
+        assert(string_decode_resp(buf, &pos, &v) == 1);
+        assert(v.type == '-' && string_equal(v.string, str_lit("ERR bad")));
+        assert(string_decode_resp(buf, &pos, &v) == 1);
+        assert(v.type == ':' && v.integer == -7);
+        assert(string_decode_resp(buf, &pos, &v) == 1);
+        assert(v.type == '$' && v.integer == -1);
+        assert(pos == buf.len);
+        assert(string_decode_resp(buf, &pos, &v) == 0);
+
+        // every proper prefix of a message is incomplete
+        String msg = str_lit("*2\r\n*1\r\n:1\r\n$5\r\nhello\r\n");
+        for (s32 len = 0; len < msg.len; len++) {
+            pos = 0;
+            assert(string_decode_resp(string_substr(msg, 0, len), &pos, &v) == 0);
+            assert(pos == 0);
+        }
+        pos = 0;
+        assert(string_decode_resp(msg, &pos, &v) == 1 && pos == msg.len);
+
+        pos = 0;
+        assert(string_decode_resp(str_lit("?what\r\n"), &pos, &v) == -EINVAL);
+        assert(string_decode_resp(str_lit("$3\r\nabcd\r\n"), &pos, &v) == -EINVAL);
+
+        // the full s64 range round-trips, and nothing beyond it is accepted
+        s64 extremes[] = { INT64_MIN, INT64_MAX, 1000000000000000000, 0 };
+        for (s32 i = 0; i < 4; i++) {
+            StringBuilder tx = {0};
+            builder_append_resp_int(&tx, extremes[i]);
+            pos = 0;
+            assert(string_decode_resp(builder_to_string(tx), &pos, &v) == 1);
+            assert(v.type == ':' && v.integer == extremes[i] && pos == tx.len);
+            builder_destroy(&tx);
+        }
+        pos = 0;
+        assert(string_decode_resp(str_lit(":9223372036854775808\r\n"), &pos, &v) == -EINVAL);
+        assert(string_decode_resp(str_lit(":-9223372036854775809\r\n"), &pos, &v) == -EINVAL);
+        assert(string_decode_resp(str_lit(":10000000000000000000\r\n"), &pos, &v) == -EINVAL);
+
+        // consume a batch of messages at once, leaving a partial one behind
+        builder_consume(&rx, buf.len);
+        builder_append(&rx, str_lit("+PONG\r\n+PO"));
+        pos = 0;
+        assert(string_decode_resp(builder_to_string(rx), &pos, &v) == 1);
+        assert(string_decode_resp(builder_to_string(rx), &pos, &v) == 0);
+        builder_consume(&rx, pos);
+        assert(string_equal(builder_to_string(rx), str_lit("+PO")));
+        builder_destroy(&rx);
+    }
+
+    // builder_append_netstring(), string_decode_netstring()
+    // builder_append_frame(), string_decode_frame()
+    {
+        StringBuilder rx = {0};
+        builder_append_netstring(&rx, str_lit("hello world!"));
+        builder_append_netstring(&rx, (String) {0});
+        assert(string_equal(builder_to_string(rx), str_lit("12:hello world!,0:,")));
+        String buf = builder_to_string(rx);
+        String v;
+        s32 pos = 0;
+        assert(string_decode_netstring(buf, &pos, &v) == 1 && string_equal(v, str_lit("hello world!")));
+        assert(string_decode_netstring(buf, &pos, &v) == 1 && v.len == 0);
+        assert(string_decode_netstring(buf, &pos, &v) == 0);
+        pos = 0;
+        assert(string_decode_netstring(str_lit("3:ab"), &pos, &v) == 0);
+        assert(string_decode_netstring(str_lit("3:abcd"), &pos, &v) == -EINVAL);
+        assert(string_decode_netstring(str_lit("03:abc,"), &pos, &v) == -EINVAL);
+
+        rx.len = 0;
+        builder_append_frame(&rx, str_lit("abc"));
+        builder_append_frame(&rx, (String) {0});
+        assert(rx.len == 11);
+        assert(memcmp(rx.data, "\0\0\0\3abc\0\0\0\0", 11) == 0);
+        buf = builder_to_string(rx);
+        pos = 0;
+        assert(string_decode_frame(buf, &pos, &v) == 1 && string_equal(v, str_lit("abc")));
+        assert(string_decode_frame(buf, &pos, &v) == 1 && v.len == 0);
+        assert(string_decode_frame(buf, &pos, &v) == 0);
+        pos = 0;
+        assert(string_decode_frame(string_substr(buf, 0, 6), &pos, &v) == 0);
+        builder_destroy(&rx);
+    }
+
+    // builder_append_varint_u64(), reader_read_varint()
+    {
+        u64 values[] = {
+            0, 1, 127, 128, 300, 16383, 16384, (1ULL << 28) - 1, 1ULL << 28,
+            (1ULL << 49) + 12345, (1ULL << 56) - 1, 1ULL << 56, (1ULL << 63) + 1, UINT64_MAX,
+        };
+        StringBuilder builder = {0};
+        builder_append_varint_u64(&builder, 300);
+        assert(builder.len == 2 && memcmp(builder.data, "\xac\x02", 2) == 0);
+        builder.len = 0;
+        for (s32 i = 0; i < (s32) (sizeof(values)/sizeof(values[0])); i++)
+            builder_append_varint_u64(&builder, values[i]);
+        StringReader reader = reader_from_string(builder_to_string(builder));
+        for (s32 i = 0; i < (s32) (sizeof(values)/sizeof(values[0])); i++) {
+            u64 v;
+            assert(reader_read_varint(&reader, &v) == 0);
+            assert(v == values[i]);
+        }
+        assert(reader.pos == builder.len);
+        u64 v;
+        assert(reader_read_varint(&reader, &v) == -EINVAL);
+
+        reader = reader_from_string(str_lit("\x80\x80"));
+        assert(reader_read_varint(&reader, &v) == -EINVAL && reader.pos == 0);
+        reader = reader_from_string(str_lit("\xff\xff\xff\xff\xff\xff\xff\xff\xff\x02"));
+        assert(reader_read_varint(&reader, &v) == -EINVAL);
+        builder_destroy(&builder);
+    }
+
+    // builder_append_lp_strings(), reader_read_lp_string()
+    {
+        char big[200];
+        memset(big, 'x', sizeof(big));
+        String strings[] = { str_lit("alpha"), str_lit(""), { .data = big, .len = 200 }, str_lit("z") };
+        StringBuilder builder = {0};
+        builder_append_lp_strings(&builder, strings, 4);
+        builder_append_lp_string(&builder, str_lit("tail"));
+        assert(builder.len == 1+5 + 1 + 2+200 + 1+1 + 1+4);
+        StringReader reader = reader_from_string(builder_to_string(builder));
+        String s;
+        for (s32 i = 0; i < 4; i++) {
+            assert(reader_read_lp_string(&reader, &s) == 0);
+            assert(string_equal(s, strings[i]));
+        }
+        assert(reader_read_lp_string(&reader, &s) == 0 && string_equal(s, str_lit("tail")));
+        assert(reader_read_lp_string(&reader, &s) == -EINVAL);
+
+        reader = reader_from_string(str_lit("\x05" "abc"));
+        assert(reader_read_lp_string(&reader, &s) == -EINVAL && reader.pos == 0);
+        builder_destroy(&builder);
+    }
+
+    // string_crc32c(), crc32c_combine(), crc32c_update()
+    {
+        assert(string_crc32c(str_lit("123456789"), 0) == 0xe3069283);
+        assert(string_crc32c(str_lit(""), 0) == 0);
+
+        // long enough to take every path, starting at odd alignments
+        static char buf[3 * 8192 * 2 + 3 * 256 + 100];
+        for (size_t i = 0; i < sizeof(buf); i++)
+            buf[i] = (char) rand();
+        s32 lens[] = { 1, 7, 8, 100, 767, 768, 3 * 256 + 13, 3 * 8192, 3 * 8192 * 2 + 3 * 256 + 90 };
+        for (s32 i = 0; i < (s32) (sizeof(lens)/sizeof(lens[0])); i++) {
+            for (s32 offset = 0; offset < 3; offset++) {
+                String s = { .data = buf + offset, .len = lens[i] };
+                u32 expect = 0xffffffff;
+                for (s32 j = 0; j < s.len; j++) {
+                    expect ^= (u8) s.data[j];
+                    for (s32 k = 0; k < 8; k++)
+                        expect = (expect & 1) ? (expect >> 1) ^ 0x82f63b78 : expect >> 1;
+                }
+                expect = ~expect;
+                assert(string_crc32c(s, 0) == expect);
+
+                s32 split = s.len / 3;
+                String a = string_substr(s, 0, split);
+                String b = string_substr(s, split, s.len);
+                assert(string_crc32c(b, string_crc32c(a, 0)) == expect);
+                assert(crc32c_combine(string_crc32c(a, 0), string_crc32c(b, 0), b.len) == expect);
+            }
+        }
+
+        StringBuilder builder = {0};
+        Crc32c hasher;
+        crc32c_init(&hasher);
+        for (s32 i = 0; i < 3; i++) {
+            builder.len = 0;
+            builder_print(&builder, "chunk %d;", i);
+            crc32c_update(&hasher, builder_to_string(builder));
+        }
+        assert(hasher.len == 24);
+        assert(crc32c_final(&hasher) == string_crc32c(str_lit("chunk 0;chunk 1;chunk 2;"), 0));
+        builder_destroy(&builder);
+    }
+
+    // string_edit_distance(), string_edit_distance_batch()
+    {
+        assert(string_edit_distance(str_lit("kitten"), str_lit("sitting")) == 3);
+        assert(string_edit_distance(str_lit(""), str_lit("abc")) == 3);
+        assert(string_edit_distance(str_lit("abc"), str_lit("")) == 3);
+        assert(string_edit_distance(str_lit("flaw"), str_lit("lawn")) == 2);
+
+        // compare against the O(n*m) dynamic program, crossing the 64 byte
+        // boundary between the single-word and blocked versions
+        static char abuf[150], bbufs[9][150];
+        static s32 row[151];
+        String cands[9];
+        s32 dists[9];
+        for (s32 iter = 0; iter < 200; iter++) {
+            s32 alen = rand() % 150;
+            for (s32 i = 0; i < alen; i++)
+                abuf[i] = 'a' + rand() % 3;
+            String a = { .data = abuf, .len = alen };
+            s32 max_dist = rand() % 40;
+            for (s32 c = 0; c < 9; c++) {
+                s32 blen = (iter % 2) ? rand() % 150 : alen + rand() % 11 - 5;
+                blen = MAX(0, MIN(149, blen));
+                for (s32 i = 0; i < blen; i++)
+                    bbufs[c][i] = 'a' + rand() % 3;
+                cands[c] = (String) { .data = bbufs[c], .len = blen };
+            }
+            s32 within = string_edit_distance_batch(a, cands, 9, max_dist, dists);
+            s32 expect_within = 0;
+            for (s32 c = 0; c < 9; c++) {
+                String b = cands[c];
+                for (s32 j = 0; j <= b.len; j++)
+                    row[j] = j;
+                for (s32 i = 1; i <= a.len; i++) {
+                    s32 diag = row[0];
+                    row[0] = i;
+                    for (s32 j = 1; j <= b.len; j++) {
+                        s32 up = row[j];
+                        s32 best = diag + (a.data[i-1] != b.data[j-1]);
+                        best = MIN(best, up + 1);
+                        best = MIN(best, row[j-1] + 1);
+                        row[j] = best;
+                        diag = up;
+                    }
+                }
+                s32 expect = row[b.len];
+                assert(string_edit_distance(a, b) == expect);
+                assert(string_edit_distance(b, a) == expect);
+                assert(dists[c] == (expect <= max_dist ? expect : max_dist + 1));
+                expect_within += expect <= max_dist;
+            }
+            assert(within == expect_within);
+        }
+    }
+
+    // glob_compile(), glob_match()
+    {
+        GlobPattern g = glob_compile(str_lit("*.log"));
+        assert( glob_match(&g, str_lit("server.log")));
+        assert( glob_match(&g, str_lit(".log")));
+        assert(!glob_match(&g, str_lit("server.log.1")));
+        g = glob_compile(str_lit("app-?? /*/err*"));
+        assert( glob_match(&g, str_lit("app-01 /x/y/error")));
+        assert(!glob_match(&g, str_lit("app-1 /x/error")));
+        g = glob_compile(str_lit("exact"));
+        assert( glob_match(&g, str_lit("exact")));
+        assert(!glob_match(&g, str_lit("exactly")));
+        g = glob_compile(str_lit(""));
+        assert( glob_match(&g, str_lit("")));
+        assert(!glob_match(&g, str_lit("a")));
+        g = glob_compile(str_lit("*"));
+        assert( glob_match(&g, str_lit("")) && glob_match(&g, str_lit("anything")));
+
+        // patterns which make a backtracking matcher exponential
+        static char as[4096];
+        memset(as, 'a', sizeof(as));
+        g = glob_compile(str_lit("*a*a*a*a*a*a*a*a*b"));
+        assert(!glob_match(&g, (String) { .data = as, .len = sizeof(as) }));
+        as[sizeof(as)-1] = 'b';
+        assert( glob_match(&g, (String) { .data = as, .len = sizeof(as) }));
+
+        char pbuf[8], tbuf[10];
+        const char * pchars = "ab*?";
+        for (s32 iter = 0; iter < 20000; iter++) {
+            String p = { .data = pbuf, .len = rand() % 8 };
+            String t = { .data = tbuf, .len = rand() % 10 };
+            for (s32 i = 0; i < p.len; i++)
+                pbuf[i] = pchars[rand() % 4];
+            for (s32 i = 0; i < t.len; i++)
+                tbuf[i] = 'a' + rand() % 2;
+            g = glob_compile(p);
+            assert(glob_match(&g, t) == glob_match_slow(p, t));
+        }
+    }
+
+    // regex_compile(), regex_find()
+    {
+        struct { const char * re; const char * text; s32 start, end; } cases[] = {
+            { "abc",            "xxabcxx",              2, 5 },
+            { "abc",            "xxabxx",              -1, 0 },
+            { "a+",             "baaab",                1, 4 },
+            { "colou?r",        "what colour",          5, 11 },
+            { "x*",             "abc",                  0, 0 },
+            { "^abc",           "abcabc",               0, 3 },
+            { "^abc",           "xabc",                -1, 0 },
+            { "abc$",           "abcabc",               3, 6 },
+            { "^$",             "",                     0, 0 },
+            { "(a|ab)(c|bcd)",  "xabcd",                1, 5 },
+            { "[0-9]+\\.[0-9]+", "v=12.5;",             2, 6 },
+            { "\\d{",           "1{",                   0, 2 },
+            { "[^a-z ]+",       "abc DEF ghi",          4, 7 },
+            { "\\w+@\\w+",      "mail bob@example now", 5, 16 },
+            { "ERROR|WARN",     "2023 WARN disk",       5, 9 },
+            { "a.c",            "a\nc abc",             4, 7 },
+            { "[]a]+",          "x]a]y",                1, 4 },
+            { "\\s+",           "a \t b",               1, 4 },
+        };
+        for (s32 i = 0; i < (s32) (sizeof(cases)/sizeof(cases[0])); i++) {
+            Regex re = regex_compile(str_cstr((char *) cases[i].re));
+            assert(re.error == 0);
+            String match;
+            int found = regex_find(&re, str_cstr((char *) cases[i].text), &match);
+            assert(found == (cases[i].start >= 0));
+            if (found) {
+                assert(match.data - cases[i].text == cases[i].start);
+                assert(match.len == cases[i].end - cases[i].start);
+            }
+            regex_destroy(&re);
+        }
+
+        const char * invalid[] = { "(ab", "ab)", "*a", "a|*", "[ab", "[b-a]", "a\\" };
+        for (s32 i = 0; i < (s32) (sizeof(invalid)/sizeof(invalid[0])); i++) {
+            Regex re = regex_compile(str_cstr((char *) invalid[i]));
+            assert(re.error == -EINVAL);
+            regex_destroy(&re);
+        }
+
+        // the required literal rejects lines without running the DFA
+        Regex re = regex_compile(str_lit("GET /api/v[0-9]+/users"));
+        assert(string_equal((String) { .data = re.literal, .len = re.literal_len }, str_lit("GET /api/v")));
+        regex_destroy(&re);
+
+        // many distinct DFA states force the cache to be flushed mid-scan
+        re = regex_compile(str_lit("a[ab][ab][ab][ab][ab][ab][ab][ab][ab]c"));
+        static char buf[20000];
+        for (size_t i = 0; i < sizeof(buf); i++)
+            buf[i] = "ab"[rand() % 2];
+        memcpy(buf + 15000, "abbbbbbbbbc", 11);
+        String match;
+        assert(regex_find(&re, (String) { .data = buf, .len = sizeof(buf) }, &match));
+        assert(match.data - buf == 15000 && match.len == 11);
+        regex_destroy(&re);
+
+#if defined(__unix__) || defined(__APPLE__)
+        StringBuilder pattern = {0};
+        char text[13];
+        for (s32 iter = 0; iter < 3000; iter++) {
+            pattern.len = 0;
+            gen_random_regex(&pattern, 2, 1);
+            regex_t posix;
+            if (regcomp(&posix, pattern.data, REG_EXTENDED) != 0)
+                continue;
+            re = regex_compile(builder_to_string(pattern));
+            assert(re.error == 0);
+            for (s32 j = 0; j < 10; j++) {
+                s32 len = rand() % 13;
+                for (s32 k = 0; k < len; k++)
+                    text[k] = "ab"[rand() % 2];
+                text[len] = '\0';
+                regmatch_t pm[1];
+                int expect = regexec(&posix, text, 1, pm, 0) == 0;
+                int found = regex_find(&re, (String) { .data = text, .len = len }, &match);
+                assert(found == expect);
+                if (found) {
+                    assert(match.data - text == pm[0].rm_so);
+                    assert(match.data + match.len - text == pm[0].rm_eo);
+                }
+            }
+            regfree(&posix);
+            regex_destroy(&re);
+        }
+        builder_destroy(&pattern);
+#endif
+    }
+
+    // sa_build(), sa_build_lcp(), sa_find_all()
+    {
+        static char text[3000];
+        const char * kinds[] = { "ab", "abc", "a", "acgt" };
+        for (s32 iter = 0; iter < 40; iter++) {
+            s32 n = (iter < 4) ? iter : rand() % (s32) sizeof(text);
+            const char * alphabet = kinds[iter % 4];
+            s32 k = (s32) strlen(alphabet);
+            for (s32 i = 0; i < n; i++)
+                text[i] = (iter % 5 == 0) ? alphabet[i % k] : alphabet[rand() % k];
+            String t = { .data = text, .len = n };
+            SuffixArray sa = sa_build(t);
+            sa_build_lcp(&sa);
+            for (s32 i = 1; i < n; i++) {
+                String a = string_substr(t, sa.sa[i-1], n);
+                String b = string_substr(t, sa.sa[i], n);
+                assert(string_compare(a, b) < 0);
+                s32 l = 0;
+                while (l < a.len && l < b.len && a.data[l] == b.data[l])
+                    l++;
+                assert(sa.lcp[i] == l);
+            }
+            for (s32 q = 0; q < 10 && n > 0; q++) {
+                s32 start = rand() % n;
+                s32 end = start + 1 + rand() % 6;
+                String needle = string_substr(t, start, MIN(n, end));
+                s32 first;
+                s32 count = sa_find_all(&sa, needle, &first);
+                s32 expect = 0;
+                for (s32 i = 0; i + needle.len <= n; i++)
+                    expect += memcmp(text + i, needle.data, needle.len) == 0;
+                assert(count == expect);
+                for (s32 i = first; i < first + count; i++)
+                    assert(string_starts_with(string_substr(t, sa.sa[i], n), needle));
+            }
+            s32 first;
+            assert(sa_find_all(&sa, str_lit("x"), &first) == 0);
+            sa_destroy(&sa);
+        }
+    }
+
+    // trigram_index_build(), trigram_index_find()
+    {
+        static char text[20000];
+        static String docs[2000];
+        static s32 ids[2000];
+        s32 ndocs = 0;
+        for (s32 at = 0; ndocs < (s32) (sizeof(docs)/sizeof(docs[0])); ndocs++) {
+            s32 len = rand() % 10;
+            for (s32 i = 0; i < len; i++)
+                text[at + i] = "abcd"[rand() % 4];
+            docs[ndocs] = (String) { .data = text + at, .len = len };
+            at += len;
+        }
+        TrigramIndex index = trigram_index_build(docs, ndocs);
+        const char * needles[] = { "", "a", "ab", "abc", "dddd", "abcab", "cadbcadb", "zzz" };
+        for (s32 q = 0; q < (s32) (sizeof(needles)/sizeof(needles[0])); q++) {
+            String needle = str_cstr((char *) needles[q]);
+            s32 n = trigram_index_find(&index, needle, ids);
+            s32 expect = 0;
+            for (s32 d = 0; d < ndocs; d++) {
+                if (needle.len == 0 || string_find(docs[d], needle) < docs[d].len) {
+                    assert(expect < n && ids[expect] == d);
+                    expect++;
+                }
+            }
+            assert(n == expect);
+        }
+        trigram_index_destroy(&index);
+    }
+
+    // string_hash()
+    {
+        assert(string_hash(str_lit("")) != string_hash(str_lit("\0")));
+        assert(string_hash(str_lit("\0")) != string_hash(str_lit("\0\0")));
+        assert(string_hash(str_lit("hello, world")) == string_hash(str_cstr((char[]) {"hello, world"})));
+        assert(string_hash(str_lit("hello, world")) != string_hash(str_lit("hello, World")));
+    }
+
+    // string_cdc_chunks(), string_cdc_chunks_hashed()
+    {
+        enum { N = 1 << 18, MIN = 256, AVG = 1024, MAX = 4096 };
+        static char data[N + 100];
+        static String a[N / MIN + 1], b[N / MIN + 2];
+        static u64 ha[N / MIN + 1], hb[N / MIN + 2];
+        for (s32 i = 0; i < N; i++)
+            data[i] = (char) rand();
+
+        // chunk boundaries must not change between versions
+        u64 x = 0;
+        for (s32 i = 0; i < 256; i++) {
+            u64 z = (x += HASH_K1);
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+            assert(gear_table[i] == (z ^ (z >> 31)));
+        }
+
+        assert(string_cdc_chunks(str_lit("x"), 8, 4, 16, a) == -EINVAL);
+        assert(string_cdc_chunks(str_lit(""), MIN, AVG, MAX, a) == 0);
+        assert(string_cdc_chunks(str_lit("short"), MIN, AVG, MAX, a) == 1 && a[0].len == 5);
+
+        s32 na = string_cdc_chunks_hashed((String) { .data = data, .len = N }, MIN, AVG, MAX, a, ha);
+        s32 total = 0;
+        for (s32 i = 0; i < na; i++) {
+            assert(a[i].data == data + total);
+            assert(a[i].len <= MAX && (a[i].len >= MIN || i == na - 1));
+            assert(ha[i] == string_hash(a[i]));
+            total += a[i].len;
+        }
+        assert(total == N);
+        assert(na > N / (2 * AVG) && na < N / (AVG / 2));
+
+        // insert 100 bytes in the middle: only the chunks around it change
+        memmove(data + N / 2 + 100, data + N / 2, N / 2);
+        memset(data + N / 2, 'x', 100);
+        s32 nb = string_cdc_chunks_hashed((String) { .data = data, .len = N + 100 }, MIN, AVG, MAX, b, hb);
+        s32 shared = 0;
+        for (s32 i = 0, j = 0; i < na && j < nb; ) {
+            if (ha[i] == hb[j]) {
+                shared++;
+                i++;
+                j++;
+            } else if (a[i].data - data < b[j].data - data - (b[j].data >= data + N / 2 ? 100 : 0)) {
+                i++;
+            } else {
+                j++;
+            }
+        }
+        assert(shared >= na - 4);
+    }
+
+    // rolling_searcher_build(), rolling_searcher_find()
+    {
+        String bad[] = { str_lit("abc"), str_lit("abcd") };
+        RollingSearcher rs = rolling_searcher_build(bad, 2);
+        assert(rs.error == -EINVAL);
+
+        static char text[4096];
+        static char needle_data[300][6];
+        static String needles[300];
+        for (s32 i = 0; i < (s32) sizeof(text); i++)
+            text[i] = "abcdef"[rand() % 6];
+        for (s32 i = 0; i < 300; i++) {
+            for (s32 j = 0; j < 6; j++)
+                needle_data[i][j] = "abcdef"[rand() % 6];
+            needles[i] = (String) { .data = needle_data[i], .len = 6 };
+        }
+        String haystack = { .data = text, .len = sizeof(text) };
+        rs = rolling_searcher_build(needles, 300);
+        assert(rs.error == 0);
+        for (s32 pos = 0, hits = 0; ; hits++) {
+            s32 id = -1;
+            s32 found = rolling_searcher_find(&rs, haystack, pos, &id);
+            s32 expect = haystack.len;
+            for (s32 i = 0; i < 300; i++) {
+                s32 at = string_find(string_substr(haystack, pos, haystack.len), needles[i]);
+                expect = MIN(expect, pos + at);
+            }
+            assert(found == expect);
+            if (found == haystack.len) {
+                assert(hits > 0);
+                break;
+            }
+            assert(string_equal(needles[id], string_substr(haystack, found, found + 6)));
+            pos = found + 1;
+        }
+        rolling_searcher_destroy(&rs);
+    }
+
+    // builder_compress_into(), builder_decompress_into()
+    {
+        StringBuilder out = {0};
+        assert(builder_decompress_into(&out, str_lit("\x50hello"), 5) == 0);
+        assert(string_equal(builder_to_string(out), str_lit("hello")));
+        out.len = 0;
+        assert(builder_decompress_into(&out, str_lit("\x44" "abcd" "\x04\x00" "\x50" "xxxxx"), 17) == 0);
+        assert(string_equal(builder_to_string(out), str_lit("abcdabcdabcdxxxxx")));
+        out.len = 0;
+        assert(builder_decompress_into(&out, str_lit("\x44" "abcd" "\x04\x00" "\x50" "xxxxx"), 16) == -EINVAL);
+        assert(builder_decompress_into(&out, str_lit("\x44" "abcd" "\x05\x00" "\x50" "xxxxx"), 17) == -EINVAL);
+        assert(builder_decompress_into(&out, str_lit("\x44" "abcd" "\x04\x00"), 12) == -EINVAL);
+        assert(builder_decompress_into(&out, str_lit("\xf0\xff"), 300) == -EINVAL);
+        assert(out.len == 0);
+
+        StringBuilder text = {0}, packed = {0};
+        for (s32 i = 0; i < 2000; i++) {
+            builder_print(&text, "2024-05-01T12:%02d:%02d host%d GET /api/v1/items/%d %d\n",
+                          i / 60 % 60, i % 60, rand() % 4, rand() % 1000, (rand() % 3) ? 200 : 404);
+        }
+        builder_compress_into(&packed, builder_to_string(text));
+        assert(packed.len * 3 < text.len);
+        assert(builder_decompress_into(&out, builder_to_string(packed), text.len) == 0);
+        assert(string_equal(builder_to_string(out), builder_to_string(text)));
+
+        for (s32 iter = 0; iter < 200; iter++) {
+            s32 len = rand() % (iter < 100 ? 40 : 3000);
+            s32 alphabet = 1 + rand() % 8;
+            text.len = packed.len = out.len = 0;
+            for (s32 i = 0; i < len; i++) {
+                char c = (char) ('a' + rand() % alphabet);
+                builder_append(&text, ((String) { .data = &c, .len = 1 }));
+            }
+            builder_compress_into(&packed, builder_to_string(text));
+            assert(packed.len <= len + len / 255 + 16);
+            assert(builder_decompress_into(&out, builder_to_string(packed), len) == 0);
+            assert(string_equal(builder_to_string(out), builder_to_string(text)));
+        }
+        builder_destroy(&text);
+        builder_destroy(&packed);
+        builder_destroy(&out);
+    }
+
+    // fsst_train(), fsst_compress_strings(), builder_append_fsst_decoded()
+    {
+        const char * hosts[] = { "www.example.com", "api.example.org", "cdn.static.net", "mail.example.com" };
+        const char * paths[] = { "/index.html", "/images/logo.png", "/api/v1/users/", "/search?q=" };
+        enum { N = 2000 };
+        static String urls[N];
+        static s32 offsets[N + 1];
+        StringBuilder text = {0}, heap = {0}, out = {0};
+        s32 starts[N + 1];
+        for (s32 i = 0; i < N; i++) {
+            starts[i] = text.len;
+            builder_print(&text, "https://%s%s%d", hosts[rand() % 4], paths[rand() % 4], rand() % 10000);
+        }
+        starts[N] = text.len;
+        for (s32 i = 0; i < N; i++)
+            urls[i] = string_substr(builder_to_string(text), starts[i], starts[i+1]);
+
+        FsstTable * table = fsst_train(urls, N / 10);
+        assert(table->nsymbols > 0 && table->nsymbols <= 255);
+        fsst_compress_strings(table, urls, N, &heap, offsets);
+        assert(heap.len * 2 < text.len);
+        for (s32 i = 0; i < N; i++) {
+            String packed = string_substr(builder_to_string(heap), offsets[i], offsets[i+1]);
+            out.len = 0;
+            assert(builder_append_fsst_decoded(&out, table, packed) == 0);
+            assert(string_equal(builder_to_string(out), urls[i]));
+
+            // equality on the compressed forms
+            s32 j = rand() % N;
+            String other = string_substr(builder_to_string(heap), offsets[j], offsets[j+1]);
+            assert(string_equal(packed, other) == string_equal(urls[i], urls[j]));
+        }
+
+        // bytes outside the sample are escaped
+        out.len = heap.len = 0;
+        builder_append_fsst(&heap, table, str_lit("\xff\x01 example \xfe"));
+        assert(builder_append_fsst_decoded(&out, table, builder_to_string(heap)) == 0);
+        assert(string_equal(builder_to_string(out), str_lit("\xff\x01 example \xfe")));
+        assert(builder_append_fsst_decoded(&out, table, str_lit("\xff")) == -EINVAL);
+        fsst_destroy(table);
+
+        table = fsst_train(NULL, 0);
+        heap.len = out.len = 0;
+        builder_append_fsst(&heap, table, str_lit("abc"));
+        assert(heap.len == 6);
+        assert(builder_append_fsst_decoded(&out, table, builder_to_string(heap)) == 0);
+        assert(string_equal(builder_to_string(out), str_lit("abc")));
+        fsst_destroy(table);
+        builder_destroy(&text);
+        builder_destroy(&heap);
+        builder_destroy(&out);
+    }
+
+    // string_diff_lines(), builder_append_unified_diff()
+    {
+        StringBuilder out = {0};
+        String a = str_lit("one\ntwo\nthree\nfour\nfive\nsix\nseven\neight\nnine\nten\n");
+        String b = str_lit("one\ntwo\nTHREE\nfour\nfive\nsix\nseven\neight\nnine\nten\neleven");
+        builder_append_unified_diff(&out, a, b, 2);
+        assert(string_equal(builder_to_string(out), str_lit(
+            "@@ -1,5 +1,5 @@\n one\n two\n-three\n+THREE\n four\n five\n"
+            "@@ -9,2 +9,3 @@\n nine\n ten\n+eleven\n\\ No newline at end of file\n")));
+        out.len = 0;
+        builder_append_unified_diff(&out, a, a, 3);
+        assert(out.len == 0);
+        builder_append_unified_diff(&out, str_lit(""), str_lit("x\n"), 3);
+        assert(string_equal(builder_to_string(out), str_lit("@@ -0,0 +1 @@\n+x\n")));
+        DiffHunks hunks = {0};
+        assert(string_diff_lines(str_lit("same\nfoo bar\nend"), str_lit("same\nfoo baz bar\nend"), diff_collect, &hunks) == 0);
+        assert(hunks.len == 1);
+        assert(hunks.hunks[0].a_start == 1 && hunks.hunks[0].a_count == 1);
+        assert(hunks.hunks[0].b_start == 1 && hunks.hunks[0].b_count == 1);
+        hunks.len = 0;
+        assert(string_diff_lines(str_lit("x\nend"), str_lit("x\nend\n"), diff_collect, &hunks) == 0);
+        assert(hunks.len == 1 && hunks.hunks[0].a_start == 1 && hunks.hunks[0].a_count == 1 && hunks.hunks[0].b_count == 1);
+        PMK_FREE(NULL, hunks.hunks);
+
+        // random line edits: the hunks turn a into b with a minimal number
+        // of changed lines, checked against the LCS dynamic program
+        static s32 lcs[41][41];
+        StringBuilder sa = {0}, sb = {0}, rebuilt = {0};
+        for (s32 iter = 0; iter < 300; iter++) {
+            s32 na = rand() % 40, nb = rand() % 40, lines_a[40], lines_b[40];
+            sa.len = sb.len = rebuilt.len = 0;
+            for (s32 i = 0; i < na; i++) {
+                lines_a[i] = rand() % 5;
+                builder_print(&sa, "line %d\n", lines_a[i]);
+            }
+            for (s32 i = 0; i < nb; i++) {
+                lines_b[i] = (i < na && rand() % 3) ? lines_a[i] : rand() % 5;
+                builder_print(&sb, "line %d\n", lines_b[i]);
+            }
+            for (s32 i = na; i >= 0; i--) {
+                for (s32 j = nb; j >= 0; j--) {
+                    if (i == na || j == nb)
+                        lcs[i][j] = 0;
+                    else if (lines_a[i] == lines_b[j])
+                        lcs[i][j] = lcs[i+1][j+1] + 1;
+                    else
+                        lcs[i][j] = MAX(lcs[i+1][j], lcs[i][j+1]);
+                }
+            }
+            DiffHunks hunks = {0};
+            assert(string_diff_lines(builder_to_string(sa), builder_to_string(sb), diff_collect, &hunks) == 0);
+            s32 changed = 0, i = 0;
+            for (s32 h = 0; h < hunks.len; h++) {
+                DiffHunk d = hunks.hunks[h];
+                assert(d.a_count + d.b_count > 0 && d.a_start >= i);
+                for (; i < d.a_start; i++)
+                    builder_print(&rebuilt, "line %d\n", lines_a[i]);
+                for (s32 j = d.b_start; j < d.b_start + d.b_count; j++)
+                    builder_print(&rebuilt, "line %d\n", lines_b[j]);
+                i += d.a_count;
+                changed += d.a_count + d.b_count;
+            }
+            for (; i < na; i++)
+                builder_print(&rebuilt, "line %d\n", lines_a[i]);
+            assert(string_equal(builder_to_string(rebuilt), builder_to_string(sb)));
+            assert(changed == na + nb - 2 * lcs[0][0]);
+            PMK_FREE(NULL, hunks.hunks);
+        }
+        builder_destroy(&sa);
+        builder_destroy(&sb);
+        builder_destroy(&rebuilt);
+        builder_destroy(&out);
+    }
+
+    // external_sort_lines()
+    {
+        const char * in_path = "pmk_string_test_sort_in.txt";
+        const char * out_path = "pmk_string_test_sort_out.txt";
+        enum { N = 20000 };
+        static String lines[N];
+        StringBuilder text = {0}, expect = {0}, result = {0};
+        s32 starts[N + 1];
+        for (s32 i = 0; i < N; i++) {
+            starts[i] = text.len;
+            s32 len = rand() % 12;
+            for (s32 j = 0; j < len; j++) {
+                char c = "abcxyz"[rand() % 6];
+                builder_append(&text, ((String) { .data = &c, .len = 1 }));
+            }
+            if (i < N - 1) // the last line has no newline
+                builder_append(&text, str_lit("\n"));
+        }
+        starts[N] = text.len + 1;
+        for (s32 i = 0; i < N; i++)
+            lines[i] = (String) { .data = text.data + starts[i], .len = starts[i+1] - starts[i] - 1 };
+        FILE * fp = fopen(in_path, "w");
+        assert(fp != NULL);
+        fwrite(text.data, 1, text.len, fp);
+        fclose(fp);
+        qsort(lines, N, sizeof(String), string_compare_qsort);
+
+        for (int unique = 0; unique <= 1; unique++) {
+            expect.len = 0;
+            for (s32 i = 0; i < N; i++) {
+                if (!unique || i == 0 || !string_equal(lines[i], lines[i-1])) {
+                    builder_append(&expect, lines[i]);
+                    builder_append(&expect, str_lit("\n"));
+                }
+            }
+            // a large budget sorts in memory; the small ones spill hundreds
+            // of runs, merged in batches and then again at the end
+            s64 budgets[] = { 1 << 24, 2048, 512 };
+            for (s32 b = 0; b < 3; b++) {
+                assert(external_sort_lines(in_path, out_path, budgets[b], 4, unique ? EXTERNAL_SORT_UNIQUE : 0) == 0);
+                result.len = 0;
+                assert(builder_read_file(&result, out_path) == 0);
+                assert(string_equal(builder_to_string(result), builder_to_string(expect)));
+            }
+        }
+        assert(external_sort_lines("pmk_string_test_no_such_file", out_path, 1 << 20, 1, 0) == -ENOENT);
+        // the spilled runs are closed even when the output cannot be opened
+        assert(external_sort_lines(in_path, "pmk_string_test_no_such_dir/out", 2048, 1, 0) == -ENOENT);
+        remove(in_path);
+        remove(out_path);
+        builder_destroy(&text);
+        builder_destroy(&expect);
+        builder_destroy(&result);
+    }
+
+    // string_set_intersect(), string_set_union(), string_set_difference(), string_unique()
+    {
+        static char names[1000][4];
+        static String all[1000], a[1000], b[1000], out[2000];
+        for (s32 i = 0; i < 1000; i++) {
+            sprintf(names[i], "%03d", i);
+            all[i] = (String) { .data = names[i], .len = 3 };
+        }
+        String dups[] = { str_lit("a"), str_lit("a"), str_lit("b"), str_lit("c"), str_lit("c"), str_lit("c") };
+        assert(string_unique(dups, 6) == 3);
+        assert(string_equal(dups[2], str_lit("c")));
+        assert(string_unique(dups, 0) == 0);
+
+        for (s32 iter = 0; iter < 200; iter++) {
+            // skewed densities so that both sides have long runs to skip
+            s32 pa = 1 + rand() % 100, pb = 1 + rand() % 100, na = 0, nb = 0;
+            for (s32 i = 0; i < 1000; i++) {
+                if (rand() % 100 < pa)
+                    a[na++] = all[i];
+                if (rand() % 100 < pb)
+                    b[nb++] = all[i];
+            }
+            s32 in_a = 0, in_b = 0, both = 0;
+            for (s32 i = 0, x = 0, y = 0; i < 1000; i++) {
+                int ia = x < na && a[x].data == all[i].data;
+                int ib = y < nb && b[y].data == all[i].data;
+                x += ia;
+                y += ib;
+                in_a += ia && !ib;
+                in_b += ib && !ia;
+                both += ia && ib;
+            }
+            s32 n = string_set_intersect(a, na, b, nb, out);
+            assert(n == both);
+            for (s32 i = 0; i < n; i++) {
+                assert(i == 0 || string_compare(out[i-1], out[i]) < 0);
+                assert(out[i].data >= names[0] && out[i].data <= names[999]);
+            }
+            n = string_set_union(a, na, b, nb, out);
+            assert(n == in_a + in_b + both);
+            for (s32 i = 1; i < n; i++)
+                assert(string_compare(out[i-1], out[i]) < 0);
+            n = string_set_difference(a, na, b, nb, out);
+            assert(n == in_a);
+            for (s32 i = 0; i < n; i++) {
+                assert(i == 0 || string_compare(out[i-1], out[i]) < 0);
+                s32 k = 0;
+                while (k < nb && !string_equal(b[k], out[i]))
+                    k++;
+                assert(k == nb);
+            }
+        }
+    }
+
+    // CountMinSketch, SpaceSaving, HyperLogLog
+    {
+        // a skewed stream: token i appears about 4000 / (i + 1) times
+        enum { TOKENS = 2000 };
+        static char names[TOKENS][8];
+        static u32 truth[TOKENS];
+        for (s32 i = 0; i < TOKENS; i++) {
+            sprintf(names[i], "t%d", i);
+            truth[i] = 0;
+        }
+        CountMinSketch cms[2] = { cms_create(1024, 4), cms_create(1024, 4) };
+        SpaceSaving ss[2] = { space_saving_create(32), space_saving_create(32) };
+        HyperLogLog hll[2] = { hll_create(12), hll_create(12) };
+        u64 total = 0;
+        for (s32 round = 0; round < 4000; round++) {
+            for (s32 i = 0; i * (round + 1) < 4000 && i < TOKENS; i += 1 + rand() % 3) {
+                String token = str_cstr(names[i]);
+                u64 h = string_hash(token);
+                s32 half = rand() % 2;
+                cms_add_hash(&cms[half], h, 1);
+                space_saving_add_hash(&ss[half], token, h, 1);
+                hll_add_hash(&hll[half], h);
+                truth[i]++;
+                total++;
+            }
+        }
+        assert(cms_merge(&cms[0], &cms[1]) == 0);
+        assert(space_saving_merge(&ss[0], &ss[1]) == 0);
+        assert(hll_merge(&hll[0], &hll[1]) == 0);
+        assert(cms[0].total == total);
+
+        s32 distinct = 0;
+        for (s32 i = 0; i < TOKENS; i++) {
+            u32 estimate = cms_estimate(&cms[0], str_cstr(names[i]));
+            assert(estimate >= truth[i] && estimate <= truth[i] + total / 256);
+            distinct += truth[i] > 0;
+        }
+        double count = hll_count(&hll[0]);
+        assert(count > 0.9 * distinct && count < 1.1 * distinct);
+
+        HeavyHitter top[32];
+        s32 n = space_saving_top(&ss[0], top, 32);
+        assert(n == 32);
+        for (s32 i = 0; i < n; i++) {
+            s32 id = atoi(top[i].key.data + 1);
+            assert(top[i].count >= truth[id] && top[i].count - top[i].error <= truth[id]);
+            assert(i == 0 || top[i].count <= top[i-1].count);
+        }
+        // the frequent tokens are all there
+        for (s32 i = 0; i < TOKENS; i++) {
+            if (truth[i] <= 2 * total / 32)
+                continue;
+            s32 j = 0;
+            while (j < n && !string_equal(top[j].key, str_cstr(names[i])))
+                j++;
+            assert(j < n);
+        }
+
+        HyperLogLog small = hll_create(10);
+        assert(hll_count(&small) == 0);
+        for (s32 i = 0; i < 10; i++)
+            hll_add(&small, str_cstr(names[i]));
+        assert(hll_count(&small) > 9 && hll_count(&small) < 11);
+        assert(hll_merge(&small, &hll[0]) == -EINVAL);
+        hll_destroy(&small);
+
+        for (s32 i = 0; i < 2; i++) {
+            cms_destroy(&cms[i]);
+            space_saving_destroy(&ss[i]);
+            hll_destroy(&hll[i]);
+        }
+    }
+
+    // string_filter_build(), string_filter_contains(), string_filter_view()
+    {
+        enum { N = 10000, PROBES = 50000 };
+        static char names[N][8], others[16];
+        static String keys[N];
+        for (s32 i = 0; i < N; i++) {
+            sprintf(names[i], "k%d", i);
+            keys[i] = str_cstr(names[i]);
+        }
+        StringBuilder blob = {0};
+        for (int kind = STRING_FILTER_BLOOM; kind <= STRING_FILTER_XOR; kind++) {
+            StringFilter filter = string_filter_build(kind, keys, N, 10);
+            assert(filter.error == 0);
+            blob.len = 0;
+            builder_append_string_filter(&blob, &filter);
+            StringFilter view;
+            assert(string_filter_view(builder_to_string(blob), &view) == 0);
+            for (s32 i = 0; i < N; i++) {
+                assert(string_filter_contains(&filter, keys[i]));
+                assert(string_filter_contains(&view, keys[i]));
+            }
+            s32 false_positives = 0;
+            for (s32 i = 0; i < PROBES; i++) {
+                sprintf(others, "x%d", i);
+                int hit = string_filter_contains(&filter, str_cstr(others));
+                assert(hit == string_filter_contains(&view, str_cstr(others)));
+                false_positives += hit;
+            }
+            assert(false_positives < PROBES / (kind == STRING_FILTER_BLOOM ? 50 : 100));
+
+            blob.data[0] = 'X';
+            assert(string_filter_view(builder_to_string(blob), &view) == -EINVAL);
+            blob.data[0] = 'P';
+            blob.len--;
+            assert(string_filter_view(builder_to_string(blob), &view) == -EINVAL);
+            string_filter_destroy(&filter);
+
+            // duplicates and tiny sets
+            String few[] = { str_lit("a"), str_lit("b"), str_lit("a") };
+            for (s32 n = 0; n <= 3; n++) {
+                filter = string_filter_build(kind, few, n, 10);
+                assert(filter.error == 0);
+                for (s32 i = 0; i < n; i++)
+                    assert(string_filter_contains(&filter, few[i]));
+                string_filter_destroy(&filter);
+            }
+        }
+        builder_destroy(&blob);
+    }
+
+    // radix_insert(), radix_find(), radix_longest_prefix()
+    {
+        RadixTree tree = {0};
+        assert(radix_find(&tree, str_lit("")) == -1);
+        assert(radix_longest_prefix(&tree, str_lit("/a"), NULL) == -1);
+
+        char * routes[] = { "/", "/api", "/api/users", "/api/users/", "/api/user", "/static/", "/a\0b" };
+        for (s32 i = 0; i < (s32) (sizeof(routes) / sizeof(routes[0])); i++)
+            assert(radix_insert(&tree, str_cstr(routes[i]), i) == 1);
+        assert(radix_insert(&tree, ((String) { .data = "/a\0b", .len = 4 }), 7) == 1);
+        assert(radix_insert(&tree, str_lit("/api"), 10) == 0);
+        assert(tree.count == 8);
+
+        assert(radix_find(&tree, str_lit("/api")) == 10);
+        assert(radix_find(&tree, str_lit("/api/user")) == 4);
+        assert(radix_find(&tree, str_lit("/api/users/")) == 3);
+        assert(radix_find(&tree, str_lit("/ap")) == -1);
+        assert(radix_find(&tree, str_lit("/api/usersx")) == -1);
+        assert(radix_find(&tree, str_lit("")) == -1);
+        assert(radix_find(&tree, (String) { .data = "/a\0b", .len = 4 }) == 7);
+
+        s32 len = -1;
+        assert(radix_longest_prefix(&tree, str_lit("/api/users/42"), &len) == 3 && len == 11);
+        assert(radix_longest_prefix(&tree, str_lit("/api/users"), &len) == 2 && len == 10);
+        assert(radix_longest_prefix(&tree, str_lit("/api/use"), &len) == 10 && len == 4);
+        assert(radix_longest_prefix(&tree, str_lit("/static/css/x.css"), &len) == 5 && len == 8);
+        assert(radix_longest_prefix(&tree, str_lit("/static"), &len) == 0 && len == 1);
+        assert(radix_longest_prefix(&tree, str_lit("x"), &len) == -1 && len == 0);
+        radix_destroy(&tree);
+        assert(tree.root == NULL && tree.count == 0);
+
+        // against a brute force scan, with node growth up to 256 children
+        enum { N = 3000, Q = 5000 };
+        static char keys[N][8], query[12];
+        static s32 lens[N];
+        for (s32 i = 0; i < N; i++) {
+            s32 n = lens[i] = 1 + rand() % 6;
+            for (s32 j = 0; j < n; j++)
+                keys[i][j] = (j == 0 && i % 2) ? (char) (rand() % 256) : "abc"[rand() % 3];
+            radix_insert(&tree, ((String) { .data = keys[i], .len = n }), i);
+        }
+        for (s32 q = 0; q < Q; q++) {
+            s32 n = rand() % 10;
+            for (s32 j = 0; j < n; j++)
+                query[j] = (j == 0 && q % 4 == 0) ? (char) (rand() % 256) : "abc"[rand() % 3];
+            String s = { .data = query, .len = n };
+            s32 exact = -1, best = -1, best_len = 0;
+            for (s32 i = 0; i < N; i++) {
+                // the last insert of a key wins
+                String k = { .data = keys[i], .len = lens[i] };
+                if (string_equal(k, s))
+                    exact = i;
+                if (k.len <= s.len && memcmp(k.data, s.data, k.len) == 0 && k.len >= best_len)
+                    best = i, best_len = k.len;
+            }
+            assert(radix_find(&tree, s) == exact);
+            assert(radix_longest_prefix(&tree, s, &len) == best && len == best_len);
+        }
+        radix_destroy(&tree);
+
+        // every prefix of a long run of one byte is a key: one node per level
+        enum { DEPTH = 4000 };
+        static char run[DEPTH];
+        memset(run, 'x', DEPTH);
+        for (s32 i = 1; i <= DEPTH; i++)
+            radix_insert(&tree, ((String) { .data = run, .len = i }), i);
+        assert(radix_find(&tree, ((String) { .data = run, .len = DEPTH })) == DEPTH);
+        radix_destroy(&tree);
+    }
+
+    // counter_add(), counter_get(), counter_merge(), counter_top_k()
+    {
+        StringCounter counter = counter_create(0);
+        String text = str_lit("the cat and the dog and the bird saw a catalogue of the dogs");
+        s32 save = 0;
+        for (String word; (word = string_tokenize(text, str_lit(" "), &save)).len > 0; )
+            counter_add(&counter, word, 1);
+        counter_add(&counter, str_lit(""), 2);
+        assert(counter.len == 11 && counter.total == 16);
+        assert(counter_get(&counter, str_lit("the")) == 4);
+        assert(counter_get(&counter, str_lit("and")) == 2);
+        assert(counter_get(&counter, str_lit("catalogue")) == 1);
+        assert(counter_get(&counter, str_lit("cats")) == 0);
+        assert(counter_get(&counter, str_lit("")) == 2);
+
+        HeavyHitter top[16];
+        assert(counter_top_k(&counter, top, 3) == 3);
+        assert(string_equal(top[0].key, str_lit("the")) && top[0].count == 4);
+        assert(string_equal(top[1].key, str_lit("")) && top[1].count == 2);
+        assert(string_equal(top[2].key, str_lit("and")) && top[2].count == 2);
+        assert(counter_top_k(&counter, top, 16) == 11);
+        assert(string_equal(top[10].key, str_lit("saw")));
+        assert(counter_top_k(&counter, top, 0) == 0);
+        counter_destroy(&counter);
+
+        // growth, merging, and selection against a full sort
+        enum { N = 20000, KEYS = 3000 };
+        static char names[KEYS][24];
+        static u64 expected[KEYS];
+        StringCounter parts[2] = { counter_create(16), counter_create(16) };
+        for (s32 i = 0; i < KEYS; i++)
+            sprintf(names[i], i % 2 ? "key%d" : "a-much-longer-key-%d", i);
+        for (s32 i = 0; i < N; i++) {
+            s32 k = (rand() % KEYS) * (rand() % KEYS) / KEYS;
+            counter_add(&parts[i % 2], str_cstr(names[k]), 1);
+            expected[k]++;
+        }
+        counter_merge(&parts[0], &parts[1]);
+        assert(parts[0].total == N);
+        for (s32 i = 0; i < KEYS; i++)
+            assert(counter_get(&parts[0], str_cstr(names[i])) == expected[i]);
+        static HeavyHitter all[KEYS], some[100];
+        s32 n = counter_top_k(&parts[0], all, KEYS);
+        assert(n == parts[0].len);
+        for (s32 k = 1; k <= 100; k += 33) {
+            assert(counter_top_k(&parts[0], some, k) == k);
+            for (s32 i = 0; i < k; i++)
+                assert(string_equal(some[i].key, all[i].key) && some[i].count == all[i].count);
+        }
+        counter_destroy(&parts[0]);
+        counter_destroy(&parts[1]);
+    }
+
+    // column_filter_len(), column_filter_prefix(), column_equal_const(), bitmap_to_indices()
+    {
+        enum { N = 1000 };
+        static char bytes[N][12];
+        static String strings[N];
+        static u64 bitmap[(N + 63) / 64];
+        static s32 indices[N];
+        StringColumn column = {0};
+        for (s32 i = 0; i < N; i++) {
+            s32 n = rand() % 10;
+            for (s32 j = 0; j < n; j++)
+                bytes[i][j] = "ab\0"[rand() % 3];
+            strings[i] = (String) { .data = bytes[i], .len = n };
+            column_append(&column, strings[i]);
+        }
+        for (s32 i = 0; i < N; i++)
+            assert(string_equal(column_get(&column, i), strings[i]));
+
+        for (s32 trial = 0; trial < 200; trial++) {
+            s32 a = rand() % 10, b = rand() % 10;
+            String probe = strings[rand() % N];
+            probe.len -= rand() % (probe.len + 1) * (trial % 2);
+            for (s32 kind = 0; kind < 3; kind++) {
+                s32 n = kind == 0 ? column_filter_len(&column, a, b, bitmap) :
+                        kind == 1 ? column_filter_prefix(&column, probe, bitmap) :
+                                    column_equal_const(&column, probe, bitmap);
+                s32 expected = 0;
+                for (s32 i = 0; i < N; i++) {
+                    String x = strings[i];
+                    int hit = kind == 0 ? x.len >= a && x.len <= b :
+                              kind == 1 ? string_starts_with(x, probe) :
+                                          string_equal(x, probe);
+                    assert(!!(bitmap[i / 64] & ((u64) 1 << (i % 64))) == hit);
+                    expected += hit;
+                }
+                assert(n == expected);
+                assert(bitmap_to_indices(bitmap, N, indices) == n);
+                for (s32 i = 1; i < n; i++)
+                    assert(indices[i - 1] < indices[i]);
+            }
+        }
+        assert((bitmap[N / 64] >> (N % 64)) == 0);
+        column_destroy(&column);
+        assert(column_filter_len(&column, 0, 10, bitmap) == 0);
+    }
+
+    // dict_append(), dict_decode(), dict_sort(), dict_filter_equal(), dict_filter_range(),
+    // dict_group_counts(), dict_sort_rows()
+    {
+        enum { N = 2000 };
+        const char * regions[] = { "us-west", "eu-central", "ap-south", "us-east", "", "eu-west" };
+        static s32 picks[N], rows[N];
+        static u64 bitmap[(N + 63) / 64], counts[8];
+        DictColumn column = {0};
+        for (s32 i = 0; i < N; i++) {
+            picks[i] = rand() % 6;
+            dict_append(&column, str_cstr((char *) regions[picks[i]]));
+        }
+        assert(column.count == N && column.ndict == 6 && column.code_size == 2);
+        assert(!column.sorted);
+        assert(dict_filter_range(&column, str_lit("a"), str_lit("z"), bitmap) == -EINVAL);
+        assert(dict_lookup(&column, str_lit("mars")) == -1);
+
+        for (s32 pass = 0; pass < 2; pass++) {
+            for (s32 i = 0; i < N; i++)
+                assert(string_equal(dict_decode(&column, dict_code(&column, i)), str_cstr((char *) regions[picks[i]])));
+            s32 expected = 0;
+            for (s32 i = 0; i < N; i++)
+                expected += picks[i] == 3;
+            assert(dict_filter_equal(&column, str_lit("us-east"), bitmap) == expected);
+            for (s32 i = 0; i < N; i++)
+                assert(!!(bitmap[i / 64] & ((u64) 1 << (i % 64))) == (picks[i] == 3));
+            assert(dict_filter_equal(&column, str_lit("us-north"), bitmap) == 0);
+            dict_group_counts(&column, counts);
+            assert(counts[dict_lookup(&column, str_lit("us-east"))] == (u64) expected);
+
+            dict_sort_rows(&column, rows);
+            for (s32 i = 1; i < N; i++) {
+                u32 a = dict_code(&column, rows[i - 1]), b = dict_code(&column, rows[i]);
+                assert(a < b || (a == b && rows[i - 1] < rows[i]));
+                if (pass == 1)
+                    assert(string_compare(dict_decode(&column, a), dict_decode(&column, b)) <= 0);
+            }
+            dict_sort(&column);
+            assert(column.sorted);
+        }
+
+        s32 n = dict_filter_range(&column, str_lit("eu"), str_lit("us-east"), bitmap);
+        s32 expected = 0;
+        for (s32 i = 0; i < N; i++) {
+            int hit = picks[i] == 1 || picks[i] == 3 || picks[i] == 5;
+            assert(!!(bitmap[i / 64] & ((u64) 1 << (i % 64))) == hit);
+            expected += hit;
+        }
+        assert(n == expected);
+        assert(dict_filter_range(&column, str_lit("x"), str_lit("y"), bitmap) == 0);
+        dict_append(&column, str_lit("zz"));
+        assert(column.sorted);
+        dict_append(&column, str_lit("b"));
+        assert(!column.sorted);
+        dict_destroy(&column);
+
+        // codes widen past 65536 values
+        char name[16];
+        for (s32 i = 0; i < 70000; i++) {
+            sprintf(name, "v%d", i % 66000);
+            assert(dict_append(&column, str_cstr(name)) == (u32) (i % 66000));
+        }
+        assert(column.code_size == 4 && column.ndict == 66000);
+        assert(string_equal(dict_decode(&column, dict_code(&column, 69999)), str_lit("v3999")));
+        assert(dict_code(&column, 100) == 100);
+        dict_destroy(&column);
+    }
+
+    // builder_append_sort_key()
+    {
+        StringBuilder key = {0};
+        builder_append_sort_key(&key, str_lit("File007-B.txt"), SORT_KEY_FOLD_CASE | SORT_KEY_NATURAL);
+        assert(string_equal(builder_to_string(key), str_lit("file0\0017-b.txt")));
+        key.len = 0;
+        builder_append_sort_key(&key, str_lit("File007"), 0);
+        assert(string_equal(builder_to_string(key), str_lit("File007")));
+        key.len = 0;
+        builder_append_sort_key(&key, str_lit("x000"), SORT_KEY_NATURAL);
+        assert(key.len == 3 && memcmp(key.data, "x0\0", 3) == 0);
+
+        // against a comparator that parses digit runs on every comparison
+        enum { N = 300 };
+        static char bytes[N][12];
+        static String strings[N];
+        static StringBuilder keys[N];
+        const char * alphabet = "aAbB00123999-. ";
+        for (s32 i = 0; i < N; i++) {
+            s32 n = rand() % 12;
+            for (s32 j = 0; j < n; j++)
+                bytes[i][j] = alphabet[rand() % 15];
+            strings[i] = (String) { .data = bytes[i], .len = n };
+            builder_append_sort_key(&keys[i], strings[i], SORT_KEY_FOLD_CASE | SORT_KEY_NATURAL);
+        }
+        for (s32 a = 0; a < N; a++) {
+            for (s32 b = 0; b < N; b++) {
+                String x = strings[a], y = strings[b];
+                s32 i = 0, j = 0, expected = 0;
+                while (expected == 0 && i < x.len && j < y.len) {
+                    if (isdigit((u8) x.data[i]) && isdigit((u8) y.data[j])) {
+                        s32 xe = i, ye = j;
+                        while (xe < x.len && isdigit((u8) x.data[xe])) xe++;
+                        while (ye < y.len && isdigit((u8) y.data[ye])) ye++;
+                        while (i < xe && x.data[i] == '0') i++;
+                        while (j < ye && y.data[j] == '0') j++;
+                        expected = (xe - i) - (ye - j);
+                        if (expected == 0)
+                            expected = memcmp(x.data + i, y.data + j, xe - i);
+                        i = xe;
+                        j = ye;
+                    } else {
+                        u8 c = isdigit((u8) x.data[i]) ? '0' : (u8) tolower((u8) x.data[i]);
+                        u8 d = isdigit((u8) y.data[j]) ? '0' : (u8) tolower((u8) y.data[j]);
+                        expected = c - d;
+                        i++;
+                        j++;
+                    }
+                }
+                if (expected == 0)
+                    expected = (i < x.len) - (j < y.len);
+                s32 got = string_compare(builder_to_string(keys[a]), builder_to_string(keys[b]));
+                assert((got > 0) - (got < 0) == (expected > 0) - (expected < 0));
+            }
+        }
+        for (s32 i = 0; i < N; i++)
+            builder_destroy(&keys[i]);
+
+        // long digit runs take a 4-byte length
+        char digits[300];
+        memset(digits, '7', sizeof(digits));
+        key.len = 0;
+        builder_append_sort_key(&key, ((String) { .data = digits, .len = 300 }), SORT_KEY_NATURAL);
+        assert(key.len == 306 && (u8) key.data[1] == 0xff && (u8) key.data[4] == 1 && (u8) key.data[5] == 44);
+        builder_destroy(&key);
+    }
+
+    // string_hash_batch(), and string_hash() of every tail length
+    {
+        enum { N = 200 };
+        static char bytes[N][48];
+        static String keys[N];
+        static u64 hashes[N];
+        for (s32 i = 0; i < N; i++) {
+            for (s32 j = 0; j < 48; j++)
+                bytes[i][j] = (char) rand();
+            keys[i] = (String) { .data = bytes[i], .len = i % 48 };
+        }
+        string_hash_batch(keys, N, hashes);
+        for (s32 i = 0; i < N; i++) {
+            // string_hash() pads the tail with zeros
+            u64 h = HASH_K2 ^ (u64) keys[i].len * HASH_K1;
+            for (s32 j = 0; j < keys[i].len; j += 8) {
+                u8 word[8] = {0};
+                memcpy(word, keys[i].data + j, MIN(8, keys[i].len - j));
+                h = rotl64(h ^ load_u64_le(word) * HASH_K2, 31) * HASH_K1;
+            }
+            assert(hashes[i] == hash_fmix64(h));
+            assert(hashes[i] == string_hash(keys[i]));
+        }
+        string_hash_batch(keys, 0, hashes);
+    }
+
+    // string_set_build(), string_find_in_set()
+    {
+        String words[] = {
+            str_lit("the"), str_lit("of"), str_lit("and"), str_lit("a"), str_lit("to"),
+            str_lit("in"), str_lit("is"), str_lit(""), str_lit("was"), str_lit("and"),
+        };
+        StringSet set = string_set_build(words, 10);
+        assert(string_find_in_set(&set, str_lit("the")) == 0);
+        assert(string_find_in_set(&set, str_lit("and")) == 2);
+        assert(string_find_in_set(&set, str_lit("a")) == 3);
+        assert(string_find_in_set(&set, str_lit("")) == 7);
+        assert(string_find_in_set(&set, str_lit("th")) == -1);
+        assert(string_find_in_set(&set, str_lit("them")) == -1);
+        assert(string_find_in_set(&set, str_lit("was\0")) == -1);
+        string_set_destroy(&set);
+
+        set = string_set_build(NULL, 0);
+        assert(string_find_in_set(&set, str_lit("")) == -1);
+        assert(string_find_in_set(&set, str_lit("x")) == -1);
+        string_set_destroy(&set);
+
+        // against a linear scan, with more than 32 values of one length
+        enum { N = 100 };
+        static char bytes[N][4], probe[4];
+        static String values[N];
+        for (s32 i = 0; i < N; i++) {
+            s32 n = 1 + rand() % 3;
+            for (s32 j = 0; j < n; j++)
+                bytes[i][j] = "ab\0\xff"[rand() % 4];
+            values[i] = (String) { .data = bytes[i], .len = n };
+        }
+        set = string_set_build(values, N);
+        for (s32 trial = 0; trial < 2000; trial++) {
+            s32 n = rand() % 5;
+            for (s32 j = 0; j < n; j++)
+                probe[j] = "ab\0\xff"[rand() % 4];
+            String key = { .data = probe, .len = n };
+            s32 expected = -1;
+            for (s32 i = N - 1; i >= 0; i--) {
+                if (string_equal(values[i], key))
+                    expected = i;
+            }
+            assert(string_find_in_set(&set, key) == expected);
+        }
+        string_set_destroy(&set);
+    }
+
     // TODO: do more random testing
 
     // string_equal(), string_equaln(), string_compare()